@@ -0,0 +1,270 @@
+/**
+ * @file bench_decoder.cpp
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the benchmark of the telemetry decoder. It decodes the traffic of the six units (the data
+ * frames, the full resolution records and a profiler report) either from memory, or from a SocketCAN interface
+ * (eg. vcan0) where it can be generated by a second instance.
+ * Usage:
+ *   bench_decoder                      - decode the traffic from memory
+ *   bench_decoder -i <ifname> [s]      - receive and decode from the interface for the given time (default 10 s)
+ *   bench_decoder -g <ifname> [s]      - send the traffic to the interface as fast as it accepts it (default 10 s)
+ * A virtual interface is set up with: ip link add dev vcan0 type vcan && ip link set up vcan0
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <errno.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/can/raw.h>
+
+#include "hyper_can_decoder.hpp"
+#include "hyper_can_testframes.hpp"
+
+using namespace hyper;
+
+typedef std::chrono::steady_clock Clock;
+
+static const std::size_t BATCH = 64;		/**< The amount of frames received with a single recvmmsg() call */
+
+/**
+ * @brief Visitor that only counts the decoded frames
+ */
+struct Counter : DecoderVisitor {
+	template<typename T>
+	void onData(uint8_t, const T &) { data++; }
+	template<typename T>
+	void onRecord(uint8_t, const T &) { records++; }
+	void onProfile(uint8_t, const HYPER_Profile_Report_t &) { profiles++; }
+	void onOther(const can_frame &) { other++; }
+
+	uint64_t data = 0;
+	uint64_t records = 0;
+	uint64_t profiles = 0;
+	uint64_t other = 0;
+};
+
+/**
+ * @brief This function builds a single publish period of the pod's traffic: a data frame and a record of each unit
+ * and a SYNC frame, with a profiler report every tenth period
+ * @param period The period number (used for the sequence numbers and the payload)
+ * @param frames The output, the frames are appended
+ */
+static void makeTraffic(uint32_t period, std::vector<can_frame> &frames) {
+	uint8_t sequence = period;
+
+	unit1_DataBuffer_t unit1;
+	std::memset(&unit1, 0, sizeof(unit1));
+	unit1.vl6180xDistance1 = period;
+	frames.push_back(makeFrame(CAN_ID_DATA_OUT_UNIT1, unit1));
+	unit2_DataBuffer_t unit2;
+	std::memset(&unit2, 0, sizeof(unit2));
+	frames.push_back(makeFrame(CAN_ID_DATA_OUT_UNIT1 + 1, unit2));
+	unit3_DataBuffer_t unit3;
+	unit3.stripesCounter = period;
+	unit3.encoderPos = period;
+	frames.push_back(makeFrame(CAN_ID_DATA_OUT_UNIT1 + 2, unit3));
+	frames.push_back(makeFrame(CAN_ID_DATA_OUT_UNIT1 + 3, unit3));
+	unit5_DataBuffer_t unit5;
+	std::memset(&unit5, 0, sizeof(unit5));
+	frames.push_back(makeFrame(CAN_ID_DATA_OUT_UNIT1 + 4, unit5));
+	unit6_DataBuffer_t unit6;
+	unit6.brakesState = period & 1;
+	frames.push_back(makeFrame(CAN_ID_DATA_OUT_UNIT1 + 5, unit6));
+
+	unit1_Record_t record1;
+	unit2_Record_t record2;
+	unit3_Record_t record3;
+	unit5_Record_t record5;
+	unit6_Record_t record6;
+	std::memset(&record1, 0, sizeof(record1));
+	std::memset(&record2, 0, sizeof(record2));
+	std::memset(&record3, 0, sizeof(record3));
+	std::memset(&record5, 0, sizeof(record5));
+	std::memset(&record6, 0, sizeof(record6));
+	makeSegments(CAN_ID_RECORD_UNIT1, sequence, &record1, sizeof(record1), frames);
+	makeSegments(CAN_ID_RECORD_UNIT1 + 1, sequence, &record2, sizeof(record2), frames);
+	makeSegments(CAN_ID_RECORD_UNIT1 + 2, sequence, &record3, sizeof(record3), frames);
+	makeSegments(CAN_ID_RECORD_UNIT1 + 3, sequence, &record3, sizeof(record3), frames);
+	makeSegments(CAN_ID_RECORD_UNIT1 + 4, sequence, &record5, sizeof(record5), frames);
+	makeSegments(CAN_ID_RECORD_UNIT1 + 5, sequence, &record6, sizeof(record6), frames);
+
+	if(period % 10 == 0) {
+		HYPER_Profile_Report_t report;
+		std::memset(&report, 0, sizeof(report));
+		makeSegments(CAN_ID_PROFILE_UNIT1 + period / 10 % UNITS, sequence, &report, sizeof(report), frames);
+	}
+
+	frames.push_back(makeFrame(HYPER_CAN_ID_SYNC, sequence));
+}
+
+/**
+ * @brief This function prints the results of a run
+ */
+static void report(const char *mode, uint64_t frames, double seconds, const Counter &counter, const Decoder &decoder) {
+	uint64_t dropped = 0;
+	for(uint8_t unit = 1; unit <= UNITS; unit++)
+		dropped += decoder.reassembler(unit).droppedCount();
+	std::printf("%s: %llu frames in %.3f s, %.0f frames/s, %.1f ns/frame\n", mode, (unsigned long long)frames, seconds,
+		frames / seconds, frames ? seconds * 1e9 / frames : 0.0);
+	std::printf("  data %llu, records %llu, profiles %llu, other %llu, dropped transfers %llu\n",
+		(unsigned long long)counter.data, (unsigned long long)counter.records, (unsigned long long)counter.profiles,
+		(unsigned long long)counter.other, (unsigned long long)dropped);
+}
+
+/**
+ * @brief This function runs the decoder over the traffic kept in memory
+ */
+static int benchMemory() {
+	std::vector<can_frame> frames;
+	for(uint32_t period = 0; period < 1000; period++)
+		makeTraffic(period, frames);
+
+	Decoder decoder;
+	Counter counter;
+	const int rounds = 200;
+	Clock::time_point start = Clock::now();
+	for(int round = 0; round < rounds; round++)
+		decoder.decodeBatch(frames.data(), frames.size(), counter);
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	report("memory", (uint64_t)frames.size() * rounds, seconds, counter, decoder);
+	return 0;
+}
+
+/**
+ * @brief This function opens a raw CAN socket bound to the given interface
+ * @return The socket, -1 on error
+ */
+static int openSocket(const char *ifname) {
+	int s = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+	if(s < 0) {
+		std::perror("socket");
+		return -1;
+	}
+
+	struct ifreq ifr;
+	std::memset(&ifr, 0, sizeof(ifr));
+	std::strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+	if(ioctl(s, SIOCGIFINDEX, &ifr) < 0) {
+		std::perror(ifname);
+		close(s);
+		return -1;
+	}
+
+	struct sockaddr_can addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.can_family = AF_CAN;
+	addr.can_ifindex = ifr.ifr_ifindex;
+	if(bind(s, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+		std::perror("bind");
+		close(s);
+		return -1;
+	}
+	return s;
+}
+
+/**
+ * @brief This function receives the frames from the interface in batches and decodes them
+ */
+static int benchReceive(const char *ifname, double duration) {
+	int s = openSocket(ifname);
+	if(s < 0)
+		return 1;
+
+	// Wake up periodically to check the run time even if the bus is idle
+	struct timeval timeout = {0, 100000};
+	setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	can_frame frames[BATCH];
+	struct iovec iov[BATCH];
+	struct mmsghdr msgs[BATCH];
+	std::memset(msgs, 0, sizeof(msgs));
+	for(std::size_t i = 0; i < BATCH; i++) {
+		iov[i].iov_base = &frames[i];
+		iov[i].iov_len = sizeof(frames[i]);
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	Decoder decoder;
+	Counter counter;
+	uint64_t received = 0, calls = 0;
+	Clock::time_point start = Clock::now();
+	double seconds = 0;
+	while(seconds < duration) {
+		int count = recvmmsg(s, msgs, BATCH, 0, nullptr);
+		if(count < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+			std::perror("recvmmsg");
+			close(s);
+			return 1;
+		}
+		if(count > 0) {
+			decoder.decodeBatch(frames, count, counter);
+			received += count;
+			calls++;
+		}
+		seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	}
+	close(s);
+
+	report(ifname, received, seconds, counter, decoder);
+	std::printf("  %.1f frames per recvmmsg() call\n", calls ? (double)received / calls : 0.0);
+	return 0;
+}
+
+/**
+ * @brief This function sends the traffic to the interface, waiting whenever the interface queue is full
+ */
+static int generate(const char *ifname, double duration) {
+	int s = openSocket(ifname);
+	if(s < 0)
+		return 1;
+
+	uint64_t sent = 0;
+	uint32_t period = 0;
+	std::vector<can_frame> frames;
+	Clock::time_point start = Clock::now();
+	double seconds = 0;
+	while(seconds < duration) {
+		frames.clear();
+		makeTraffic(period++, frames);
+		for(const can_frame &frame : frames) {
+			while(write(s, &frame, sizeof(frame)) != sizeof(frame)) {
+				if(errno != ENOBUFS && errno != EINTR) {
+					std::perror("write");
+					close(s);
+					return 1;
+				}
+				usleep(100);
+			}
+			sent++;
+		}
+		seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	}
+	close(s);
+
+	std::printf("%s: %llu frames sent in %.3f s, %.0f frames/s\n", ifname, (unsigned long long)sent, seconds, sent / seconds);
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	if(argc == 1)
+		return benchMemory();
+
+	if(argc >= 3 && (!std::strcmp(argv[1], "-i") || !std::strcmp(argv[1], "-g"))) {
+		double duration = argc > 3 ? std::atof(argv[3]) : 10.0;
+		return argv[1][1] == 'i' ? benchReceive(argv[2], duration) : generate(argv[2], duration);
+	}
+
+	std::fprintf(stderr, "usage: %s [-i <ifname> [seconds] | -g <ifname> [seconds]]\n", argv[0]);
+	return 1;
+}
@@ -0,0 +1,216 @@
+/**
+ * @file hyper_can_decoder.hpp
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the central node (host) side decoder of the units' telemetry frames, built from the same
+ * structure definitions as the units' firmware (hyper_can_frames.h). Intended for Linux SocketCAN (struct can_frame).
+ */
+
+#ifndef HOSTSRC_HYPER_CAN_DECODER_HPP_
+#define HOSTSRC_HYPER_CAN_DECODER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <linux/can.h>
+
+extern "C" {
+#include "../SharedSrc/hyper_can_frames.h"
+}
+
+#include "hyper_can_reassembler.hpp"
+
+namespace hyper {
+
+static const uint32_t CAN_ID_DATA_OUT_UNIT1 = 60;	/**< UNIT_CAN_ID_DATA_OUT of UNIT1, the next units follow (@see hyper_unit_defs.h) */
+static const uint32_t CAN_ID_RECORD_UNIT1 = 70;		/**< UNIT_CAN_ID_RECORD of UNIT1, the next units follow (@see hyper_unit_defs.h) */
+static const uint32_t CAN_ID_PROFILE_UNIT1 = 80;	/**< UNIT_CAN_ID_PROFILE of UNIT1, the next units follow (@see hyper_unit_defs.h) */
+static const uint8_t UNITS = 6;						/**< The amount of the units */
+
+// The firmware (ARM) and the host (x86/ARM Linux) use the same little-endian bitfield layout, the sizes have to match too
+static_assert(sizeof(unit1_DataBuffer_t) == 8, "unit1_DataBuffer_t must fill a single frame");
+static_assert(sizeof(unit2_DataBuffer_t) == 8, "unit2_DataBuffer_t must fill a single frame");
+static_assert(sizeof(unit3_DataBuffer_t) == 8, "unit3_DataBuffer_t must fill a single frame");
+static_assert(sizeof(unit5_DataBuffer_t) == 8, "unit5_DataBuffer_t must fill a single frame");
+static_assert(sizeof(unit6_DataBuffer_t) == 1, "unit6_DataBuffer_t must be a single byte");
+
+/**
+ * @brief This function gives a typed, zero-copy view of a frame's payload. The structures are packed (alignment 1),
+ * so any payload address is valid.
+ * @param frame The received frame
+ * @return Pointer to the payload as the given structure, nullptr if the frame is too short
+ */
+template<typename T>
+inline const T *view(const can_frame &frame) {
+	static_assert(sizeof(T) <= CAN_MAX_DLEN, "the structure doesn't fit in a single frame");
+	if(frame.can_dlc < sizeof(T))
+		return nullptr;
+	return reinterpret_cast<const T *>(frame.data);
+}
+
+/**
+ * @brief Base class for the decoder visitors, override the handlers of interest (they are resolved at compile time).
+ * The derived class has to bring the remaining overloads into scope (using DecoderVisitor::onData; using DecoderVisitor::onRecord;).
+ */
+struct DecoderVisitor {
+	void onData(uint8_t, const unit1_DataBuffer_t &) {}			/**< UNIT1 data frame */
+	void onData(uint8_t, const unit2_DataBuffer_t &) {}			/**< UNIT2 data frame */
+	void onData(uint8_t, const unit3_DataBuffer_t &) {}			/**< UNIT3/UNIT4 data frame (the unit number tells them apart) */
+	void onData(uint8_t, const unit5_DataBuffer_t &) {}			/**< UNIT5 data frame */
+	void onData(uint8_t, const unit6_DataBuffer_t &) {}			/**< UNIT6 data frame */
+	void onRecord(uint8_t, const unit1_Record_t &) {}			/**< UNIT1 full resolution record */
+	void onRecord(uint8_t, const unit2_Record_t &) {}			/**< UNIT2 full resolution record */
+	void onRecord(uint8_t, const unit3_Record_t &) {}			/**< UNIT3/UNIT4 full resolution record */
+	void onRecord(uint8_t, const unit5_Record_t &) {}			/**< UNIT5 full resolution record */
+	void onRecord(uint8_t, const unit6_Record_t &) {}			/**< UNIT6 full resolution record */
+	void onProfile(uint8_t, const HYPER_Profile_Report_t &) {}	/**< Profiler report (answer to DIAG_PROFILE) */
+	void onOther(const can_frame &) {}							/**< Any other frame (errors, diagnostics, commands) */
+};
+
+/**
+ * @brief Decodes the units' data frames and full resolution records. Keeps the record reassembly state, so a single
+ * instance should see all the frames received from the bus.
+ */
+class Decoder {
+public:
+	/**
+	 * @brief This function decodes a single frame and passes the result to the visitor
+	 * @param frame The received frame
+	 * @param visitor The visitor (@see DecoderVisitor)
+	 * @return true if the frame was a data frame or completed a record or a profiler report, false otherwise
+	 */
+	template<typename Visitor>
+	bool decode(const can_frame &frame, Visitor &visitor) {
+		// Extended, RTR and error frames are never telemetry
+		if(frame.can_id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) {
+			visitor.onOther(frame);
+			return false;
+		}
+
+		uint32_t id = frame.can_id & CAN_SFF_MASK;
+		if(id >= CAN_ID_DATA_OUT_UNIT1 && id < CAN_ID_DATA_OUT_UNIT1 + UNITS)
+			return decodeData(id - CAN_ID_DATA_OUT_UNIT1 + 1, frame, visitor);
+		if(id >= CAN_ID_RECORD_UNIT1 && id < CAN_ID_RECORD_UNIT1 + UNITS)
+			return decodeRecord(id - CAN_ID_RECORD_UNIT1 + 1, frame, visitor);
+		if(id >= CAN_ID_PROFILE_UNIT1 && id < CAN_ID_PROFILE_UNIT1 + UNITS)
+			return decodeProfile(id - CAN_ID_PROFILE_UNIT1 + 1, frame, visitor);
+
+		visitor.onOther(frame);
+		return false;
+	}
+
+	/**
+	 * @brief This function decodes a whole receive buffer (eg. filled by recvmmsg() or read from a candump log)
+	 * @param frames Pointer to the frames
+	 * @param count The amount of frames
+	 * @param visitor The visitor (@see DecoderVisitor)
+	 * @return The amount of decoded data frames and records
+	 */
+	template<typename Visitor>
+	std::size_t decodeBatch(const can_frame *frames, std::size_t count, Visitor &visitor) {
+		std::size_t decoded = 0;
+		for(std::size_t i = 0; i < count; i++)
+			decoded += decode(frames[i], visitor);
+		return decoded;
+	}
+
+	/**
+	 * @brief This function returns the record reassembler of the given unit (for its statistics)
+	 * @param unit The unit number (1..6)
+	 * @return The reassembler
+	 */
+	const SegmentReassembler &reassembler(uint8_t unit) const {
+		return reassemblers[unit - 1];
+	}
+
+private:
+	/**
+	 * @brief This function decodes a data frame
+	 * @param unit The unit number (1..6)
+	 * @param frame The received frame
+	 * @param visitor The visitor
+	 * @return true if the frame was long enough, false otherwise
+	 */
+	template<typename Visitor>
+	bool decodeData(uint8_t unit, const can_frame &frame, Visitor &visitor) {
+		switch(unit) {
+		case 1: return dispatchData<unit1_DataBuffer_t>(unit, frame, visitor);
+		case 2: return dispatchData<unit2_DataBuffer_t>(unit, frame, visitor);
+		case 3:
+		case 4: return dispatchData<unit3_DataBuffer_t>(unit, frame, visitor);
+		case 5: return dispatchData<unit5_DataBuffer_t>(unit, frame, visitor);
+		default: return dispatchData<unit6_DataBuffer_t>(unit, frame, visitor);
+		}
+	}
+
+	/**
+	 * @brief This function passes a typed view of the data frame to the visitor
+	 */
+	template<typename T, typename Visitor>
+	bool dispatchData(uint8_t unit, const can_frame &frame, Visitor &visitor) {
+		const T *data = view<T>(frame);
+		if(data == nullptr)
+			return false;
+		visitor.onData(unit, *data);
+		return true;
+	}
+
+	/**
+	 * @brief This function feeds a record segment to the unit's reassembler
+	 * @param unit The unit number (1..6)
+	 * @param frame The received frame
+	 * @param visitor The visitor
+	 * @return true if the frame completed a record, false otherwise
+	 */
+	template<typename Visitor>
+	bool decodeRecord(uint8_t unit, const can_frame &frame, Visitor &visitor) {
+		SegmentReassembler &reassembler = reassemblers[unit - 1];
+		if(reassembler.push(frame.data, frame.can_dlc) != SegmentReassembler::COMPLETE)
+			return false;
+
+		switch(unit) {
+		case 1: return dispatchRecord<unit1_Record_t>(unit, reassembler, visitor);
+		case 2: return dispatchRecord<unit2_Record_t>(unit, reassembler, visitor);
+		case 3:
+		case 4: return dispatchRecord<unit3_Record_t>(unit, reassembler, visitor);
+		case 5: return dispatchRecord<unit5_Record_t>(unit, reassembler, visitor);
+		default: return dispatchRecord<unit6_Record_t>(unit, reassembler, visitor);
+		}
+	}
+
+	/**
+	 * @brief This function passes a typed view of the reassembled record to the visitor
+	 */
+	template<typename T, typename Visitor>
+	bool dispatchRecord(uint8_t unit, const SegmentReassembler &reassembler, Visitor &visitor) {
+		if(reassembler.size() != sizeof(T))
+			return false;
+		visitor.onRecord(unit, *reinterpret_cast<const T *>(reassembler.data()));
+		return true;
+	}
+
+	/**
+	 * @brief This function feeds a profiler report segment to the unit's reassembler
+	 * @param unit The unit number (1..6)
+	 * @param frame The received frame
+	 * @param visitor The visitor
+	 * @return true if the frame completed a report, false otherwise
+	 */
+	template<typename Visitor>
+	bool decodeProfile(uint8_t unit, const can_frame &frame, Visitor &visitor) {
+		SegmentReassembler &reassembler = profileReassemblers[unit - 1];
+		if(reassembler.push(frame.data, frame.can_dlc) != SegmentReassembler::COMPLETE)
+			return false;
+		if(reassembler.size() != sizeof(HYPER_Profile_Report_t))
+			return false;
+		visitor.onProfile(unit, *reinterpret_cast<const HYPER_Profile_Report_t *>(reassembler.data()));
+		return true;
+	}
+
+	SegmentReassembler reassemblers[UNITS];			/**< Record reassembly state of each unit */
+	SegmentReassembler profileReassemblers[UNITS];	/**< Profiler report reassembly state of each unit */
+};
+
+} // namespace hyper
+
+#endif /* HOSTSRC_HYPER_CAN_DECODER_HPP_ */
@@ -0,0 +1,130 @@
+/**
+ * @file hyper_can_reassembler.hpp
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the central node (host) side reassembler of the segmented CAN transfers (full resolution records)
+ */
+
+#ifndef HOSTSRC_HYPER_CAN_REASSEMBLER_HPP_
+#define HOSTSRC_HYPER_CAN_REASSEMBLER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+extern "C" {
+#include "../SharedSrc/hyper_can_frames.h"
+}
+
+namespace hyper {
+
+/**
+ * @brief Reassembles the segmented transfers received with a single CAN ID (one instance per UNIT_CAN_ID_RECORD).
+ * Transfers with a missing, repeated or reordered segment are dropped as a whole.
+ */
+class SegmentReassembler {
+public:
+	/**
+	 * @brief The result of feeding a single frame to the reassembler
+	 */
+	enum Result {
+		INCOMPLETE,		/**< The frame was accepted, more segments are expected */
+		COMPLETE,		/**< The frame completed a transfer, it is available through data() and size() */
+		DROPPED			/**< The frame broke the current transfer (or was malformed), the partial data was discarded */
+	};
+
+	static const std::size_t CAPACITY = HYPER_SEGMENT_MAX * HYPER_SEGMENT_PAYLOAD; /**< The maximum size of a transfer */
+
+	SegmentReassembler() : length(0), expected(0), sequence(0), active(false), completed(0), dropped(0) {}
+
+	/**
+	 * @brief This function feeds a received frame to the reassembler
+	 * @param frame_data Pointer to the frame's data bytes
+	 * @param frame_dlc The amount of data bytes in the frame
+	 * @return @see Result
+	 */
+	Result push(const uint8_t *frame_data, uint8_t frame_dlc) {
+		if(frame_dlc < 1 || frame_dlc > 1 + HYPER_SEGMENT_PAYLOAD)
+			return drop();
+
+		uint8_t header = frame_data[0];
+		uint8_t index = header & HYPER_SEGMENT_INDEX_MASK;
+		uint8_t seq = (header >> HYPER_SEGMENT_SEQ_SHIFT) & HYPER_SEGMENT_SEQ_MASK;
+
+		if(index == 0) {
+			// A new transfer starts, an unfinished one is lost
+			if(active)
+				dropped++;
+			active = true;
+			sequence = seq;
+			expected = 0;
+			length = 0;
+		}
+		else if(!active || seq != sequence || index != expected) {
+			return drop();
+		}
+
+		// Every segment but the last one carries a full payload
+		uint8_t payload = frame_dlc - 1;
+		bool last = header & HYPER_SEGMENT_LAST;
+		if(!last && payload != HYPER_SEGMENT_PAYLOAD)
+			return drop();
+
+		std::memcpy(buffer + length, frame_data + 1, payload);
+		length += payload;
+		expected++;
+
+		if(last) {
+			active = false;
+			completed++;
+			return COMPLETE;
+		}
+		if(expected == HYPER_SEGMENT_MAX)
+			return drop();
+
+		return INCOMPLETE;
+	}
+
+	/**
+	 * @brief This function decodes the latest complete transfer as a record structure
+	 * @param record Output structure (eg. unit2_Record_t)
+	 * @return true if the transfer size matches the structure, false otherwise
+	 */
+	template<typename Record>
+	bool get(Record &record) const {
+		if(active || length != sizeof(Record))
+			return false;
+		std::memcpy(&record, buffer, sizeof(Record));
+		return true;
+	}
+
+	const uint8_t *data() const { return buffer; }			/**< The latest complete transfer */
+	std::size_t size() const { return active ? 0 : length; }	/**< The size of the latest complete transfer */
+	uint32_t completedCount() const { return completed; }	/**< The amount of the transfers received so far */
+	uint32_t droppedCount() const { return dropped; }		/**< The amount of the transfers lost so far */
+
+private:
+	/**
+	 * @brief This function discards the current transfer
+	 * @return DROPPED
+	 */
+	Result drop() {
+		if(active)
+			dropped++;
+		active = false;
+		length = 0;
+		return DROPPED;
+	}
+
+	uint8_t buffer[CAPACITY];	/**< The reassembled data */
+	std::size_t length;			/**< The amount of bytes in buffer */
+	uint8_t expected;			/**< The index of the next expected segment */
+	uint8_t sequence;			/**< The sequence number of the current transfer */
+	bool active;				/**< A transfer is in progress */
+	uint32_t completed;			/**< The amount of the completed transfers */
+	uint32_t dropped;			/**< The amount of the dropped transfers */
+};
+
+} // namespace hyper
+
+#endif /* HOSTSRC_HYPER_CAN_REASSEMBLER_HPP_ */
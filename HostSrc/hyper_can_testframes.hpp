@@ -0,0 +1,96 @@
+/**
+ * @file hyper_can_testframes.hpp
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the host side frame builders and the check helpers used by the tests and benchmarks. The
+ * frames are built the same way the units' firmware does (HYPER_CAN_SendData(), HYPER_CAN_SendSegmented()).
+ */
+
+#ifndef HOSTSRC_HYPER_CAN_TESTFRAMES_HPP_
+#define HOSTSRC_HYPER_CAN_TESTFRAMES_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <linux/can.h>
+
+extern "C" {
+#include "../SharedSrc/hyper_can_frames.h"
+}
+
+namespace hyper {
+
+/**
+ * @brief The amount of failed checks of the test program
+ */
+static int checkFailures = 0;
+
+/**
+ * @brief Checks a condition, a failure is reported and counted (the test goes on)
+ */
+#define CHECK(cond) do { if(!(cond)) { std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); hyper::checkFailures++; } } while(0)
+
+/**
+ * @brief This function reports the result of a test program
+ * @param name The test's name
+ * @return The program's exit code (0 if all the checks passed, 1 otherwise)
+ */
+inline int checkResult(const char *name) {
+	if(checkFailures) {
+		std::printf("%s: %d check(s) failed\n", name, checkFailures);
+		return 1;
+	}
+	std::printf("%s: OK\n", name);
+	return 0;
+}
+
+/**
+ * @brief This function builds a single data frame
+ * @param id The frame's ID
+ * @param data The payload (up to 8 bytes)
+ * @return The frame
+ */
+template<typename T>
+inline can_frame makeFrame(uint32_t id, const T &data) {
+	static_assert(sizeof(T) <= CAN_MAX_DLEN, "the structure doesn't fit in a single frame");
+	can_frame frame;
+	std::memset(&frame, 0, sizeof(frame));
+	frame.can_id = id;
+	frame.can_dlc = sizeof(T);
+	std::memcpy(frame.data, &data, sizeof(T));
+	return frame;
+}
+
+/**
+ * @brief This function splits a block of data into the segments of a single transfer
+ * @param id The frames' ID
+ * @param sequence The transfer sequence number
+ * @param data Pointer to the data
+ * @param length The amount of data bytes (up to HYPER_SEGMENT_MAX * HYPER_SEGMENT_PAYLOAD)
+ * @param frames The output, the segments are appended
+ */
+inline void makeSegments(uint32_t id, uint8_t sequence, const void *data, std::size_t length, std::vector<can_frame> &frames) {
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+	std::size_t count = (length + HYPER_SEGMENT_PAYLOAD - 1) / HYPER_SEGMENT_PAYLOAD;
+	if(count == 0)
+		count = 1;
+	for(std::size_t index = 0; index < count; index++) {
+		std::size_t offset = index * HYPER_SEGMENT_PAYLOAD;
+		std::size_t payload = (length - offset > HYPER_SEGMENT_PAYLOAD) ? HYPER_SEGMENT_PAYLOAD : length - offset;
+		can_frame frame;
+		std::memset(&frame, 0, sizeof(frame));
+		frame.can_id = id;
+		frame.data[0] = ((sequence & HYPER_SEGMENT_SEQ_MASK) << HYPER_SEGMENT_SEQ_SHIFT) | index;
+		if(index == count - 1)
+			frame.data[0] |= HYPER_SEGMENT_LAST;
+		std::memcpy(frame.data + 1, bytes + offset, payload);
+		frame.can_dlc = 1 + payload;
+		frames.push_back(frame);
+	}
+}
+
+} // namespace hyper
+
+#endif /* HOSTSRC_HYPER_CAN_TESTFRAMES_HPP_ */
@@ -0,0 +1,17 @@
+/**
+ * @file stm32f10x.h
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file stands in for the device header when the units' platform independent modules are built on the host
+ * (simulations and tests). There are no interrupts on the host, so masking them does nothing.
+ */
+
+#ifndef HOSTSRC_STUBS_STM32F10X_H_
+#define HOSTSRC_STUBS_STM32F10X_H_
+
+#include <stdint.h>
+
+#define __disable_irq()		do {} while(0)
+#define __enable_irq()		do {} while(0)
+
+#endif /* HOSTSRC_STUBS_STM32F10X_H_ */
@@ -0,0 +1,161 @@
+/**
+ * @file sync_sim.cpp
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the host simulation of the pod time synchronization. Six units, each with its own clock
+ * offset and oscillator drift, run the firmware's clock servo (SharedSrc/hyper_sync.c, built once per unit) on SYNC and
+ * FOLLOW-UP messages with a jittered reception latency and lost follow-ups. It checks that every unit locks, that its
+ * drift compensation matches its oscillator's drift and that the units agree on the pod time, and reports the convergence
+ * time and the residual spread.
+ * Usage: sync_sim [sync period in ms] [simulated time in s]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <random>
+
+#include "stm32f10x.h"
+extern "C" {
+#include "hyper_settings.h"
+#include "hyper_utils.h"
+#include "hyper_sync.h"
+}
+
+/**
+ * @brief The local time returned to the servo by HYPER_Delay_GetMicros() (the clock of the unit being run)
+ */
+static uint32_t currentMicros = 0;
+
+extern "C" uint32_t HYPER_Delay_GetMicros(void) {
+	return currentMicros;
+}
+
+// Each unit gets its own copy of the servo and its state
+namespace unit1 {
+#include "hyper_sync.c"
+}
+namespace unit2 {
+#include "hyper_sync.c"
+}
+namespace unit3 {
+#include "hyper_sync.c"
+}
+namespace unit4 {
+#include "hyper_sync.c"
+}
+namespace unit5 {
+#include "hyper_sync.c"
+}
+namespace unit6 {
+#include "hyper_sync.c"
+}
+
+/**
+ * @brief The servo entry points of a unit
+ */
+struct Servo {
+	void (*capture)(uint8_t, uint32_t);
+	void (*followUp)(uint8_t, uint32_t);
+	uint32_t (*toPodTime)(uint32_t);
+	void (*getStats)(HYPER_Sync_Stats_t *);
+};
+
+#define SERVO(ns) {ns::HYPER_Sync_Capture, ns::HYPER_Sync_FollowUp, ns::HYPER_Sync_ToPodTime, ns::HYPER_Sync_GetStats}
+
+static const Servo servos[] = {SERVO(unit1), SERVO(unit2), SERVO(unit3), SERVO(unit4), SERVO(unit5), SERVO(unit6)};
+static const int UNITS = sizeof(servos) / sizeof(servos[0]);
+
+/**
+ * @brief A simulated unit clock: local = offset + t * (1 + drift)
+ */
+struct Clock {
+	double offset;		/**< Local time at t = 0 (in us) */
+	double drift;		/**< Frequency error (fraction) */
+
+	uint32_t local(double t) const {
+		return (uint32_t)(int64_t)std::floor(offset + t * (1.0 + drift));
+	}
+};
+
+int main(int argc, char **argv) {
+	const double period = (argc > 1 ? std::atof(argv[1]) : 100.0) * 1000.0;
+	const double duration = (argc > 2 ? std::atof(argv[2]) : 60.0) * 1e6;
+	const double latency = 30.0;		// SYNC reception latency, the same on all the units (in us)
+	const double jitter = 10.0;			// Interrupt entry jitter (in us)
+	const double followUpLoss = 0.02;	// Probability of a lost FOLLOW-UP
+	const double rateTolerance = 2000.0;	// The allowed drift compensation error (in ppb)
+
+	std::mt19937 rng(12345);
+	std::uniform_real_distribution<double> offsetDist(0.0, 4e9);
+	std::uniform_real_distribution<double> driftDist(-100e-6, 100e-6);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+	Clock clocks[UNITS];
+	for(int i = 0; i < UNITS; i++)
+		clocks[i] = Clock{offsetDist(rng), driftDist(rng)};
+
+	// The lock time: the first SYNC after which the unit stayed within the lock threshold
+	double lockTime[UNITS];
+	for(int i = 0; i < UNITS; i++)
+		lockTime[i] = -1.0;
+
+	double maxSpread = 0.0;
+	double settle = duration / 2;
+	uint8_t sequence = 0;
+
+	// The central node's clock is the pod time
+	for(double t = period; t < duration; t += period, sequence++) {
+		uint32_t master = (uint32_t)(int64_t)t;
+
+		for(int i = 0; i < UNITS; i++) {
+			double rx = t + latency + jitter * unit(rng);
+			servos[i].capture(sequence, clocks[i].local(rx));
+		}
+		for(int i = 0; i < UNITS; i++) {
+			if(unit(rng) < followUpLoss)
+				continue;
+			servos[i].followUp(sequence, master);
+		}
+
+		// Compare the units' pod time half way to the next SYNC (the units run behind by the common reception latency)
+		double probe = t + period / 2;
+		double podMin = 1e18, podMax = -1e18;
+		for(int i = 0; i < UNITS; i++) {
+			currentMicros = clocks[i].local(probe);
+			double error = (int32_t)(servos[i].toPodTime(currentMicros) - (uint32_t)(int64_t)probe) + latency;
+			if(error < podMin)
+				podMin = error;
+			if(error > podMax)
+				podMax = error;
+
+			bool locked = std::fabs(error) < HYPER_SYNC_LOCK_THRESHOLD;
+			if(!locked)
+				lockTime[i] = -1.0;
+			else if(lockTime[i] < 0)
+				lockTime[i] = t;
+		}
+		if(t >= settle && podMax - podMin > maxSpread)
+			maxSpread = podMax - podMin;
+	}
+
+	bool ok = true;
+	std::printf("sync period %.0f ms, %.0f s simulated, %d units\n", period / 1000, duration / 1e6, UNITS);
+	for(int i = 0; i < UNITS; i++) {
+		HYPER_Sync_Stats_t stats;
+		servos[i].getStats(&stats);
+		double expected = -clocks[i].drift / (1.0 + clocks[i].drift) * 1e9;
+		std::printf("unit %d: drift %+7.1f ppm, compensation %+9ld ppb (expected %+9.0f), locked after %6.2f s, steps %u, missed %u\n",
+			i + 1, clocks[i].drift * 1e6, (long)stats.rate, expected, lockTime[i] / 1e6, stats.steps, stats.missed);
+		if(lockTime[i] < 0 || lockTime[i] > settle || std::fabs(stats.rate - expected) > rateTolerance)
+			ok = false;
+	}
+	std::printf("drift compensation tolerance: %.0f ppb\n", rateTolerance);
+	std::printf("pod time spread between the units after %.0f s: %.1f us max\n", settle / 1e6, maxSpread);
+	if(maxSpread > HYPER_SYNC_LOCK_THRESHOLD)
+		ok = false;
+
+	std::printf("sync_sim: %s\n", ok ? "OK" : "FAILED");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+/**
+ * @file test_decoder.cpp
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the host tests of the telemetry decoder: the data frames and records of each unit,
+ * the profiler reports, the frames that aren't telemetry and a record broken by a lost segment
+ */
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "hyper_can_decoder.hpp"
+#include "hyper_can_testframes.hpp"
+
+using namespace hyper;
+
+/**
+ * @brief Visitor that keeps the latest decoded frame of each kind
+ */
+struct Recorder : DecoderVisitor {
+	using DecoderVisitor::onData;
+	using DecoderVisitor::onRecord;
+
+	void onData(uint8_t unit, const unit1_DataBuffer_t &data) { dataUnit = unit; unit1Data = data; dataCount++; }
+	void onData(uint8_t unit, const unit3_DataBuffer_t &data) { dataUnit = unit; unit3Data = data; dataCount++; }
+	void onData(uint8_t unit, const unit6_DataBuffer_t &data) { dataUnit = unit; unit6Data = data; dataCount++; }
+	void onRecord(uint8_t unit, const unit1_Record_t &record) { recordUnit = unit; unit1Record = record; recordCount++; }
+	void onRecord(uint8_t unit, const unit2_Record_t &record) { recordUnit = unit; unit2Record = record; recordCount++; }
+	void onProfile(uint8_t unit, const HYPER_Profile_Report_t &report) { profileUnit = unit; profile = report; profileCount++; }
+	void onOther(const can_frame &) { otherCount++; }
+
+	uint8_t dataUnit = 0;
+	uint8_t recordUnit = 0;
+	uint8_t profileUnit = 0;
+	int dataCount = 0;
+	int recordCount = 0;
+	int profileCount = 0;
+	int otherCount = 0;
+	unit1_DataBuffer_t unit1Data;
+	unit3_DataBuffer_t unit3Data;
+	unit6_DataBuffer_t unit6Data;
+	unit1_Record_t unit1Record;
+	unit2_Record_t unit2Record;
+	HYPER_Profile_Report_t profile;
+};
+
+static void testDataFrames() {
+	Decoder decoder;
+	Recorder recorder;
+
+	unit1_DataBuffer_t unit1;
+	std::memset(&unit1, 0, sizeof(unit1));
+	unit1.vl6180xDistance1 = 11;
+	unit1.vl6180xDistance4 = 44;
+	unit1.pitotPressure = -1234;
+	unit1.tmp102Tmperature = 21;
+	CHECK(decoder.decode(makeFrame(CAN_ID_DATA_OUT_UNIT1, unit1), recorder));
+	CHECK(recorder.dataUnit == 1);
+	CHECK(recorder.unit1Data.vl6180xDistance1 == 11);
+	CHECK(recorder.unit1Data.vl6180xDistance4 == 44);
+	CHECK(recorder.unit1Data.pitotPressure == -1234);
+	CHECK(recorder.unit1Data.tmp102Tmperature == 21);
+
+	// Units 3 and 4 share the structure, the unit number tells them apart
+	unit3_DataBuffer_t unit4;
+	unit4.stripesCounter = 123456;
+	unit4.encoderPos = -789;
+	CHECK(decoder.decode(makeFrame(CAN_ID_DATA_OUT_UNIT1 + 3, unit4), recorder));
+	CHECK(recorder.dataUnit == 4);
+	CHECK(recorder.unit3Data.stripesCounter == 123456);
+	CHECK(recorder.unit3Data.encoderPos == -789);
+
+	unit6_DataBuffer_t unit6;
+	unit6.brakesState = 1;
+	CHECK(decoder.decode(makeFrame(CAN_ID_DATA_OUT_UNIT1 + 5, unit6), recorder));
+	CHECK(recorder.dataUnit == 6);
+	CHECK(recorder.unit6Data.brakesState == 1);
+
+	// A truncated data frame is rejected
+	can_frame truncated = makeFrame(CAN_ID_DATA_OUT_UNIT1, unit1);
+	truncated.can_dlc = 4;
+	int before = recorder.dataCount;
+	CHECK(!decoder.decode(truncated, recorder));
+	CHECK(recorder.dataCount == before);
+}
+
+static void testRecords() {
+	Decoder decoder;
+	Recorder recorder;
+
+	unit2_Record_t record;
+	std::memset(&record, 0, sizeof(record));
+	record.timestamp = 0x12345678;
+	record.sampleAge[UNIT2_GROUP_PYRO] = 42;
+	record.pyroTemperature = 14658;
+	record.pyroAmbient = 14600;
+	record.brakesState = 1;
+
+	std::vector<can_frame> frames;
+	makeSegments(CAN_ID_RECORD_UNIT1 + 1, 0, &record, sizeof(record), frames);
+	CHECK(decoder.decodeBatch(frames.data(), frames.size(), recorder) == 1);
+	CHECK(recorder.recordCount == 1);
+	CHECK(recorder.recordUnit == 2);
+	CHECK(recorder.unit2Record.timestamp == 0x12345678);
+	CHECK(recorder.unit2Record.sampleAge[UNIT2_GROUP_PYRO] == 42);
+	CHECK(recorder.unit2Record.pyroTemperature == 14658);
+	CHECK(recorder.unit2Record.pyroAmbient == 14600);
+	CHECK(recorder.unit2Record.brakesState == 1);
+
+	// The records of different units are reassembled independently, even when interleaved
+	unit1_Record_t other;
+	std::memset(&other, 0, sizeof(other));
+	other.airspeed = 2881;
+	std::vector<can_frame> a, b, mixed;
+	makeSegments(CAN_ID_RECORD_UNIT1 + 1, 1, &record, sizeof(record), a);
+	makeSegments(CAN_ID_RECORD_UNIT1, 0, &other, sizeof(other), b);
+	for(std::size_t i = 0; i < a.size() || i < b.size(); i++) {
+		if(i < a.size())
+			mixed.push_back(a[i]);
+		if(i < b.size())
+			mixed.push_back(b[i]);
+	}
+	CHECK(decoder.decodeBatch(mixed.data(), mixed.size(), recorder) == 2);
+	CHECK(recorder.unit1Record.airspeed == 2881);
+	CHECK(decoder.reassembler(1).completedCount() == 1);
+	CHECK(decoder.reassembler(2).completedCount() == 2);
+
+	// A lost segment drops the record, the next one is decoded
+	frames.clear();
+	makeSegments(CAN_ID_RECORD_UNIT1 + 1, 2, &record, sizeof(record), frames);
+	frames.erase(frames.begin() + 1);
+	CHECK(decoder.decodeBatch(frames.data(), frames.size(), recorder) == 0);
+	CHECK(decoder.reassembler(2).droppedCount() == 1);
+	frames.clear();
+	makeSegments(CAN_ID_RECORD_UNIT1 + 1, 3, &record, sizeof(record), frames);
+	CHECK(decoder.decodeBatch(frames.data(), frames.size(), recorder) == 1);
+
+	// A transfer of the wrong size isn't passed as a record
+	frames.clear();
+	makeSegments(CAN_ID_RECORD_UNIT1 + 1, 4, &other, sizeof(other), frames);
+	int before = recorder.recordCount;
+	CHECK(decoder.decodeBatch(frames.data(), frames.size(), recorder) == 0);
+	CHECK(recorder.recordCount == before);
+}
+
+static void testProfile() {
+	Decoder decoder;
+	Recorder recorder;
+
+	HYPER_Profile_Report_t report;
+	std::memset(&report, 0, sizeof(report));
+	report.slot = 3;
+	report.clockMHz = 72;
+	report.count = 1000;
+	report.max = 7200;
+	report.histogram[HYPER_PROFILE_BUCKETS - 1] = 5;
+
+	std::vector<can_frame> frames;
+	makeSegments(CAN_ID_PROFILE_UNIT1 + 4, 0, &report, sizeof(report), frames);
+	CHECK(decoder.decodeBatch(frames.data(), frames.size(), recorder) == 1);
+	CHECK(recorder.profileUnit == 5);
+	CHECK(recorder.profile.slot == 3);
+	CHECK(recorder.profile.clockMHz == 72);
+	CHECK(recorder.profile.count == 1000);
+	CHECK(recorder.profile.max == 7200);
+	CHECK(recorder.profile.histogram[HYPER_PROFILE_BUCKETS - 1] == 5);
+}
+
+static void testOther() {
+	Decoder decoder;
+	Recorder recorder;
+	unit1_DataBuffer_t unit1;
+	std::memset(&unit1, 0, sizeof(unit1));
+
+	// Data requests (RTR), extended frames and error frames are never telemetry
+	can_frame rtr = makeFrame(CAN_ID_DATA_OUT_UNIT1, unit1);
+	rtr.can_id |= CAN_RTR_FLAG;
+	CHECK(!decoder.decode(rtr, recorder));
+	can_frame ext = makeFrame(CAN_ID_DATA_OUT_UNIT1, unit1);
+	ext.can_id |= CAN_EFF_FLAG;
+	CHECK(!decoder.decode(ext, recorder));
+	can_frame err = makeFrame(CAN_ID_DATA_OUT_UNIT1, unit1);
+	err.can_id |= CAN_ERR_FLAG;
+	CHECK(!decoder.decode(err, recorder));
+
+	// Commands, SYNC and diagnostics
+	uint8_t command[2] = {MSG_DIAGREQUEST, DIAG_I2C};
+	CHECK(!decoder.decode(makeFrame(HYPER_CAN_ID_BROADCAST, command), recorder));
+	CHECK(!decoder.decode(makeFrame(HYPER_CAN_ID_SYNC, command[0]), recorder));
+	CHECK(!decoder.decode(makeFrame(50, command), recorder));
+
+	CHECK(recorder.otherCount == 6);
+	CHECK(recorder.dataCount == 0);
+}
+
+int main() {
+	testDataFrames();
+	testRecords();
+	testProfile();
+	testOther();
+
+	return checkResult("test_decoder");
+}
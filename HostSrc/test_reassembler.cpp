@@ -0,0 +1,287 @@
+/**
+ * @file test_reassembler.cpp
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the host tests of the segmented transfer reassembler: complete transfers, lost,
+ * repeated and reordered segments (also by the transmit mailboxes), and the recovery after each of them
+ */
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include "hyper_can_reassembler.hpp"
+#include "hyper_can_decoder.hpp"
+#include "hyper_can_testframes.hpp"
+
+using namespace hyper;
+
+static const uint32_t RECORD_ID = CAN_ID_RECORD_UNIT1 + 1;	/**< The ID of the test transfers (UNIT2's records) */
+
+/**
+ * @brief This function splits a block of data into segments the same way the firmware does
+ * @param sequence The transfer sequence number
+ * @param data Pointer to the data
+ * @param length The amount of data bytes
+ * @return The segments
+ */
+static std::vector<can_frame> segment(uint8_t sequence, const void *data, std::size_t length) {
+	std::vector<can_frame> frames;
+	makeSegments(RECORD_ID, sequence, data, length, frames);
+	return frames;
+}
+
+/**
+ * @brief This function feeds the segments to the reassembler
+ * @return The result of the last segment
+ */
+static SegmentReassembler::Result feed(SegmentReassembler &r, const std::vector<can_frame> &segments) {
+	SegmentReassembler::Result result = SegmentReassembler::INCOMPLETE;
+	for(const can_frame &s : segments)
+		result = r.push(s.data, s.can_dlc);
+	return result;
+}
+
+/**
+ * @brief This function fills a test record with a recognizable pattern
+ */
+static void fill(unit2_Record_t &record, uint8_t seed) {
+	uint8_t *bytes = reinterpret_cast<uint8_t *>(&record);
+	for(std::size_t i = 0; i < sizeof(record); i++)
+		bytes[i] = seed + i * 7;
+}
+
+static void testComplete() {
+	SegmentReassembler r;
+	unit2_Record_t sent, received;
+	fill(sent, 1);
+
+	std::vector<can_frame> segments = segment(3, &sent, sizeof(sent));
+	for(std::size_t i = 0; i + 1 < segments.size(); i++)
+		CHECK(r.push(segments[i].data, segments[i].can_dlc) == SegmentReassembler::INCOMPLETE);
+	CHECK(r.push(segments.back().data, segments.back().can_dlc) == SegmentReassembler::COMPLETE);
+
+	CHECK(r.get(received));
+	CHECK(std::memcmp(&sent, &received, sizeof(sent)) == 0);
+	CHECK(r.completedCount() == 1);
+	CHECK(r.droppedCount() == 0);
+
+	// A record of another type doesn't match the size
+	unit6_Record_t other;
+	CHECK(!r.get(other));
+}
+
+static void testLostSegment() {
+	SegmentReassembler r;
+	unit2_Record_t sent, received;
+	fill(sent, 2);
+	std::vector<can_frame> segments = segment(0, &sent, sizeof(sent));
+
+	// A middle segment is lost, the rest of the transfer is dropped
+	std::vector<can_frame> lossy = segments;
+	lossy.erase(lossy.begin() + 2);
+	CHECK(feed(r, lossy) == SegmentReassembler::DROPPED);
+	CHECK(r.size() == 0);
+	CHECK(!r.get(received));
+	CHECK(r.droppedCount() == 1);
+
+	// The next transfer gets through
+	fill(sent, 3);
+	CHECK(feed(r, segment(1, &sent, sizeof(sent))) == SegmentReassembler::COMPLETE);
+	CHECK(r.get(received));
+	CHECK(std::memcmp(&sent, &received, sizeof(sent)) == 0);
+}
+
+static void testLostLastSegment() {
+	SegmentReassembler r;
+	unit2_Record_t sent, received;
+	fill(sent, 4);
+
+	// The last segment is lost, the next transfer's first segment replaces the unfinished one
+	std::vector<can_frame> first = segment(4, &sent, sizeof(sent));
+	first.pop_back();
+	CHECK(feed(r, first) == SegmentReassembler::INCOMPLETE);
+
+	fill(sent, 5);
+	CHECK(feed(r, segment(5, &sent, sizeof(sent))) == SegmentReassembler::COMPLETE);
+	CHECK(r.get(received));
+	CHECK(std::memcmp(&sent, &received, sizeof(sent)) == 0);
+	CHECK(r.droppedCount() == 1);
+	CHECK(r.completedCount() == 1);
+}
+
+static void testLostFirstSegment() {
+	SegmentReassembler r;
+	unit2_Record_t sent;
+	fill(sent, 6);
+
+	// Without its first segment a transfer is never started
+	std::vector<can_frame> segments = segment(6, &sent, sizeof(sent));
+	segments.erase(segments.begin());
+	for(const can_frame &s : segments)
+		CHECK(r.push(s.data, s.can_dlc) == SegmentReassembler::DROPPED);
+	CHECK(r.completedCount() == 0);
+}
+
+static void testReordered() {
+	SegmentReassembler r;
+	unit2_Record_t sent, received;
+	fill(sent, 7);
+
+	// Two segments swapped
+	std::vector<can_frame> segments = segment(2, &sent, sizeof(sent));
+	std::swap(segments[1], segments[2]);
+	CHECK(feed(r, segments) == SegmentReassembler::DROPPED);
+	CHECK(!r.get(received));
+
+	// Segments of two transfers interleaved, the sequence numbers tell them apart
+	unit2_Record_t other;
+	fill(other, 8);
+	std::vector<can_frame> a = segment(3, &sent, sizeof(sent));
+	std::vector<can_frame> b = segment(4, &other, sizeof(other));
+	std::vector<can_frame> mixed;
+	mixed.push_back(a[0]);
+	mixed.push_back(a[1]);
+	mixed.push_back(b[2]);
+	mixed.insert(mixed.end(), a.begin() + 2, a.end());
+	CHECK(feed(r, mixed) == SegmentReassembler::DROPPED);
+	CHECK(r.completedCount() == 0);
+}
+
+static void testRepeated() {
+	SegmentReassembler r;
+	unit2_Record_t sent;
+	fill(sent, 9);
+
+	// A repeated segment (eg. a retransmission seen twice by the logger)
+	std::vector<can_frame> segments = segment(5, &sent, sizeof(sent));
+	segments.insert(segments.begin() + 2, segments[1]);
+	CHECK(feed(r, segments) == SegmentReassembler::DROPPED);
+	CHECK(r.completedCount() == 0);
+}
+
+/**
+ * @brief A model of the bxCAN transmit mailboxes, fed the way HYPER_CAN_TxKick() does: the free mailboxes are filled
+ * from the queue in their index order, a frame is sent when the bus is free
+ */
+struct Mailboxes {
+	static const int COUNT = 3;
+
+	explicit Mailboxes(bool fifo) : fifo(fifo), requests(0) {
+		for(int i = 0; i < COUNT; i++)
+			full[i] = false;
+	}
+
+	/**
+	 * @brief This function fills the free mailboxes with the queued frames (CAN_Transmit() takes the first empty one)
+	 */
+	void kick(std::deque<can_frame> &queue) {
+		for(int i = 0; i < COUNT && !queue.empty(); i++) {
+			if(full[i])
+				continue;
+			frame[i] = queue.front();
+			queue.pop_front();
+			request[i] = requests++;
+			full[i] = true;
+		}
+	}
+
+	/**
+	 * @brief This function sends a frame: the oldest request with CAN_TXFP, otherwise the lowest ID (the lowest mailbox on a tie)
+	 * @return false if the mailboxes are empty
+	 */
+	bool send(can_frame &sent) {
+		int next = -1;
+		for(int i = 0; i < COUNT; i++) {
+			if(!full[i])
+				continue;
+			if(next < 0 || (fifo ? request[i] < request[next] : frame[i].can_id < frame[next].can_id))
+				next = i;
+		}
+		if(next < 0)
+			return false;
+		full[next] = false;
+		sent = frame[next];
+		return true;
+	}
+
+	bool fifo;					/**< CAN_TXFP */
+	bool full[COUNT];			/**< The mailbox holds a frame */
+	can_frame frame[COUNT];		/**< The mailboxes' frames */
+	uint32_t request[COUNT];	/**< The order the mailboxes were filled in */
+	uint32_t requests;			/**< The amount of filled mailboxes */
+};
+
+/**
+ * @brief This function sends a transfer through the mailboxes
+ * @param fifo CAN_TXFP
+ * @return The frames in the order they were sent
+ */
+static std::vector<can_frame> sendThroughMailboxes(bool fifo, const std::vector<can_frame> &segments) {
+	std::deque<can_frame> queue(segments.begin(), segments.end());
+	Mailboxes mailboxes(fifo);
+	std::vector<can_frame> sent;
+	can_frame frame;
+	mailboxes.kick(queue);
+	while(mailboxes.send(frame)) {
+		sent.push_back(frame);
+		mailboxes.kick(queue);
+	}
+	return sent;
+}
+
+static void testMailboxOrder() {
+	SegmentReassembler r;
+	unit2_Record_t sent, received;
+	fill(sent, 10);
+	std::vector<can_frame> segments = segment(6, &sent, sizeof(sent));
+
+	// Sent by ID, the mailbox freed first takes the 4th segment and sends it before the 2nd and 3rd (equal IDs)
+	std::vector<can_frame> reordered = sendThroughMailboxes(false, segments);
+	CHECK(reordered.size() == segments.size());
+	CHECK((reordered[1].data[0] & HYPER_SEGMENT_INDEX_MASK) == 3);
+	CHECK(feed(r, reordered) == SegmentReassembler::DROPPED);
+	CHECK(!r.get(received));
+
+	// Sent in the order they were filled (CAN_TXFP, as the firmware sets it up), the transfer gets through
+	std::vector<can_frame> ordered = sendThroughMailboxes(true, segments);
+	CHECK(ordered.size() == segments.size());
+	CHECK(feed(r, ordered) == SegmentReassembler::COMPLETE);
+	CHECK(r.get(received));
+	CHECK(std::memcmp(&sent, &received, sizeof(sent)) == 0);
+}
+
+static void testMalformed() {
+	SegmentReassembler r;
+	uint8_t empty[8] = {0};
+	CHECK(r.push(empty, 0) == SegmentReassembler::DROPPED);
+	CHECK(r.push(empty, 9) == SegmentReassembler::DROPPED);
+
+	// A short segment that isn't the last one
+	uint8_t data[64];
+	for(std::size_t i = 0; i < sizeof(data); i++)
+		data[i] = i;
+	std::vector<can_frame> segments = segment(0, data, sizeof(data));
+	segments[1].can_dlc = 4;
+	CHECK(feed(r, segments) == SegmentReassembler::DROPPED);
+
+	// A single segment transfer
+	CHECK(feed(r, segment(1, data, 3)) == SegmentReassembler::COMPLETE);
+	CHECK(r.size() == 3);
+	CHECK(std::memcmp(r.data(), data, 3) == 0);
+}
+
+int main() {
+	testComplete();
+	testLostSegment();
+	testLostLastSegment();
+	testLostFirstSegment();
+	testReordered();
+	testRepeated();
+	testMailboxOrder();
+	testMalformed();
+
+	return checkResult("test_reassembler");
+}
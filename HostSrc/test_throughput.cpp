@@ -0,0 +1,114 @@
+/**
+ * @file test_throughput.cpp
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the throughput test of the segmented record transfers. For each unit's record it reports
+ * the segments, the bus time at the configured bit rate and the segment overhead, checks that the default publish
+ * schedule (the data frames and the records of all the units) fits in the bus, and measures the host reassembly rate.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "stm32f10x.h"
+extern "C" {
+#include "hyper_settings.h"
+}
+
+#include "hyper_can_reassembler.hpp"
+#include "hyper_can_decoder.hpp"
+#include "hyper_can_testframes.hpp"
+
+using namespace hyper;
+
+static const double BIT_RATE = 1000000.0;		/**< The bus bit rate of HYPER_CAN_SPEED_1000KBPS (in bit/s) */
+static const double MAX_LOAD = 0.5;				/**< The bus load the default schedule has to stay under (the rest is left to the commands and SYNC) */
+
+/**
+ * @brief This function computes the length of a standard data frame on the bus, with the worst case bit stuffing
+ * (SOF, ID, RTR, IDE, r0, DLC, data and CRC are stuffed, then CRC delimiter, ACK, EOF and the interframe space)
+ * @param dlc The amount of data bytes
+ * @return The length (in bits)
+ */
+static unsigned frameBits(unsigned dlc) {
+	unsigned stuffed = 34 + 8 * dlc;
+	return stuffed + (stuffed - 1) / 4 + 13;
+}
+
+/**
+ * @brief The bus cost of a transfer
+ */
+struct Transfer {
+	unsigned segments;		/**< The amount of frames */
+	unsigned bits;			/**< The bus time (in bits) */
+};
+
+/**
+ * @brief This function computes the bus cost of a segmented transfer
+ * @param length The amount of data bytes
+ */
+static Transfer transferCost(std::size_t length) {
+	std::vector<can_frame> frames;
+	std::vector<uint8_t> data(length);
+	makeSegments(CAN_ID_RECORD_UNIT1, 0, data.data(), length, frames);
+
+	Transfer transfer = {(unsigned)frames.size(), 0};
+	for(const can_frame &frame : frames)
+		transfer.bits += frameBits(frame.can_dlc);
+	return transfer;
+}
+
+int main() {
+	const std::size_t recordSizes[UNITS] = {sizeof(unit1_Record_t), sizeof(unit2_Record_t), sizeof(unit3_Record_t),
+		sizeof(unit4_Record_t), sizeof(unit5_Record_t), sizeof(unit6_Record_t)};
+	const std::size_t dataSizes[UNITS] = {sizeof(unit1_DataBuffer_t), sizeof(unit2_DataBuffer_t), sizeof(unit3_DataBuffer_t),
+		sizeof(unit3_DataBuffer_t), sizeof(unit5_DataBuffer_t), sizeof(unit6_DataBuffer_t)};
+
+	// The default schedule: every unit publishes its data frame once per period, its record every HYPER_CAN_RECORD_DIVIDER-th one
+	const double publishRate = 1000.0 / HYPER_CAN_PUBLISH_PERIOD;
+	const double recordRate = HYPER_CAN_RECORD_DIVIDER ? publishRate / HYPER_CAN_RECORD_DIVIDER : 0.0;
+
+	std::printf("bit rate %.0f kbit/s, publish period %d ms, records every %d publishes (%.0f records/s per unit)\n",
+		BIT_RATE / 1000, HYPER_CAN_PUBLISH_PERIOD, HYPER_CAN_RECORD_DIVIDER, recordRate);
+	std::printf("unit  bytes  segments  bus time  overhead  max records/s  load\n");
+
+	double load = 0.0;
+	for(int unit = 0; unit < UNITS; unit++) {
+		Transfer record = transferCost(recordSizes[unit]);
+		double recordTime = record.bits / BIT_RATE;
+		double payloadBits = 8.0 * recordSizes[unit];
+		double unitLoad = recordRate * recordTime + publishRate * frameBits(dataSizes[unit]) / BIT_RATE;
+		load += unitLoad;
+
+		CHECK(record.segments <= HYPER_SEGMENT_MAX);
+		std::printf("%4d  %5zu  %8u  %6.0f us  %7.1f%%  %13.0f  %4.1f%%\n", unit + 1, recordSizes[unit], record.segments,
+			recordTime * 1e6, 100.0 * (1.0 - payloadBits / record.bits), 1.0 / recordTime, 100.0 * unitLoad);
+	}
+	std::printf("bus load of the default schedule: %.1f%% (worst case stuffing)\n", 100.0 * load);
+	CHECK(load < MAX_LOAD);
+
+	// The host side reassembly rate
+	unit2_Record_t record;
+	std::memset(&record, 0x5A, sizeof(record));
+	std::vector<can_frame> frames;
+	for(uint8_t sequence = 0; sequence <= HYPER_SEGMENT_SEQ_MASK; sequence++)
+		makeSegments(CAN_ID_RECORD_UNIT1 + 1, sequence, &record, sizeof(record), frames);
+
+	SegmentReassembler reassembler;
+	const int rounds = 100000;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(int round = 0; round < rounds; round++) {
+		for(const can_frame &frame : frames)
+			reassembler.push(frame.data, frame.can_dlc);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	CHECK(reassembler.completedCount() == (uint32_t)rounds * (HYPER_SEGMENT_SEQ_MASK + 1));
+	CHECK(reassembler.droppedCount() == 0);
+	std::printf("host reassembly: %.0f records/s, %.0f segments/s\n", reassembler.completedCount() / seconds,
+		(double)rounds * frames.size() / seconds);
+
+	return checkResult("test_throughput");
+}
@@ -11,7 +11,9 @@
  * @brief This function initializes all peripherals and interfaces necessary for every unit
  */
 void HYPER_Init(void) {
+	HYPER_NVIC_Init();
 	HYPER_SysTick_Init();
+	HYPER_Cycles_Init();
 	HYPER_Watchdog_Init();
 	HYPER_TempSensor_Init();
 	HYPER_LED_Init();
@@ -10,6 +10,12 @@
 
 #include "hyper_utils.h"
 #include "hyper_can.h"
+#include "hyper_health.h"
+#include "hyper_sched.h"
+#include "hyper_profile.h"
+#include "hyper_trace.h"
+#include "hyper_boot.h"
+#include "hyper_i2c.h"
 
 void HYPER_Init(void);
 
@@ -0,0 +1,144 @@
+/**
+ * @file hyper_boot.c
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the unit startup functions. The slow driver initializations (power cycling, sensor boot
+ * times, calibrations) run as non-blocking steps, all advanced together from the start wait and the main loop,
+ * so they overlap each other and the unit answers on CAN right away. The time of each step is kept for DIAG_BOOT.
+ */
+
+#include "stm32f10x.h"
+#include "hyper_boot.h"
+#include "hyper_settings.h"
+#include "hyper_utils.h"
+
+/**
+ * @brief Time value of the phases and steps that didn't complete yet
+ */
+#define HYPER_BOOT_PENDING		0xFFFF
+
+/**
+ * @brief The unit's initialization steps
+ */
+static const HYPER_Boot_Step_t *bootSteps = 0;
+
+/**
+ * @brief The amount of steps in bootSteps
+ */
+static uint8_t bootCount = 0;
+
+/**
+ * @brief Bit mask of the steps that completed
+ */
+static uint32_t bootDone = 0;
+
+/**
+ * @brief The completion time of each step (in ms since the reset)
+ */
+static uint16_t bootStepTime[HYPER_BOOT_MAX_STEPS];
+
+/**
+ * @brief The time of each startup phase (in ms since the reset)
+ */
+static uint16_t bootPhaseTime[BOOT_PHASES] = {HYPER_BOOT_PENDING, HYPER_BOOT_PENDING, HYPER_BOOT_PENDING};
+
+/**
+ * @brief This function returns the current time, saturated for the boot time records
+ * @return Time since the reset (in ms)
+ */
+static uint16_t HYPER_Boot_Now(void) {
+	uint32_t now = HYPER_Delay_GetTime();
+	return now >= HYPER_BOOT_PENDING ? HYPER_BOOT_PENDING - 1 : now;
+}
+
+/**
+ * @brief This function sets the unit's initialization steps. It should be run in UNIT_Init(), after the drivers' initializations are started.
+ * @param steps Pointer to the step table (has to stay valid, usually a constant array)
+ * @param count The amount of steps (HYPER_BOOT_MAX_STEPS max, the rest is ignored)
+ */
+void HYPER_Boot_Init(const HYPER_Boot_Step_t *steps, uint8_t count) {
+	if(count > HYPER_BOOT_MAX_STEPS)
+		count = HYPER_BOOT_MAX_STEPS;
+
+	for(uint8_t i = 0; i < count; i++)
+		bootStepTime[i] = HYPER_BOOT_PENDING;
+
+	bootSteps = steps;
+	bootCount = count;
+	bootDone = 0;
+}
+
+/**
+ * @brief This function records the time of a startup phase
+ * @param phase The startup phase @see HYPER_Boot_Phase_t
+ */
+void HYPER_Boot_Mark(HYPER_Boot_Phase_t phase) {
+	if(phase < BOOT_PHASES && bootPhaseTime[phase] == HYPER_BOOT_PENDING)
+		bootPhaseTime[phase] = HYPER_Boot_Now();
+}
+
+/**
+ * @brief This function advances the pending initialization steps. It should be run in the main loop (and while waiting for the start).
+ * @return true once all the steps completed, false otherwise
+ */
+bool HYPER_Boot_Tick(void) {
+	if(bootPhaseTime[BOOT_COMPLETE] != HYPER_BOOT_PENDING)
+		return true;
+
+	for(uint8_t i = 0; i < bootCount; i++) {
+		if(bootDone & (1UL << i))
+			continue;
+		if(bootSteps[i]()) {
+			bootDone |= 1UL << i;
+			bootStepTime[i] = HYPER_Boot_Now();
+		}
+	}
+
+	if(bootDone != (1UL << bootCount) - 1)
+		return false;
+
+	HYPER_Boot_Mark(BOOT_COMPLETE);
+	return true;
+}
+
+/**
+ * @brief This function checks if all the initialization steps completed
+ * @return true if the unit is fully initialized, false otherwise
+ */
+bool HYPER_Boot_IsComplete(void) {
+	return bootPhaseTime[BOOT_COMPLETE] != HYPER_BOOT_PENDING;
+}
+
+/**
+ * @brief This function returns the amount of the unit's initialization steps
+ * @return The amount of steps
+ */
+uint8_t HYPER_Boot_GetCount(void) {
+	return bootCount;
+}
+
+/**
+ * @brief This function returns the time of a startup phase
+ * @param phase The startup phase @see HYPER_Boot_Phase_t
+ * @return Time since the reset (in ms), 0xFFFF if the phase wasn't reached yet
+ */
+uint16_t HYPER_Boot_GetPhaseTime(HYPER_Boot_Phase_t phase) {
+	if(phase >= BOOT_PHASES)
+		return HYPER_BOOT_PENDING;
+
+	return bootPhaseTime[phase];
+}
+
+/**
+ * @brief This function returns the completion time of an initialization step
+ * @param step The step index (its position in the unit's step table)
+ * @param time_ms Pointer to the output value, time since the reset (in ms), 0xFFFF if the step didn't complete yet
+ * @return true if the step exists, false otherwise
+ */
+bool HYPER_Boot_GetStepTime(uint8_t step, uint16_t *time_ms) {
+	if(step >= bootCount)
+		return false;
+
+	*time_ms = bootStepTime[step];
+	return true;
+}
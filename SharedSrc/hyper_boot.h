@@ -0,0 +1,38 @@
+/**
+ * @file hyper_boot.h
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the headers of the unit startup functions
+ */
+
+#ifndef HYPER_BOOT_H_
+#define HYPER_BOOT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Pointer type of a driver's initialization step function. It advances the driver's initialization
+ * without blocking and returns true once the driver is ready.
+ */
+typedef bool (*HYPER_Boot_Step_t)(void);
+
+/**
+ * @brief This enum represents the startup phases, their times are reported with DIAG_BOOT
+ */
+typedef enum {
+	BOOT_UNITINIT = 0,			/**< UNIT_Init() returned (the initialization steps are started) */
+	BOOT_STARTED,				/**< The start message was received (or skipped after an IWDG reset) */
+	BOOT_COMPLETE,				/**< All the initialization steps completed */
+	BOOT_PHASES					/**< The amount of the startup phases */
+} HYPER_Boot_Phase_t;
+
+void HYPER_Boot_Init(const HYPER_Boot_Step_t *steps, uint8_t count);
+void HYPER_Boot_Mark(HYPER_Boot_Phase_t phase);
+bool HYPER_Boot_Tick(void);
+bool HYPER_Boot_IsComplete(void);
+uint8_t HYPER_Boot_GetCount(void);
+uint16_t HYPER_Boot_GetPhaseTime(HYPER_Boot_Phase_t phase);
+bool HYPER_Boot_GetStepTime(uint8_t step, uint16_t *time_ms);
+
+#endif /* HYPER_BOOT_H_ */
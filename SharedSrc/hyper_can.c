@@ -12,13 +12,144 @@
 #include "hyper_can_frames.h"
 #include "hyper_settings.h"
 #include "hyper_utils.h"
+#include "hyper_sync.h"
+#include "hyper_health.h"
+#include "hyper_sched.h"
+#include "hyper_profile.h"
+#include "hyper_trace.h"
+#include "hyper_boot.h"
+#include "hyper_i2c.h"
 
 /**
- * @brief Structure that buffers this unit's CAN data messages
+ * @brief Structure that holds this unit's full resolution data. Filled in the main loop only.
  */
-static unit_DataBuffer_t unitDataBuffer = {0};
+static unit_Record_t unitRecord = {0};
 
+/**
+ * @brief Pod time each channel group of unitRecord was last sampled at (in us)
+ */
+static uint32_t sampleTime[HYPER_CAN_GROUPS] = {0};
+
+/**
+ * @brief Bit mask of the channel groups that were sampled at least once (and not invalidated since)
+ */
+static uint32_t sampleValid = 0;
+
+/**
+ * @brief Coherent data frames packed from unitRecord, the one pointed by unitDataFront is sent out
+ */
+static unit_DataBuffer_t unitDataSnapshot[2] = {{0}};
+
+/**
+ * @brief The index of the snapshot that is currently sent out
+ */
+static volatile uint8_t unitDataFront = 0;
+
+/**
+ * @brief The time between unsolicited data frames (in ms), 0 if the push mode is disabled
+ */
+static uint16_t publishPeriod = HYPER_CAN_PUBLISH_PERIOD;
+
+/**
+ * @brief The publish period requested through MSG_PUBLISHCONFIG, applied in HYPER_CAN_Tick()
+ */
+static volatile uint16_t publishPeriodRequest = HYPER_CAN_PUBLISH_PERIOD;
+
+/**
+ * @brief The pod time of the latest publish slot (in us)
+ */
+static uint32_t publishTimestamp = 0;
+
+/**
+ * @brief The amount of pod clock steps seen at the latest slot alignment
+ */
+static uint16_t publishSyncSteps = 0;
+
+/**
+ * @brief The amount of scheduled data frames queued since the last publish rate update (the RTR replies are not counted)
+ */
+static uint16_t publishCounter = 0;
+
+/**
+ * @brief The amount of publish slots since the latest record transfer
+ */
+static uint8_t recordDivider = 0;
+
+/**
+ * @brief The sequence number of the next segmented transfer
+ */
+static uint8_t segmentSequence = 0;
+
+/**
+ * @brief The amount of records queued since the last publish rate update
+ */
+static uint16_t recordCounter = 0;
+
+/**
+ * @brief The timestamp of the latest publish rate update
+ */
+static uint32_t publishRateTimestamp = 0;
+
+/**
+ * @brief The CAN interface statistics
+ */
+static HYPER_CAN_Stats_t canStats = {HYPER_CAN_PUBLISH_PERIOD, 0};
+
+/**
+ * @brief Ring buffer of the outgoing frames waiting for a free transmit mailbox
+ */
+static CanTxMsg txQueue[HYPER_CAN_TX_QUEUE_LENGTH];
+
+/**
+ * @brief The index of the next frame to be transmitted from txQueue
+ */
+static uint8_t txQueueHead = 0;
+
+/**
+ * @brief The amount of frames waiting in txQueue
+ */
+static uint8_t txQueueCount = 0;
+
+/**
+ * @brief Ring buffer of the received frames waiting to be processed in the main loop.
+ * Single producer (CAN RX interrupts, all at the same priority) and single consumer (HYPER_CAN_Dispatch()).
+ */
+static CanRxMsg rxQueue[HYPER_CAN_RX_QUEUE_LENGTH];
+
+/**
+ * @brief The amount of frames taken from rxQueue (free running, written only by the consumer)
+ */
+static volatile uint8_t rxQueueHead = 0;
+
+/**
+ * @brief The amount of frames put in rxQueue (free running, written only by the producer)
+ */
+static volatile uint8_t rxQueueTail = 0;
+
+/**
+ * @brief The latest bus error code, taken from CAN_ESR before it gets cleared
+ */
+static volatile uint8_t busLastErrorCode = 0;
+
+/**
+ * @brief The error state flags (EWGF, EPVF, BOFF) seen at the previous CAN1_SCE_IRQ
+ */
+static uint8_t busErrorState = 0;
+
+/**
+ * @brief The bus error interrupt is enabled
+ */
+static volatile bool busErrorArmed = true;
+
+/**
+ * @brief The timestamp of the latest bus error interrupt
+ */
+static volatile uint32_t busErrorTimestamp = 0;
+
+static void HYPER_CAN_PublishAlign(void);
+static void HYPER_CAN_SendDiag(DiagType_t diag_type, uint8_t diag_arg);
 void UNIT_CAN_ProcessFrame(MsgType_t msg_type, uint8_t *msg_data) __attribute__((weak));
+void UNIT_CAN_Pack(const unit_Record_t *record, unit_DataBuffer_t *buffer);
 
 /**
  * @brief This function initializes the CAN1 peripheral and the required GPIOs.
@@ -46,7 +177,8 @@ void HYPER_CAN_Init(void) {
 	CAN_InitTypeDef can_init;
 	CAN_StructInit(&can_init);
 	can_init.CAN_RFLM = ENABLE;
-	can_init.CAN_TXFP = DISABLE;
+	can_init.CAN_ABOM = ENABLE; // leave the bus-off state automatically
+	can_init.CAN_TXFP = ENABLE; // the mailboxes go out in the order they were filled (the software queue sets the priority)
 	can_init.CAN_Mode = CAN_Mode_Normal;
 	can_init.CAN_SJW = CAN_SJW_1tq;
 	can_init.CAN_BS1 = CAN_BS1_10tq;
@@ -54,25 +186,60 @@ void HYPER_CAN_Init(void) {
 	can_init.CAN_Prescaler = HYPER_CAN_SPEED;
 	CAN_Init(CAN1, &can_init);
 
-	// CAN1 filter setup - only accept RTR messages with ID equal to UNIT_CAN_ID_DATA
+	// CAN1 filter setup - only accept RTR messages with ID equal to UNIT_CAN_ID_DATA_OUT and data messages with ID equal to UNIT_CAN_ID_DATA_IN
+	// (a 16-bit list bank holds 4 IDs, the unused entries repeat the used ones)
 	CAN_FilterInitTypeDef can_filter_init;
 	can_filter_init.CAN_FilterNumber = 0;
 	can_filter_init.CAN_FilterMode = CAN_FilterMode_IdList;
 	can_filter_init.CAN_FilterScale = CAN_FilterScale_16bit;
 	can_filter_init.CAN_FilterIdHigh = (UNIT_CAN_ID_DATA_OUT << 5) | (1 << 4);
 	can_filter_init.CAN_FilterIdLow = (UNIT_CAN_ID_DATA_IN << 5);
+	can_filter_init.CAN_FilterMaskIdHigh = (UNIT_CAN_ID_DATA_OUT << 5) | (1 << 4);
+	can_filter_init.CAN_FilterMaskIdLow = (UNIT_CAN_ID_DATA_IN << 5);
 	can_filter_init.CAN_FilterFIFOAssignment = CAN_FIFO0;
 	can_filter_init.CAN_FilterActivation = ENABLE;
 	CAN_FilterInit(&can_filter_init);
 
-	// CAN1_RX interrupt setup
+	// Time synchronization messages go to FIFO1, so the SYNC never waits behind other frames
+	can_filter_init.CAN_FilterNumber = 1;
+	can_filter_init.CAN_FilterIdHigh = (HYPER_CAN_ID_SYNC << 5);
+	can_filter_init.CAN_FilterIdLow = (HYPER_CAN_ID_SYNCFOLLOWUP << 5);
+	can_filter_init.CAN_FilterMaskIdHigh = (HYPER_CAN_ID_SYNC << 5);
+	can_filter_init.CAN_FilterMaskIdLow = (HYPER_CAN_ID_SYNCFOLLOWUP << 5);
+	can_filter_init.CAN_FilterFIFOAssignment = CAN_FIFO1;
+	CAN_FilterInit(&can_filter_init);
+
+	// Pod-wide and multicast group commands
+	can_filter_init.CAN_FilterNumber = 2;
+	can_filter_init.CAN_FilterIdHigh = (HYPER_CAN_ID_BROADCAST << 5);
+	can_filter_init.CAN_FilterIdLow = (UNIT_CAN_ID_GROUP << 5);
+	can_filter_init.CAN_FilterMaskIdHigh = (HYPER_CAN_ID_BROADCAST << 5);
+	can_filter_init.CAN_FilterMaskIdLow = (UNIT_CAN_ID_GROUP << 5);
+	can_filter_init.CAN_FilterFIFOAssignment = CAN_FIFO0;
+	CAN_FilterInit(&can_filter_init);
+
+	// CAN1_RX interrupts setup (both FIFOs share the same priority, so they never preempt each other)
 	NVIC_InitTypeDef nvic_init;
 	nvic_init.NVIC_IRQChannel = USB_LP_CAN1_RX0_IRQn;
-	nvic_init.NVIC_IRQChannelPreemptionPriority = 1;
+	nvic_init.NVIC_IRQChannelPreemptionPriority = HYPER_IRQ_PRIORITY_CAN_RX;
 	nvic_init.NVIC_IRQChannelSubPriority = 0;
 	nvic_init.NVIC_IRQChannelCmd = ENABLE;
 	NVIC_Init(&nvic_init);
-	CAN_ITConfig(CAN1, CAN_IT_FMP0, ENABLE);
+	nvic_init.NVIC_IRQChannel = CAN1_RX1_IRQn;
+	NVIC_Init(&nvic_init);
+	CAN_ITConfig(CAN1, CAN_IT_FMP0 | CAN_IT_FOV0 | CAN_IT_FMP1 | CAN_IT_FOV1, ENABLE);
+
+	// CAN1_TX interrupt setup (fired when a transmission completes, which frees a mailbox)
+	nvic_init.NVIC_IRQChannel = USB_HP_CAN1_TX_IRQn;
+	nvic_init.NVIC_IRQChannelPreemptionPriority = HYPER_IRQ_PRIORITY_CAN_TX;
+	NVIC_Init(&nvic_init);
+	CAN_ITConfig(CAN1, CAN_IT_TME, ENABLE);
+
+	// CAN1_SCE interrupt setup (error state changes and bus errors)
+	nvic_init.NVIC_IRQChannel = CAN1_SCE_IRQn;
+	nvic_init.NVIC_IRQChannelPreemptionPriority = HYPER_IRQ_PRIORITY_CAN_SCE;
+	NVIC_Init(&nvic_init);
+	CAN_ITConfig(CAN1, CAN_IT_EWG | CAN_IT_EPV | CAN_IT_BOF | CAN_IT_LEC | CAN_IT_ERR, ENABLE);
 
 	// CAN status LED setup
 	RCC_APB2PeriphClockCmd(UNIT_LED_RCC, ENABLE);
@@ -80,15 +247,106 @@ void HYPER_CAN_Init(void) {
 	gpio_init.GPIO_Pin = UNIT_LED_PIN;
 	gpio_init.GPIO_Speed = GPIO_Speed_2MHz;
 	GPIO_Init(UNIT_LED_GPIO, &gpio_init);
+
+	// Push mode setup
+	if(publishPeriod != 0)
+		HYPER_CAN_PublishAlign();
+}
+
+/**
+ * @brief This function moves the queued frames to the free transmit mailboxes. Must be run with the interrupts disabled.
+ * The mailboxes are sent in the order they were filled (CAN_TXFP), a mailbox freed first may be refilled with a later frame
+ * while the earlier ones still wait, which would reorder the segments of a transfer if the mailboxes were sent by their IDs.
+ */
+static void HYPER_CAN_TxKick(void) {
+	while(txQueueCount > 0) {
+		CanTxMsg *msg = &txQueue[txQueueHead];
+		if(CAN_Transmit(CAN1, msg) == CAN_TxStatus_NoMailBox)
+			break;
+
+		// Remove the frame from the queue
+		txQueueHead = (txQueueHead + 1) % HYPER_CAN_TX_QUEUE_LENGTH;
+		txQueueCount--;
+	}
+}
+
+/**
+ * @brief This function checks if a frame belongs to a segmented transfer (a record or a profiler report)
+ * @param id The frame's ID
+ * @return true for the segments, false otherwise
+ */
+static bool HYPER_CAN_IsSegment(uint32_t id) {
+	return id == UNIT_CAN_ID_RECORD || id == UNIT_CAN_ID_PROFILE;
 }
 
 /**
- * @brief This function prepares a data message and sends it through the CAN bus
+ * @brief This function puts a frame in the transmit queue. Must be run with the interrupts disabled.
+ * @param msg Pointer to the frame
+ * @return true if the frame got queued, false if the queue was full of more important frames
+ */
+static bool HYPER_CAN_TxEnqueue(const CanTxMsg *msg) {
+	if(txQueueCount == HYPER_CAN_TX_QUEUE_LENGTH) {
+#if HYPER_CAN_TX_PRIORITY
+		// Discard the lowest priority frame if the new one is more important. The queued segments are never
+		// discarded, their transfer got room for all of them and a partial one would be useless to the receiver.
+		uint8_t n = txQueueCount;
+		while(n > 0) {
+			uint8_t i = (txQueueHead + n - 1) % HYPER_CAN_TX_QUEUE_LENGTH;
+			if(txQueue[i].StdId <= msg->StdId)
+				n = 0;
+			else if(!HYPER_CAN_IsSegment(txQueue[i].StdId))
+				break;
+			else
+				n--;
+		}
+		if(n == 0) {
+			canStats.txOverflows++;
+			HYPER_Health_Report(HEALTH_TXOVERFLOW);
+			return false;
+		}
+
+		// Close the gap, the frames behind the discarded one move forward
+		for(; n < txQueueCount; n++) {
+			uint8_t i = (txQueueHead + n - 1) % HYPER_CAN_TX_QUEUE_LENGTH;
+			txQueue[i] = txQueue[(i + 1) % HYPER_CAN_TX_QUEUE_LENGTH];
+		}
+		txQueueCount--;
+		canStats.txDrops++;
+#else
+		canStats.txOverflows++;
+		HYPER_Health_Report(HEALTH_TXOVERFLOW);
+		return false;
+#endif
+	}
+
+	// Append the frame at the end of the queue
+	uint8_t i = (txQueueHead + txQueueCount) % HYPER_CAN_TX_QUEUE_LENGTH;
+#if HYPER_CAN_TX_PRIORITY
+	// Move it forward, past all the frames with higher IDs (lower priority)
+	for(uint8_t n = txQueueCount; n > 0; n--) {
+		uint8_t prev = (i + HYPER_CAN_TX_QUEUE_LENGTH - 1) % HYPER_CAN_TX_QUEUE_LENGTH;
+		if(txQueue[prev].StdId <= msg->StdId)
+			break;
+		txQueue[i] = txQueue[prev];
+		i = prev;
+	}
+#endif
+	txQueue[i] = *msg;
+	txQueueCount++;
+
+	if(txQueueCount > canStats.txQueuePeak)
+		canStats.txQueuePeak = txQueueCount;
+	return true;
+}
+
+/**
+ * @brief This function prepares a data message and queues it for transmission through the CAN bus. It never blocks.
  * @param id Message ID
  * @param data_length The amount of data bytes to be sent (0..8)
  * @param data_ptr Pointer to the data buffer
+ * @return true if the message got queued, false otherwise (the transmit queue overflowed)
  */
-static void HYPER_CAN_SendData(const uint32_t id, const uint8_t data_length, const uint8_t* data_ptr) {
+bool HYPER_CAN_SendData(const uint32_t id, const uint8_t data_length, const uint8_t* data_ptr) {
 	// Prepare the message
 	CanTxMsg msg;
 	msg.StdId = id;
@@ -97,8 +355,336 @@ static void HYPER_CAN_SendData(const uint32_t id, const uint8_t data_length, con
 	msg.DLC = data_length;
 	for (uint8_t i = 0; i < data_length; i++)
 		msg.Data[i] = data_ptr[i];
-	// Transfer the message, block program execution while no mailbox is empty
-	while (CAN_Transmit(CAN1, &msg) == CAN_TxStatus_NoMailBox);
+
+	// Queue the message and start the transfer if a mailbox is free (the queue is shared with the interrupts)
+	__disable_irq();
+	bool queued = HYPER_CAN_TxEnqueue(&msg);
+	HYPER_CAN_TxKick();
+	__enable_irq();
+	return queued;
+}
+
+/**
+ * @brief This function splits a block of data into segments and queues them for transmission through the CAN bus. It never blocks.
+ * Either all the segments get queued or none of them, a partial transfer would be useless to the receiver.
+ * @param id Message ID
+ * @param length The amount of data bytes to be sent (up to HYPER_SEGMENT_MAX * HYPER_SEGMENT_PAYLOAD)
+ * @param data_ptr Pointer to the data buffer
+ * @return true if the transfer got queued, false otherwise
+ */
+bool HYPER_CAN_SendSegmented(const uint32_t id, const uint16_t length, const uint8_t *data_ptr) {
+	uint8_t segments = (length + HYPER_SEGMENT_PAYLOAD - 1) / HYPER_SEGMENT_PAYLOAD;
+	if(segments == 0)
+		segments = 1;
+	if(segments > HYPER_SEGMENT_MAX)
+		return false;
+
+	// Make sure there is room for the whole transfer (the queue is shared with the interrupts)
+	__disable_irq();
+	if(HYPER_CAN_TX_QUEUE_LENGTH - txQueueCount < segments) {
+		canStats.recordDrops++;
+		__enable_irq();
+		return false;
+	}
+
+	// Queue the segments (frames with the same ID keep their order in the queue, and the mailboxes keep the queue's order)
+	CanTxMsg msg;
+	msg.StdId = id;
+	msg.IDE = CAN_Id_Standard;
+	msg.RTR = CAN_RTR_Data;
+	for(uint8_t segment = 0; segment < segments; segment++) {
+		uint16_t offset = segment * HYPER_SEGMENT_PAYLOAD;
+		uint8_t payload = (length - offset > HYPER_SEGMENT_PAYLOAD) ? HYPER_SEGMENT_PAYLOAD : length - offset;
+
+		msg.Data[0] = (segmentSequence << HYPER_SEGMENT_SEQ_SHIFT) | segment;
+		if(segment == segments - 1)
+			msg.Data[0] |= HYPER_SEGMENT_LAST;
+		for(uint8_t i = 0; i < payload; i++)
+			msg.Data[1 + i] = data_ptr[offset + i];
+		msg.DLC = 1 + payload;
+
+		HYPER_CAN_TxEnqueue(&msg);
+	}
+	HYPER_CAN_TxKick();
+	__enable_irq();
+
+	segmentSequence = (segmentSequence + 1) & HYPER_SEGMENT_SEQ_MASK;
+	return true;
+}
+
+/**
+ * @brief This function queues this unit's data frame for transmission. Every HYPER_CAN_RECORD_DIVIDER-th slot the full resolution record follows it.
+ */
+static void HYPER_CAN_Publish(void) {
+	if(HYPER_CAN_SendData(UNIT_CAN_ID_DATA_OUT, sizeof(unit_DataBuffer_t), (uint8_t *)&unitDataSnapshot[unitDataFront]))
+		publishCounter++;
+
+#if HYPER_CAN_RECORD_DIVIDER
+	if(++recordDivider >= HYPER_CAN_RECORD_DIVIDER) {
+		recordDivider = 0;
+
+		// Fill in the record timestamp and the age of each channel group
+		uint32_t now = HYPER_Sync_GetTime();
+		unitRecord.timestamp = now;
+		for(uint8_t group = 0; group < HYPER_CAN_GROUPS; group++) {
+			// The pod time may have been stepped back since the sample was taken
+			int32_t age = (int32_t)(now - sampleTime[group]) / 100;
+			if(!(sampleValid & (1UL << group)) || age >= HYPER_SAMPLE_AGE_NONE)
+				age = HYPER_SAMPLE_AGE_NONE;
+			else if(age < 0)
+				age = 0;
+			unitRecord.sampleAge[group] = age;
+		}
+
+		if(HYPER_CAN_SendSegmented(UNIT_CAN_ID_RECORD, sizeof(unitRecord), (uint8_t *)&unitRecord))
+			recordCounter++;
+	}
+#endif
+}
+
+/**
+ * @brief This function publishes the current contents of the data record to the CAN interface.
+ * The back snapshot is packed and then swapped with the front one, so the interrupts always see a coherent frame.
+ */
+static void HYPER_CAN_Commit(void) {
+	uint8_t back = !unitDataFront;
+	UNIT_CAN_Pack(&unitRecord, &unitDataSnapshot[back]);
+	HYPER_BARRIER();
+	unitDataFront = back;
+}
+
+/**
+ * @brief This function aligns the publish timestamp to this unit's slot, so that the units never publish at the same time.
+ * The slots are laid out on the pod time, which all the synchronized units share.
+ */
+static void HYPER_CAN_PublishAlign(void) {
+	HYPER_Sync_Stats_t sync_stats;
+	HYPER_Sync_GetStats(&sync_stats);
+	publishSyncSteps = sync_stats.steps;
+
+	uint32_t now = HYPER_Sync_GetTime();
+	uint32_t period = (uint32_t)publishPeriod * 1000;
+	uint32_t slot_offset = (uint32_t)UNIT_CAN_PUBLISH_SLOT * period / HYPER_CAN_PUBLISH_SLOTS;
+
+	// Go back to the latest slot start, the next frame will be sent one period later
+	publishTimestamp = now - ((now + period - slot_offset) % period);
+}
+
+/**
+ * @brief This function checks if a whole publish period has passed since the given slot
+ * @param slot_time The pod time of the slot (in us)
+ * @return true if the period has passed, false otherwise (also when the pod time was slewed back before the slot)
+ */
+static bool HYPER_CAN_PublishCheck(uint32_t slot_time) {
+	return (int32_t)(HYPER_Sync_GetTime() - slot_time) >= (int32_t)((uint32_t)publishPeriod * 1000);
+}
+
+/**
+ * @brief This function sends the unsolicited data frames (push mode). It should be run in the main loop.
+ */
+void HYPER_CAN_Tick(void) {
+	// Publish the data updated during this loop pass
+	HYPER_CAN_Commit();
+
+	// Process the received frames
+	HYPER_CAN_Dispatch();
+
+	// Re-enable the bus error interrupt after the hold-off time
+	if(!busErrorArmed && HYPER_Delay_Check(busErrorTimestamp, HYPER_CAN_BUSERROR_HOLDOFF)) {
+		__disable_irq();
+		busErrorArmed = true;
+		CAN_ITConfig(CAN1, CAN_IT_LEC, ENABLE);
+		__enable_irq();
+	}
+
+	// Apply the publish period requested through the CAN bus
+	if(publishPeriod != publishPeriodRequest) {
+		publishPeriod = publishPeriodRequest;
+		canStats.publishPeriod = publishPeriod;
+		if(publishPeriod != 0)
+			HYPER_CAN_PublishAlign();
+	}
+
+	// Realign the slots when the pod clock gets stepped (the first SYNC and large corrections)
+	if(publishPeriod != 0) {
+		HYPER_Sync_Stats_t sync_stats;
+		HYPER_Sync_GetStats(&sync_stats);
+		if(sync_stats.steps != publishSyncSteps)
+			HYPER_CAN_PublishAlign();
+	}
+
+	// Send the data frame if this unit's slot has come
+	if(publishPeriod != 0 && HYPER_CAN_PublishCheck(publishTimestamp)) {
+		HYPER_CAN_Publish();
+
+		// Move on to the next slot, realign if the loop was too slow to keep up
+		publishTimestamp += (uint32_t)publishPeriod * 1000;
+		if(HYPER_CAN_PublishCheck(publishTimestamp))
+			HYPER_CAN_PublishAlign();
+	}
+
+	// Update the achieved publish rate every second
+	if(HYPER_Delay_Check(publishRateTimestamp, 1000)) {
+		canStats.publishRate = publishCounter;
+		publishCounter = 0;
+		canStats.recordRate = recordCounter;
+		recordCounter = 0;
+
+		// Update the time stamp
+		publishRateTimestamp = HYPER_Delay_GetTime();
+	}
+}
+
+/**
+ * @brief This function sends the requested diagnostic report
+ * @param diag_type The requested report @see DiagType_t
+ * @param diag_arg The report argument (eg. the task index of DIAG_TASK)
+ */
+static void HYPER_CAN_SendDiag(DiagType_t diag_type, uint8_t diag_arg) {
+	uint8_t data[8];
+	data[0] = diag_type;
+
+	if(diag_type == DIAG_PUBLISHRATE) {
+		data[1] = canStats.publishPeriod >> 8;
+		data[2] = canStats.publishPeriod & 0xFF;
+		data[3] = canStats.publishRate >> 8;
+		data[4] = canStats.publishRate & 0xFF;
+		data[5] = canStats.recordRate >> 8;
+		data[6] = canStats.recordRate & 0xFF;
+		HYPER_CAN_SendData(UNIT_CAN_ID_DIAG, 7, data);
+	}
+	else if(diag_type == DIAG_TXQUEUE) {
+		data[1] = canStats.txOverflows >> 8;
+		data[2] = canStats.txOverflows & 0xFF;
+		data[3] = canStats.txDrops >> 8;
+		data[4] = canStats.txDrops & 0xFF;
+		data[5] = canStats.txQueuePeak;
+		HYPER_CAN_SendData(UNIT_CAN_ID_DIAG, 6, data);
+	}
+	else if(diag_type == DIAG_RXQUEUE) {
+		data[1] = canStats.rxOverruns >> 8;
+		data[2] = canStats.rxOverruns & 0xFF;
+		data[3] = canStats.fifoOverruns >> 8;
+		data[4] = canStats.fifoOverruns & 0xFF;
+		data[5] = canStats.rxQueuePeak;
+		HYPER_CAN_SendData(UNIT_CAN_ID_DIAG, 6, data);
+	}
+	else if(diag_type == DIAG_SYNC || diag_type == DIAG_SYNCRATE) {
+		HYPER_Sync_Stats_t sync_stats;
+		HYPER_Sync_GetStats(&sync_stats);
+		uint32_t value = (diag_type == DIAG_SYNC) ? (uint32_t)sync_stats.offset : (uint32_t)sync_stats.rate;
+		data[1] = value >> 24;
+		data[2] = (value >> 16) & 0xFF;
+		data[3] = (value >> 8) & 0xFF;
+		data[4] = value & 0xFF;
+		if(diag_type == DIAG_SYNC) {
+			data[5] = sync_stats.jitter >> 8;
+			data[6] = sync_stats.jitter & 0xFF;
+			data[7] = sync_stats.locked;
+		}
+		else {
+			data[5] = sync_stats.steps >> 8;
+			data[6] = sync_stats.steps & 0xFF;
+			data[7] = sync_stats.missed;
+		}
+		HYPER_CAN_SendData(UNIT_CAN_ID_DIAG, 8, data);
+	}
+	else if(diag_type == DIAG_TASK) {
+		HYPER_Sched_Stats_t task_stats;
+		if(!HYPER_Sched_GetStats(diag_arg, &task_stats))
+			return;
+		data[1] = diag_arg;
+		data[2] = task_stats.runs >> 8;
+		data[3] = task_stats.runs & 0xFF;
+		data[4] = task_stats.misses >> 8;
+		data[5] = task_stats.misses & 0xFF;
+		data[6] = task_stats.response >> 8;
+		data[7] = task_stats.response & 0xFF;
+		HYPER_CAN_SendData(UNIT_CAN_ID_DIAG, 8, data);
+	}
+	else if(diag_type == DIAG_PROFILE) {
+		HYPER_Profile_Send(diag_arg);
+	}
+	else if(diag_type == DIAG_PROFILERESET) {
+		HYPER_Profile_Reset(diag_arg);
+	}
+	else if(diag_type == DIAG_TRACE) {
+		HYPER_Trace_Stats_t trace_stats;
+		if(diag_arg == 0xFF) {
+			HYPER_Trace_Reset();
+			return;
+		}
+		if(!HYPER_Trace_GetStats(diag_arg, &trace_stats))
+			return;
+		uint16_t wcet = trace_stats.wcet > 0xFFFF ? 0xFFFF : trace_stats.wcet;
+		uint16_t latency = trace_stats.latency > 0xFFFF ? 0xFFFF : trace_stats.latency;
+		uint16_t count = trace_stats.count > 0xFFFF ? 0xFFFF : trace_stats.count;
+		data[1] = diag_arg;
+		data[2] = count >> 8;
+		data[3] = count & 0xFF;
+		data[4] = wcet >> 8;
+		data[5] = wcet & 0xFF;
+		data[6] = latency >> 8;
+		data[7] = latency & 0xFF;
+		HYPER_CAN_SendData(UNIT_CAN_ID_DIAG, 8, data);
+	}
+	else if(diag_type == DIAG_BOOT) {
+		if(diag_arg == 0xFF) {
+			uint16_t unit_init = HYPER_Boot_GetPhaseTime(BOOT_UNITINIT);
+			uint16_t started = HYPER_Boot_GetPhaseTime(BOOT_STARTED);
+			uint16_t complete = HYPER_Boot_GetPhaseTime(BOOT_COMPLETE);
+			data[1] = unit_init >> 8;
+			data[2] = unit_init & 0xFF;
+			data[3] = started >> 8;
+			data[4] = started & 0xFF;
+			data[5] = complete >> 8;
+			data[6] = complete & 0xFF;
+			data[7] = HYPER_Boot_GetCount();
+			HYPER_CAN_SendData(UNIT_CAN_ID_DIAG, 8, data);
+			return;
+		}
+		uint16_t step_time;
+		if(!HYPER_Boot_GetStepTime(diag_arg, &step_time))
+			return;
+		data[1] = diag_arg;
+		data[2] = step_time >> 8;
+		data[3] = step_time & 0xFF;
+		HYPER_CAN_SendData(UNIT_CAN_ID_DIAG, 4, data);
+	}
+	else if(diag_type == DIAG_I2C) {
+		if(diag_arg == 0xFF) {
+			uint16_t recoveries1 = HYPER_I2C_GetRecoveries(I2C_BUS1);
+			uint16_t recoveries2 = HYPER_I2C_GetRecoveries(I2C_BUS2);
+			data[1] = 0xFF;
+			data[2] = recoveries1 >> 8;
+			data[3] = recoveries1 & 0xFF;
+			data[4] = recoveries2 >> 8;
+			data[5] = recoveries2 & 0xFF;
+			data[6] = HYPER_I2C_GetDeviceCount();
+			HYPER_CAN_SendData(UNIT_CAN_ID_DIAG, 7, data);
+			return;
+		}
+		HYPER_I2C_DeviceStats_t stats;
+		if(!HYPER_I2C_GetDeviceStats(diag_arg, &stats))
+			return;
+		data[1] = diag_arg;
+		data[2] = (stats.bus << 7) | (stats.address >> 1);
+		data[3] = stats.errors >> 8;
+		data[4] = stats.errors & 0xFF;
+		data[5] = stats.timeouts >> 8;
+		data[6] = stats.timeouts & 0xFF;
+		data[7] = stats.failures;
+		HYPER_CAN_SendData(UNIT_CAN_ID_DIAG, 8, data);
+	}
+}
+
+/**
+ * @brief This function checks if a frame carries a command (a message type in data[0])
+ * @param id The frame's ID
+ * @return true for the frames addressed to this unit, its group or the whole pod, false otherwise
+ */
+static bool HYPER_CAN_IsCommand(uint32_t id) {
+	return id == UNIT_CAN_ID_DATA_IN || id == HYPER_CAN_ID_BROADCAST || id == UNIT_CAN_ID_GROUP;
 }
 
 /**
@@ -109,44 +695,257 @@ static void HYPER_CAN_ProcessFrame(CanRxMsg* msg) {
 	// Check the frame ID
 	if(msg->StdId == UNIT_CAN_ID_DATA_OUT) {
 		// RTR frame - send data out
-		HYPER_CAN_SendData(UNIT_CAN_ID_DATA_OUT, sizeof(unitDataBuffer), (uint8_t *)&unitDataBuffer);
+		HYPER_CAN_SendData(UNIT_CAN_ID_DATA_OUT, sizeof(unit_DataBuffer_t), (uint8_t *)&unitDataSnapshot[unitDataFront]);
 	}
-	else if(msg->StdId == UNIT_CAN_ID_DATA_IN) {
-		// Incoming data frame
+	else if(HYPER_CAN_IsCommand(msg->StdId)) {
+		// Incoming data frame (addressed to this unit, its group or the whole pod)
 		MsgType_t msg_type = msg->Data[0];
 		// Process the basic messages
 		if(msg_type == MSG_START)
 			HYPER_Start();
 		else if(msg_type == MSG_RESET)
 			HYPER_Reset();
+		else if(msg_type == MSG_PUBLISHCONFIG)
+			publishPeriodRequest = (msg->Data[1] << 8) | msg->Data[2];
+		else if(msg_type == MSG_DIAGREQUEST)
+			HYPER_CAN_SendDiag(msg->Data[1], msg->Data[2]);
 		// Pass the message to the unit's processing function
 		UNIT_CAN_ProcessFrame(msg_type, msg->Data);
 	}
+	else if(msg->StdId == HYPER_CAN_ID_SYNCFOLLOWUP && msg->DLC >= 5) {
+		// Pod time of the matching SYNC message
+		uint32_t master_us = ((uint32_t)msg->Data[1] << 24) | ((uint32_t)msg->Data[2] << 16) | (msg->Data[3] << 8) | msg->Data[4];
+		HYPER_Sync_FollowUp(msg->Data[0], master_us);
+	}
 
 	// Update the status LED
 	HYPER_LED_UpdateOK();
 }
 
 /**
- * @brief This function handles CAN1_RX0_IRQ.
+ * @brief This function decides if a received frame has to be processed without waiting for the main loop
+ * @param msg Pointer to the received message
+ * @return true for the data requests and the commands listed in HYPER_CAN_ISR_MESSAGES, false otherwise
  */
-void USB_LP_CAN1_RX0_IRQHandler(void) {
-	if(CAN_GetITStatus(CAN1, CAN_IT_FMP0)) {
+static bool HYPER_CAN_IsUrgent(const CanRxMsg *msg) {
+	// Data requests only queue the reply, so they are answered right away
+	if(msg->StdId == UNIT_CAN_ID_DATA_OUT)
+		return true;
+
+	// Only the command frames carry a message type (eg. data[0] of a FOLLOW-UP is a sequence number)
+	if(!HYPER_CAN_IsCommand(msg->StdId))
+		return false;
+
+	return msg->DLC > 0 && msg->Data[0] < 32 && (HYPER_CAN_ISR_MESSAGES & (1UL << msg->Data[0]));
+}
+
+/**
+ * @brief This function checks if a frame carries a brake command (the commands traced as TRACE_BRAKECMD)
+ * @param msg Pointer to the received message
+ * @return true for MSG_BRAKESHOLD, MSG_BRAKESRELEASE and MSG_BRAKESPOWEROFF in a command frame, false otherwise
+ */
+static bool HYPER_CAN_IsBrakeCommand(const CanRxMsg *msg) {
+	if(!HYPER_CAN_IsCommand(msg->StdId) || msg->DLC == 0)
+		return false;
+	return msg->Data[0] == MSG_BRAKESHOLD || msg->Data[0] == MSG_BRAKESRELEASE || msg->Data[0] == MSG_BRAKESPOWEROFF;
+}
+
+/**
+ * @brief This function drains the given receive FIFO. Urgent frames are processed immediately, the rest is queued for the main loop.
+ * @param fifo The FIFO number (CAN_FIFO0 or CAN_FIFO1)
+ * @param rx_time The local time the interrupt was entered at (in us), used to timestamp the SYNC messages
+ * @param rx_entry The time the interrupt was entered at (in cycles), used to trace the brake command path
+ */
+static void HYPER_CAN_Receive(uint8_t fifo, uint32_t rx_time, uint32_t rx_entry) {
+	while(CAN_MessagePending(CAN1, fifo) > 0) {
 		// Receive the message into a buffer
 		CanRxMsg msg;
-		CAN_Receive(CAN1, CAN_FIFO0, &msg);
-		// Take appropriate action
+		CAN_Receive(CAN1, fifo, &msg);
+
+		if(msg.StdId == HYPER_CAN_ID_SYNC) {
+			HYPER_Sync_Capture(msg.Data[0], rx_time);
+			continue;
+		}
+
+		if(HYPER_CAN_IsUrgent(&msg)) {
+			HYPER_CAN_ProcessFrame(&msg);
+			if(HYPER_CAN_IsBrakeCommand(&msg))
+				HYPER_Trace_Exit(TRACE_BRAKECMD, rx_entry);
+			continue;
+		}
+
+		// Queue the message for the main loop
+		uint8_t count = rxQueueTail - rxQueueHead;
+		if(count == HYPER_CAN_RX_QUEUE_LENGTH) {
+			canStats.rxOverruns++;
+			HYPER_Health_Report(HEALTH_RXOVERRUN);
+			continue;
+		}
+		rxQueue[rxQueueTail % HYPER_CAN_RX_QUEUE_LENGTH] = msg;
+		HYPER_BARRIER();
+		rxQueueTail++;
+
+		if(count + 1 > canStats.rxQueuePeak)
+			canStats.rxQueuePeak = count + 1;
+	}
+}
+
+/**
+ * @brief This function processes the frames queued by the CAN RX interrupts. It should be run in the main loop.
+ */
+void HYPER_CAN_Dispatch(void) {
+	while(rxQueueHead != rxQueueTail) {
+		HYPER_BARRIER();
+		CanRxMsg msg = rxQueue[rxQueueHead % HYPER_CAN_RX_QUEUE_LENGTH];
+		HYPER_BARRIER();
+		// Release the slot before processing, the handlers may take a while
+		rxQueueHead++;
+
 		HYPER_CAN_ProcessFrame(&msg);
 	}
 }
 
 /**
- * @brief This function performs a safe update of the CAN data buffer
+ * @brief This function handles CAN1_RX0_IRQ.
+ */
+void USB_LP_CAN1_RX0_IRQHandler(void) {
+	uint32_t entry = HYPER_Trace_Enter();
+	uint32_t rx_time = HYPER_Delay_GetMicros();
+	if(CAN_GetITStatus(CAN1, CAN_IT_FOV0)) {
+		CAN_ClearITPendingBit(CAN1, CAN_IT_FOV0);
+		canStats.fifoOverruns++;
+		HYPER_Health_Report(HEALTH_FIFOOVERRUN);
+	}
+	HYPER_CAN_Receive(CAN_FIFO0, rx_time, entry);
+	HYPER_Trace_Exit(TRACE_CAN_RX0, entry);
+}
+
+/**
+ * @brief This function handles CAN1_RX1_IRQ.
+ */
+void CAN1_RX1_IRQHandler(void) {
+	// Timestamp the reception as early as possible
+	uint32_t entry = HYPER_Trace_Enter();
+	uint32_t rx_time = HYPER_Delay_GetMicros();
+	if(CAN_GetITStatus(CAN1, CAN_IT_FOV1)) {
+		CAN_ClearITPendingBit(CAN1, CAN_IT_FOV1);
+		canStats.fifoOverruns++;
+		HYPER_Health_Report(HEALTH_FIFOOVERRUN);
+	}
+	HYPER_CAN_Receive(CAN_FIFO1, rx_time, entry);
+	HYPER_Trace_Exit(TRACE_CAN_RX1, entry);
+}
+
+/**
+ * @brief This function handles CAN1_SCE_IRQ (error state changes and bus errors).
+ */
+void CAN1_SCE_IRQHandler(void) {
+	uint32_t entry = HYPER_Trace_Enter();
+	uint32_t esr = CAN1->ESR;
+
+	// Count the error state changes (the flags are cleared by hardware once the bus recovers)
+	uint8_t state = esr & (CAN_ESR_EWGF | CAN_ESR_EPVF | CAN_ESR_BOFF);
+	uint8_t raised = state & ~busErrorState;
+	busErrorState = state;
+	if(raised & CAN_ESR_EWGF)
+		HYPER_Health_Report(HEALTH_ERRORWARNING);
+	if(raised & CAN_ESR_EPVF)
+		HYPER_Health_Report(HEALTH_ERRORPASSIVE);
+	if(raised & CAN_ESR_BOFF)
+		HYPER_Health_Report(HEALTH_BUSOFF);
+
+	// Count the bus error and hold the interrupt off for a while, a faulty bus produces them continuously
+	if(esr & CAN_ESR_LEC) {
+		busLastErrorCode = (esr & CAN_ESR_LEC) >> 4;
+		HYPER_Health_Report(HEALTH_BUSERROR);
+		CAN_ITConfig(CAN1, CAN_IT_LEC, DISABLE);
+		busErrorArmed = false;
+		busErrorTimestamp = HYPER_Delay_GetTime();
+	}
+
+	CAN_ClearITPendingBit(CAN1, CAN_IT_ERR);
+	HYPER_Trace_Exit(TRACE_CAN_SCE, entry);
+}
+
+/**
+ * @brief This function handles CAN1_TX_IRQ.
+ */
+void USB_HP_CAN1_TX_IRQHandler(void) {
+	uint32_t entry = HYPER_Trace_Enter();
+	if(CAN_GetITStatus(CAN1, CAN_IT_TME)) {
+		CAN_ClearITPendingBit(CAN1, CAN_IT_TME);
+		// A mailbox got free, send the next queued frames
+		__disable_irq();
+		HYPER_CAN_TxKick();
+		__enable_irq();
+	}
+	HYPER_Trace_Exit(TRACE_CAN_TX, entry);
+}
+
+/**
+ * @brief This function updates the data record. The new value is sent out after the current main loop pass,
+ * both in the full resolution record and packed into the data frame (@see UNIT_CAN_Pack()).
+ * It must only be called from the main loop (interrupts only ever read the committed snapshots).
  * @param update_func Pointer to the update function
  * @param value_ptr Pointer to the new value
  */
-void HYPER_CAN_Update(void (*update_func)(unit_DataBuffer_t *, void *), void *value_ptr) {
+void HYPER_CAN_Update(void (*update_func)(unit_Record_t *, void *), void *value_ptr) {
+	update_func(&unitRecord, value_ptr);
+}
+
+/**
+ * @brief This function records the acquisition time of a channel group. It should be called right after the group's
+ * sensors are read and must only be called from the main loop.
+ * @param group The channel group (eg. @see unit1_Group_t)
+ */
+void HYPER_CAN_Stamp(uint8_t group) {
+	HYPER_CAN_StampAt(group, HYPER_Delay_GetMicros());
+}
+
+/**
+ * @brief This function records the acquisition time of a channel group read in the background (eg. the time an I2C
+ * transfer completed at, @see HYPER_I2C_Transfer_t). It must only be called from the main loop.
+ * @param group The channel group (eg. @see unit1_Group_t)
+ * @param local_us The local time the sensors were read at (in us, @see HYPER_Delay_GetMicros())
+ */
+void HYPER_CAN_StampAt(uint8_t group, uint32_t local_us) {
+	if(group >= HYPER_CAN_GROUPS)
+		return;
+
+	sampleTime[group] = HYPER_Sync_ToPodTime(local_us);
+	sampleValid |= 1UL << group;
+}
+
+/**
+ * @brief This function marks a channel group as invalid (its sensor stopped responding), the group is reported with
+ * HYPER_SAMPLE_AGE_NONE until it's stamped again. It must only be called from the main loop.
+ * @param group The channel group (eg. @see unit1_Group_t)
+ */
+void HYPER_CAN_Invalidate(uint8_t group) {
+	if(group >= HYPER_CAN_GROUPS)
+		return;
+
+	sampleValid &= ~(1UL << group);
+}
+
+/**
+ * @brief This function reads the CAN controller error state
+ * @param state Pointer to the output structure
+ */
+void HYPER_CAN_GetBusState(HYPER_CAN_BusState_t *state) {
+	uint32_t esr = CAN1->ESR;
+	state->flags = esr & (CAN_ESR_EWGF | CAN_ESR_EPVF | CAN_ESR_BOFF);
+	state->lastErrorCode = busLastErrorCode;
+	state->tec = (esr & CAN_ESR_TEC) >> 16;
+	state->rec = (esr & CAN_ESR_REC) >> 24;
+}
+
+/**
+ * @brief This function copies the CAN interface statistics
+ * @param stats Pointer to the output structure
+ */
+void HYPER_CAN_GetStats(HYPER_CAN_Stats_t *stats) {
 	__disable_irq();
-	update_func(&unitDataBuffer, value_ptr);
+	*stats = canStats;
 	__enable_irq();
 }
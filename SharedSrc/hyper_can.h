@@ -9,6 +9,7 @@
 #define HYPER_CAN_H_
 
 #include "stdint.h"
+#include "stdbool.h"
 #include "hyper_can_frames.h"
 
 /**
@@ -37,7 +38,65 @@ typedef unit5_DataBuffer_t unit_DataBuffer_t;
 typedef unit6_DataBuffer_t unit_DataBuffer_t;
 #endif
 
+/**
+ * @brief Structure type that holds UNIT's full resolution data record, HYPER_CAN_GROUPS is the amount of its channel groups
+ */
+#if defined UNIT_1
+typedef unit1_Record_t unit_Record_t;
+#define HYPER_CAN_GROUPS UNIT1_GROUPS
+#elif defined UNIT_2
+typedef unit2_Record_t unit_Record_t;
+#define HYPER_CAN_GROUPS UNIT2_GROUPS
+#elif defined UNIT_3
+typedef unit3_Record_t unit_Record_t;
+#define HYPER_CAN_GROUPS UNIT3_GROUPS
+#elif defined UNIT_4
+typedef unit4_Record_t unit_Record_t;
+#define HYPER_CAN_GROUPS UNIT3_GROUPS
+#elif defined UNIT_5
+typedef unit5_Record_t unit_Record_t;
+#define HYPER_CAN_GROUPS UNIT5_GROUPS
+#elif defined UNIT_6
+typedef unit6_Record_t unit_Record_t;
+#define HYPER_CAN_GROUPS UNIT6_GROUPS
+#endif
+
+/**
+ * @brief Structure type that holds the CAN interface statistics
+ */
+typedef struct {
+	uint16_t publishPeriod;		/**< The current time between unsolicited data frames (in ms), 0 if the push mode is disabled */
+	uint16_t publishRate;		/**< The amount of scheduled data frames published during the last second (RTR replies excluded) */
+	uint16_t recordRate;		/**< The amount of records (segmented transfers) queued during the last second */
+	uint16_t recordDrops;		/**< The amount of records skipped because the transmit queue had no room for all their segments */
+	uint16_t txOverflows;		/**< The amount of outgoing frames rejected because the transmit queue was full */
+	uint16_t txDrops;			/**< The amount of queued frames discarded to make room for a higher priority frame */
+	uint8_t txQueuePeak;		/**< The highest amount of frames waiting in the transmit queue */
+	uint16_t rxOverruns;		/**< The amount of incoming frames lost because the receive queue was full */
+	uint16_t fifoOverruns;		/**< The amount of incoming frames lost because a hardware receive FIFO was full */
+	uint8_t rxQueuePeak;		/**< The highest amount of frames waiting in the receive queue */
+} HYPER_CAN_Stats_t;
+
+/**
+ * @brief Structure type that holds the CAN controller error state
+ */
+typedef struct {
+	uint8_t flags;				/**< Bus state (bit0 - error warning, bit1 - error passive, bit2 - bus-off) */
+	uint8_t lastErrorCode;		/**< The latest bus error code (1 - stuff, 2 - form, 3 - ACK, 4 - recessive bit, 5 - dominant bit, 6 - CRC) */
+	uint8_t tec;				/**< Transmit error counter */
+	uint8_t rec;				/**< Receive error counter */
+} HYPER_CAN_BusState_t;
+
 void HYPER_CAN_Init(void);
-void HYPER_CAN_Update(void (*update_func)(unit_DataBuffer_t *, void *), void *value_ptr);
+void HYPER_CAN_Tick(void);
+void HYPER_CAN_Dispatch(void);
+void HYPER_CAN_Update(void (*update_func)(unit_Record_t *, void *), void *value_ptr);
+void HYPER_CAN_Stamp(uint8_t group);
+void HYPER_CAN_StampAt(uint8_t group, uint32_t local_us);
+void HYPER_CAN_Invalidate(uint8_t group);
+bool HYPER_CAN_SendSegmented(const uint32_t id, const uint16_t length, const uint8_t *data_ptr);
+void HYPER_CAN_GetStats(HYPER_CAN_Stats_t *stats);
+void HYPER_CAN_GetBusState(HYPER_CAN_BusState_t *state);
+bool HYPER_CAN_SendData(const uint32_t id, const uint8_t data_length, const uint8_t* data_ptr);
 
 #endif /* HYPER_CAN_H_ */
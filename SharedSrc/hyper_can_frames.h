@@ -16,7 +16,7 @@ typedef struct {
 	uint8_t vl6180xDistance2	: 8;	/**< Distance reading from distance sensor 2 (VL6180X) */
 	uint8_t vl6180xDistance3	: 8;	/**< Distance reading from distance sensor 3 (VL6180X) */
 	uint8_t vl6180xDistance4	: 8;	/**< Distance reading from distance sensor 4 (VL6180X) */
-	uint16_t pitotPressure		: 16;	/**< Pressure reading from the Pitot sensor */
+	int16_t pitotPressure		: 16;	/**< Pressure reading from the Pitot sensor in 0.1Pa */
 	uint8_t lm35Temperature		: 8;	/**< Temperature reading from LM35 sensor */
 	uint8_t tmp102Tmperature	: 8;	/**< Temperature reading from TMP-102 sensor */
 } __attribute__((__packed__)) unit1_DataBuffer_t;
@@ -70,6 +70,248 @@ typedef struct {
 	uint8_t brakesState			: 1;	/**< Brakes state */
 } __attribute__((__packed__)) unit6_DataBuffer_t;
 
+#define HYPER_SAMPLE_AGE_NONE	0xFFFF	/**< Sample age of the channel groups that were never sampled, are invalid (their sensor stopped responding) or were sampled longer ago than 6.5s */
+
+/**
+ * @brief UNIT1 channel groups, each one has its own acquisition time in the record
+ */
+typedef enum {
+	UNIT1_GROUP_VL6180X_1 = 0,		/**< Distance sensor 1 */
+	UNIT1_GROUP_VL6180X_2,			/**< Distance sensor 2 */
+	UNIT1_GROUP_VL6180X_3,			/**< Distance sensor 3 */
+	UNIT1_GROUP_VL6180X_4,			/**< Distance sensor 4 */
+	UNIT1_GROUP_PITOT,				/**< Pitot sensor */
+	UNIT1_GROUP_LM35,				/**< LM35 sensor */
+	UNIT1_GROUP_TMP102,				/**< TMP-102 sensor */
+	UNIT1_GROUP_AIRSPEED,			/**< Airspeed (computed from the Pitot and TMP-102 sensors) */
+	UNIT1_GROUPS					/**< The amount of the channel groups */
+} unit1_Group_t;
+
+/**
+ * @brief UNIT2 channel groups, each one has its own acquisition time in the record
+ */
+typedef enum {
+	UNIT2_GROUP_VL6180X_1 = 0,		/**< Distance sensor 1 */
+	UNIT2_GROUP_VL6180X_2,			/**< Distance sensor 2 */
+	UNIT2_GROUP_VL6180X_3,			/**< Distance sensor 3 */
+	UNIT2_GROUP_VL6180X_4,			/**< Distance sensor 4 */
+	UNIT2_GROUP_PYRO,				/**< MLX90614 pyrometer */
+	UNIT2_GROUP_LM35,				/**< LM35 sensor */
+	UNIT2_GROUP_TCOUPLE,			/**< Thermocouple (MAX6675) */
+	UNIT2_GROUP_VOLTAGE12V,			/**< 12V rail voltage */
+	UNIT2_GROUPS					/**< The amount of the channel groups */
+} unit2_Group_t;
+
+/**
+ * @brief UNIT3 channel groups, each one has its own acquisition time in the record
+ */
+typedef enum {
+	UNIT3_GROUP_STRIPES = 0,		/**< Linear encoder */
+	UNIT3_GROUP_ENCODER,			/**< Encoder */
+	UNIT3_GROUPS					/**< The amount of the channel groups */
+} unit3_Group_t;
+
+/**
+ * @brief UNIT4 channel groups (same as for UNIT3)
+ */
+typedef unit3_Group_t unit4_Group_t;
+
+/**
+ * @brief UNIT5 channel groups, each one has its own acquisition time in the record
+ */
+typedef enum {
+	UNIT5_GROUP_VL6180X_1 = 0,		/**< Distance sensor 1 */
+	UNIT5_GROUP_VL6180X_2,			/**< Distance sensor 2 */
+	UNIT5_GROUP_VL6180X_3,			/**< Distance sensor 3 */
+	UNIT5_GROUP_VL6180X_4,			/**< Distance sensor 4 */
+	UNIT5_GROUP_PYRO,				/**< MLX90614 pyrometer */
+	UNIT5_GROUP_VOLTAGE12V,			/**< 12V rail voltage */
+	UNIT5_GROUP_CURRENT,			/**< Current sensor */
+	UNIT5_GROUP_BATTERY,			/**< Battery voltage */
+	UNIT5_GROUPS					/**< The amount of the channel groups */
+} unit5_Group_t;
+
+/**
+ * @brief UNIT6 channel groups, each one has its own acquisition time in the record
+ */
+typedef enum {
+	UNIT6_GROUP_BRAKES = 0,			/**< Brakes and their lock state */
+	UNIT6_GROUPS					/**< The amount of the channel groups */
+} unit6_Group_t;
+
+/**
+ * @brief Structure type that holds the full resolution UNIT1 data record (segmented transfer)
+ */
+typedef struct {
+	uint32_t timestamp;				/**< Pod time the record was sent at (in us) */
+	uint16_t sampleAge[UNIT1_GROUPS];	/**< Age of each channel group at the record timestamp (in 0.1ms, HYPER_SAMPLE_AGE_NONE if never sampled or invalid) @see unit1_Group_t */
+	uint8_t vl6180xDistance1;		/**< Distance reading from distance sensor 1 (VL6180X) in mm */
+	uint8_t vl6180xDistance2;		/**< Distance reading from distance sensor 2 (VL6180X) in mm */
+	uint8_t vl6180xDistance3;		/**< Distance reading from distance sensor 3 (VL6180X) in mm */
+	uint8_t vl6180xDistance4;		/**< Distance reading from distance sensor 4 (VL6180X) in mm */
+	int16_t pitotPressure;			/**< Pressure reading from the Pitot sensor in 0.1Pa (moving average) */
+	uint16_t airspeed;				/**< Airspeed computed from the Pitot pressure in 0.01m/s */
+	uint16_t lm35Temperature;		/**< Temperature reading from LM35 sensor in 0.1°C */
+	int16_t tmp102Temperature;		/**< Temperature reading from TMP-102 sensor in 0.0625°C */
+} __attribute__((__packed__)) unit1_Record_t;
+
+/**
+ * @brief Structure type that holds the full resolution UNIT2 data record (segmented transfer)
+ */
+typedef struct {
+	uint32_t timestamp;				/**< Pod time the record was sent at (in us) */
+	uint16_t sampleAge[UNIT2_GROUPS];	/**< Age of each channel group at the record timestamp (in 0.1ms, HYPER_SAMPLE_AGE_NONE if never sampled or invalid) @see unit2_Group_t */
+	uint8_t vl6180xDistance1;		/**< Distance reading from distance sensor 1 (VL6180X) in mm */
+	uint8_t vl6180xDistance2;		/**< Distance reading from distance sensor 2 (VL6180X) in mm */
+	uint8_t vl6180xDistance3;		/**< Distance reading from distance sensor 3 (VL6180X) in mm */
+	uint8_t vl6180xDistance4;		/**< Distance reading from distance sensor 4 (VL6180X) in mm */
+	uint16_t pyroTemperature;		/**< Temperature reading from MLX90614 pyrometer in 0.02K */
+	uint16_t pyroTemperature2;		/**< Temperature reading from MLX90614 pyrometer's 2nd zone in 0.02K */
+	uint16_t pyroAmbient;			/**< Ambient (sensor die) temperature reading from MLX90614 pyrometer in 0.02K */
+	uint16_t lm35Temperature;		/**< Temperature reading from LM35 sensor in 0.1°C */
+	uint16_t tCoupleTemperature;	/**< Temperature reading from thermocouple (MAX6675) in 0.25°C, 0xFFFF if the thermocouple is open */
+	uint16_t voltage12V;			/**< 12V rail voltage reading in mV */
+	uint8_t brakesState;			/**< Brakes state */
+} __attribute__((__packed__)) unit2_Record_t;
+
+/**
+ * @brief Structure type that holds the full resolution UNIT3 data record (segmented transfer)
+ */
+typedef struct {
+	uint32_t timestamp;				/**< Pod time the record was sent at (in us) */
+	uint16_t sampleAge[UNIT3_GROUPS];	/**< Age of each channel group at the record timestamp (in 0.1ms, HYPER_SAMPLE_AGE_NONE if never sampled or invalid) @see unit3_Group_t */
+	uint32_t stripesCounter;		/**< Linear encoder value (stripes counter) */
+	int32_t encoderPos;				/**< Encoder position */
+} __attribute__((__packed__)) unit3_Record_t;
+
+/**
+ * @brief Structure type that holds the full resolution UNIT4 data record (same as for UNIT3)
+ */
+typedef unit3_Record_t unit4_Record_t;
+
+/**
+ * @brief Structure type that holds the full resolution UNIT5 data record (segmented transfer)
+ */
+typedef struct {
+	uint32_t timestamp;				/**< Pod time the record was sent at (in us) */
+	uint16_t sampleAge[UNIT5_GROUPS];	/**< Age of each channel group at the record timestamp (in 0.1ms, HYPER_SAMPLE_AGE_NONE if never sampled or invalid) @see unit5_Group_t */
+	uint8_t vl6180xDistance1;		/**< Distance reading from distance sensor 1 (VL6180X) in mm */
+	uint8_t vl6180xDistance2;		/**< Distance reading from distance sensor 2 (VL6180X) in mm */
+	uint8_t vl6180xDistance3;		/**< Distance reading from distance sensor 3 (VL6180X) in mm */
+	uint8_t vl6180xDistance4;		/**< Distance reading from distance sensor 4 (VL6180X) in mm */
+	uint16_t pyroTemperature;		/**< Temperature reading from MLX90614 pyrometer in 0.02K */
+	uint16_t pyroTemperature2;		/**< Temperature reading from MLX90614 pyrometer's 2nd zone in 0.02K */
+	uint16_t pyroAmbient;			/**< Ambient (sensor die) temperature reading from MLX90614 pyrometer in 0.02K */
+	uint16_t voltage12V;			/**< 12V rail voltage reading in mV */
+	int16_t current;				/**< Current sensor reading in 0.01A */
+	uint16_t voltageBattery;		/**< Battery voltage reading in mV */
+} __attribute__((__packed__)) unit5_Record_t;
+
+/**
+ * @brief Structure type that holds the full resolution UNIT6 data record (segmented transfer)
+ */
+typedef struct {
+	uint32_t timestamp;				/**< Pod time the record was sent at (in us) */
+	uint16_t sampleAge[UNIT6_GROUPS];	/**< Age of each channel group at the record timestamp (in 0.1ms, HYPER_SAMPLE_AGE_NONE if never sampled or invalid) @see unit6_Group_t */
+	uint8_t brakesState;			/**< Brakes state */
+	uint8_t brakesLocked;			/**< Brakes lock state (unit 6 watchdog) */
+} __attribute__((__packed__)) unit6_Record_t;
+
+/**
+ * @brief Types of the frames sent on UNIT_CAN_ID_ERROR (stored in data[0])
+ */
+typedef enum {
+	ERROR_HEALTH = 0,			/**< Periodic health report (data[1] - bus state: bit0 error warning, bit1 error passive, bit2 bus-off,
+								data[2] - last error code, data[3] - TEC, data[4] - REC, data[5] - longest loop pass in ms, data[6..7] - total error events) */
+	ERROR_EVENT					/**< Error event report (data[1] - @see HealthEvent_t, data[2..3] - total count, data[4..5] - count since the previous report) */
+} ErrorType_t;
+
+/**
+ * @brief Error events counted by the units and reported on UNIT_CAN_ID_ERROR
+ */
+typedef enum {
+	HEALTH_BUSERROR = 0,		/**< CAN bus error (stuff, form, ACK, bit or CRC error), counted once per HYPER_CAN_BUSERROR_HOLDOFF */
+	HEALTH_ERRORWARNING,		/**< CAN error counters reached the warning level (96) */
+	HEALTH_ERRORPASSIVE,		/**< CAN controller entered the error passive state */
+	HEALTH_BUSOFF,				/**< CAN controller entered the bus-off state (recovered automatically) */
+	HEALTH_FIFOOVERRUN,			/**< Incoming frame lost because a hardware receive FIFO was full */
+	HEALTH_RXOVERRUN,			/**< Incoming frame lost because the receive queue was full */
+	HEALTH_TXOVERFLOW,			/**< Outgoing frame lost because the transmit queue was full */
+	HEALTH_I2CFAILURE,			/**< I2C transfer failure */
+	HEALTH_LOOPOVERRUN,			/**< Main loop pass took longer than HYPER_HEALTH_LOOP_MAX */
+	HEALTH_WATCHDOGRESET,		/**< The unit was reset by the independent watchdog */
+	HEALTH_DEADLINEMISS,		/**< A scheduled task completed after its deadline */
+	HEALTH_EVENTS				/**< The amount of the event types */
+} HealthEvent_t;
+
+/**
+ * @brief Bus-wide message IDs (sent by the central node to all the units)
+ */
+#define HYPER_CAN_ID_SYNC			10		/**< Time synchronization (data[0] - sequence number), sent periodically */
+#define HYPER_CAN_ID_SYNCFOLLOWUP	11		/**< Sent right after each SYNC (data[0] - sequence number, data[1..4] - pod time of the SYNC transmission in us) */
+#define HYPER_CAN_ID_BROADCAST		20		/**< Pod-wide commands, accepted by all the units (same format as UNIT_CAN_ID_DATA_IN) */
+#define HYPER_CAN_ID_GROUP_BRAKES	21		/**< Commands for all the brake units - 2 and 6 (same format as UNIT_CAN_ID_DATA_IN) */
+
+/**
+ * @brief Segmented transfers, used for the records that don't fit in a single frame.
+ * Every frame starts with a header byte (last flag, sequence number, segment index) followed by up to 7 payload bytes.
+ */
+#define HYPER_SEGMENT_PAYLOAD		7		/**< The amount of payload bytes carried by a single segment */
+#define HYPER_SEGMENT_MAX			16		/**< The maximum amount of segments in a single transfer */
+#define HYPER_SEGMENT_INDEX_MASK	0x0F	/**< Header bits holding the segment index (0..15) */
+#define HYPER_SEGMENT_SEQ_SHIFT		4		/**< Position of the transfer sequence number in the header */
+#define HYPER_SEGMENT_SEQ_MASK		0x07	/**< Mask of the transfer sequence number (0..7, after shifting) */
+#define HYPER_SEGMENT_LAST			0x80	/**< Header bit marking the last segment of a transfer */
+
+/**
+ * @brief Profiler histograms - bucket 0 counts the durations below 2^(HYPER_PROFILE_BUCKET_SHIFT + 1) cycles,
+ * each next bucket doubles the range, the last one counts everything above
+ */
+#define HYPER_PROFILE_BUCKETS		16		/**< The amount of histogram buckets */
+#define HYPER_PROFILE_BUCKET_SHIFT	6		/**< log2 of the upper bound of bucket 0 (in cycles) minus 1 */
+
+/**
+ * @brief This enum represents the profiled stages of the main loop
+ */
+typedef enum {
+	PROFILE_LOOP = 0,			/**< The whole main loop pass */
+	PROFILE_SCHED,				/**< All the scheduled tasks of a pass */
+	PROFILE_CAN,				/**< CAN interface processing (HYPER_CAN_Tick()) */
+	PROFILE_HEALTH,				/**< Health monitoring (HYPER_Health_Tick()) */
+	PROFILE_TASKS				/**< The first scheduled task, the next ones follow in the unit's task table order */
+} HYPER_Profile_Slot_t;
+
+/**
+ * @brief Structure type that holds a profiler report, sent with UNIT_CAN_ID_PROFILE as a segmented transfer
+ */
+typedef struct {
+	uint8_t slot;								/**< The profiled stage @see HYPER_Profile_Slot_t */
+	uint8_t clockMHz;							/**< The CPU clock (cycles per microsecond) */
+	uint32_t count;								/**< The amount of samples since the latest reset */
+	uint16_t rate;								/**< The amount of samples per second since the latest reset */
+	uint32_t min;								/**< The shortest duration (in cycles) */
+	uint32_t max;								/**< The longest duration (in cycles) */
+	uint32_t mean;								/**< The mean duration (in cycles) */
+	uint16_t histogram[HYPER_PROFILE_BUCKETS];	/**< The log2 histogram of the durations (saturates at 0xFFFF) */
+} __attribute__((__packed__)) HYPER_Profile_Report_t;
+
+/**
+ * @brief This enum represents the traced interrupt vectors (and the brake command path)
+ */
+typedef enum {
+	TRACE_SYSTICK = 0,			/**< SysTick_Handler (the latency is measured from the counter reload) */
+	TRACE_CAN_RX0,				/**< CAN1 RX0 interrupt */
+	TRACE_CAN_RX1,				/**< CAN1 RX1 interrupt (time synchronization) */
+	TRACE_CAN_TX,				/**< CAN1 TX interrupt */
+	TRACE_CAN_SCE,				/**< CAN1 status change and error interrupt */
+	TRACE_BUTTONS,				/**< EXTI0..2 interrupts (unit 6 brakes buttons) */
+	TRACE_ENCODER,				/**< TIM3 interrupt (units 3 and 4 angular encoder) */
+	TRACE_BRAKECMD,				/**< From the CAN RX interrupt entry until a brake command (hold, release or poweroff) is applied */
+	TRACE_RANGE,				/**< EXTI interrupts of the VL6180X sensors (units 1, 2 and 5 sample ready) */
+	TRACE_I2C,					/**< I2C event, error and read DMA interrupts (both buses) */
+	TRACE_VECTORS				/**< The amount of the traced vectors */
+} HYPER_Trace_Vector_t;
+
 /**
  * @brief This enum represents the possible incoming messages
  */
@@ -81,6 +323,35 @@ typedef enum {
 	MSG_BRAKESHOLD,				/**< Brakes hold message (unit 2 and 6 only) */
 	MSG_BRAKESRELEASE,			/**< Brakes release message (unit 2 and 6 only) */
 	MSG_BRAKESPOWEROFF,			/**< Brakes poweroff message (unit 2 and 6 only) */
-	MSG_BRAKESLOCKUPDATE		/**< Brakes lock time update (unit 6 only) */
+	MSG_BRAKESLOCKUPDATE,		/**< Brakes lock time update (unit 6 only) */
+	MSG_PUBLISHCONFIG,			/**< Data publish period update (data[1..2] - period in ms, 0 - RTR requests only) */
+	MSG_DIAGREQUEST,			/**< Diagnostic report request (data[1] - requested report @see DiagType_t) */
+	MSG_RANGECONFIG,			/**< VL6180X ranging configuration (units 1, 2 and 5 only) (data[1] - mode: 0 - continuous, 1 - round-robin, data[2] - max convergence time in ms (1..63), data[3] - readout averaging period) */
+	MSG_TUBEPRESSURE			/**< Tube static pressure update, used for the airspeed (unit 1 only) (data[1..3] - pressure in Pa) */
 } MsgType_t;
+
+/**
+ * @brief This enum represents the possible diagnostic reports, sent with UNIT_CAN_ID_DIAG
+ */
+typedef enum {
+	DIAG_PUBLISHRATE = 0,		/**< Publish period and the achieved publish rate (data[1..2] - period in ms, data[3..4] - frames per second, data[5..6] - records per second) */
+	DIAG_TXQUEUE,				/**< Transmit queue statistics (data[1..2] - overflows, data[3..4] - drops, data[5] - peak length) */
+	DIAG_RXQUEUE,				/**< Receive queue statistics (data[1..2] - queue overruns, data[3..4] - FIFO overruns, data[5] - peak length) */
+	DIAG_SYNC,					/**< Time synchronization state (data[1..4] - latest offset in us (signed), data[5..6] - jitter in us, data[7] - locked) */
+	DIAG_SYNCRATE,				/**< Clock servo state (data[1..4] - drift compensation in ppb (signed), data[5..6] - steps, data[7] - missed follow-ups) */
+	DIAG_TASK,					/**< Scheduled task statistics, request data[2] - task index (data[1] - task index, data[2..3] - runs, data[4..5] - deadline misses, data[6..7] - longest response in ms) */
+	DIAG_PROFILE,				/**< Profiler report of a stage, request data[2] - the stage, answered with UNIT_CAN_ID_PROFILE @see HYPER_Profile_Report_t */
+	DIAG_PROFILERESET,			/**< Profiler statistics reset (no answer), request data[2] - the stage, 0xFF - all the stages */
+	DIAG_TRACE,					/**< Interrupt trace of a vector, request data[2] - the vector @see HYPER_Trace_Vector_t, 0xFF - reset all the traces (no answer)
+								(data[1] - the vector, data[2..3] - count, data[4..5] - worst-case duration in cycles, data[6..7] - worst-case entry latency in cycles) */
+	DIAG_BOOT,					/**< Startup timing, request data[2] - 0xFF: the phases (data[1..2] - UNIT_Init() done, data[3..4] - started, data[5..6] - initialization complete, data[7] - amount of steps),
+								otherwise the step index (data[1] - step index, data[2..3] - step complete), all the times in ms since the reset, 0xFFFF - not reached yet @see hyper_boot.h */
+	DIAG_I2C,					/**< I2C failure statistics, request data[2] - 0xFF: the buses (data[1] - 0xFF, data[2..3] - I2C1 recoveries, data[4..5] - I2C2 recoveries, data[6] - amount of devices),
+								otherwise the device index (data[1] - device index, data[2] - bus << 7 | 7-bit address, data[3..4] - errors, data[5..6] - timeouts, data[7] - consecutive failures) @see hyper_i2c.h */
+	DIAG_RANGE,					/**< VL6180X fetch statistics (units 1, 2 and 5 only), request data[2] - sensor ID (data[1] - sensor ID, data[2..4] - samples, data[5..7] - I2C transactions),
+								0xFF - the initialization (data[1] - 0xFF, data[2..5] - bus time of all the sensors in us, data[6..7] - settings read back wrong) */
+	DIAG_RANGERATE,				/**< VL6180X sample rates (units 1, 2 and 5 only) (data[1..4] - samples per second of sensors 1..4, data[5] - ranging mode, data[6] - max convergence time in ms, data[7] - readout averaging period) @see MSG_RANGECONFIG */
+	DIAG_PITOT					/**< Pitot acquisition statistics (unit 1 only) (data[1..4] - samples, data[5..6] - samples per second) */
+} DiagType_t;
+
 #endif /* HYPER_CAN_FRAMES_H_ */
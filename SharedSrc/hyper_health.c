@@ -0,0 +1,161 @@
+/**
+ * @file hyper_health.c
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the unit health monitoring functions. Error events (bus errors, lost frames, I2C failures,
+ * loop overruns) are counted and reported on UNIT_CAN_ID_ERROR, together with a periodic health frame.
+ */
+
+#include "stm32f10x.h"
+#include "hyper_health.h"
+#include "hyper_can.h"
+#include "hyper_unit_defs.h"
+#include "hyper_settings.h"
+#include "hyper_utils.h"
+
+/**
+ * @brief Error event counters (saturating), incremented from anywhere through HYPER_Health_Report()
+ */
+static volatile uint16_t healthCounters[HEALTH_EVENTS] = {0};
+
+/**
+ * @brief Error event counters as of their latest report
+ */
+static uint16_t reportedCounters[HEALTH_EVENTS] = {0};
+
+/**
+ * @brief The event type checked first when sending the next error frame (round robin)
+ */
+static uint8_t reportNext = 0;
+
+/**
+ * @brief The timestamp of the latest error frame
+ */
+static uint32_t errorTimestamp = 0;
+
+/**
+ * @brief The timestamp of the latest health frame
+ */
+static uint32_t healthTimestamp = 0;
+
+/**
+ * @brief The timestamp of the previous HYPER_Health_Tick() call
+ */
+static uint32_t loopTimestamp = 0;
+
+/**
+ * @brief The longest main loop pass since the latest health frame (in ms)
+ */
+static uint32_t loopMax = 0;
+
+/**
+ * @brief This function counts an error event. It may be called from anywhere, including critical sections.
+ * @param event The event type @see HealthEvent_t
+ */
+void HYPER_Health_Report(HealthEvent_t event) {
+	if(event >= HEALTH_EVENTS)
+		return;
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	if(healthCounters[event] != 0xFFFF)
+		healthCounters[event]++;
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @brief This function returns the amount of the given error events
+ * @param event The event type @see HealthEvent_t
+ * @return The amount of events (saturates at 0xFFFF)
+ */
+uint16_t HYPER_Health_GetCount(HealthEvent_t event) {
+	if(event >= HEALTH_EVENTS)
+		return 0;
+
+	return healthCounters[event];
+}
+
+/**
+ * @brief This function sends the error frame of the first event type whose counter changed since its latest report
+ */
+static void HYPER_Health_SendEvent(void) {
+	for(uint8_t i = 0; i < HEALTH_EVENTS; i++) {
+		uint8_t event = (reportNext + i) % HEALTH_EVENTS;
+		uint16_t count = healthCounters[event];
+		if(count == reportedCounters[event])
+			continue;
+
+		uint16_t count_new = count - reportedCounters[event];
+		uint8_t data[6];
+		data[0] = ERROR_EVENT;
+		data[1] = event;
+		data[2] = count >> 8;
+		data[3] = count & 0xFF;
+		data[4] = count_new >> 8;
+		data[5] = count_new & 0xFF;
+		HYPER_CAN_SendData(UNIT_CAN_ID_ERROR, 6, data);
+
+		reportedCounters[event] = count;
+		reportNext = (event + 1) % HEALTH_EVENTS;
+		errorTimestamp = HYPER_Delay_GetTime();
+		return;
+	}
+}
+
+/**
+ * @brief This function sends the health frame (CAN bus state and error totals)
+ */
+static void HYPER_Health_SendHealth(void) {
+	HYPER_CAN_BusState_t bus_state;
+	HYPER_CAN_GetBusState(&bus_state);
+
+	uint32_t total = 0;
+	for(uint8_t event = 0; event < HEALTH_EVENTS; event++)
+		total += healthCounters[event];
+	if(total > 0xFFFF)
+		total = 0xFFFF;
+
+	uint8_t data[8];
+	data[0] = ERROR_HEALTH;
+	data[1] = bus_state.flags;
+	data[2] = bus_state.lastErrorCode;
+	data[3] = bus_state.tec;
+	data[4] = bus_state.rec;
+	data[5] = loopMax > 255 ? 255 : loopMax;
+	data[6] = total >> 8;
+	data[7] = total & 0xFF;
+	HYPER_CAN_SendData(UNIT_CAN_ID_ERROR, 8, data);
+}
+
+/**
+ * @brief This function measures the main loop pass time and sends the rate-limited error and health frames. It should be run in the main loop.
+ */
+void HYPER_Health_Tick(void) {
+	static bool started = false;
+	uint32_t now = HYPER_Delay_GetTime();
+
+	// Measure the loop pass time (the first pass includes the initialization, so it doesn't count)
+	uint32_t loop_time = now - loopTimestamp;
+	loopTimestamp = now;
+	if(started) {
+		if(loop_time > HYPER_HEALTH_LOOP_MAX)
+			HYPER_Health_Report(HEALTH_LOOPOVERRUN);
+		if(loop_time > loopMax)
+			loopMax = loop_time;
+	}
+	started = true;
+
+	// Report the new error events, one frame per HYPER_HEALTH_ERROR_INTERVAL at most
+	if(HYPER_Delay_Check(errorTimestamp, HYPER_HEALTH_ERROR_INTERVAL))
+		HYPER_Health_SendEvent();
+
+#if HYPER_HEALTH_PERIOD
+	if(HYPER_Delay_Check(healthTimestamp, HYPER_HEALTH_PERIOD)) {
+		HYPER_Health_SendHealth();
+		loopMax = 0;
+
+		// Update the time stamp
+		healthTimestamp = now;
+	}
+#endif
+}
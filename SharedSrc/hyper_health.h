@@ -0,0 +1,18 @@
+/**
+ * @file hyper_health.h
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the headers of the unit health monitoring functions
+ */
+
+#ifndef HYPER_HEALTH_H_
+#define HYPER_HEALTH_H_
+
+#include <stdint.h>
+#include "hyper_can_frames.h"
+
+void HYPER_Health_Report(HealthEvent_t event);
+uint16_t HYPER_Health_GetCount(HealthEvent_t event);
+void HYPER_Health_Tick(void);
+
+#endif /* HYPER_HEALTH_H_ */
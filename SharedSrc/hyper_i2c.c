@@ -0,0 +1,668 @@
+/**
+ * @file hyper_i2c.c
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the asynchronous I2C master driver. The sensor drivers queue transfer descriptors,
+ * each bus runs them one after another from its event and error interrupts, the data is moved by DMA
+ * (except for single byte reads). The completion is signaled through the descriptor's status and callback.
+ * Nothing waits without a bound: a transfer that doesn't complete in HYPER_I2C_TIMEOUT is aborted, and a stuck bus
+ * is recovered (SCL clocked until the devices release SDA, STOP, peripheral reset). The failures are counted per device.
+ * The driver owns the buses: the device drivers only add their devices with their maximum SCL frequencies, each transfer
+ * runs at its device's frequency (the bus timing is switched between the transfers when needed).
+ */
+
+#include "stm32f10x.h"
+#include "hyper_i2c.h"
+#include "hyper_settings.h"
+#include "hyper_trace.h"
+#include "hyper_health.h"
+#include "hyper_utils.h"
+
+/**
+ * @brief Structure type that holds the peripherals of a bus
+ */
+typedef struct {
+	I2C_TypeDef *i2c;				/**< The I2C peripheral */
+	uint32_t rcc;					/**< The I2C peripheral's RCC clock (APB1) */
+	uint16_t scl;					/**< The SCL pin (GPIOB) */
+	uint16_t sda;					/**< The SDA pin (GPIOB) */
+	DMA_Channel_TypeDef *dmaTX;		/**< The DMA channel of the writes */
+	DMA_Channel_TypeDef *dmaRX;		/**< The DMA channel of the reads */
+	uint32_t dmaRXFlags;			/**< The interrupt flags of the read DMA channel (DMA1->IFCR mask) */
+	IRQn_Type irqEV;				/**< The I2C event interrupt */
+	IRQn_Type irqER;				/**< The I2C error interrupt */
+	IRQn_Type irqDMA;				/**< The read DMA channel's interrupt */
+} HYPER_I2C_Periph_t;
+
+/**
+ * @brief Structure type that holds the state of a bus
+ */
+typedef struct {
+	HYPER_I2C_Transfer_t *volatile head;	/**< The transfer in progress, followed by the queued ones */
+	HYPER_I2C_Transfer_t *volatile tail;	/**< The last queued transfer */
+	volatile bool busy;						/**< The head transfer is in progress */
+	volatile bool receiving;				/**< The head transfer is in its read phase */
+	uint32_t startTime;						/**< The time the head transfer was started at (in ms) */
+	uint16_t recoveries;					/**< The amount of bus recoveries (saturates at 0xFFFF) */
+	bool initialized;						/**< The bus is set up */
+} HYPER_I2C_State_t;
+
+/**
+ * @brief The peripherals of each bus
+ */
+static const HYPER_I2C_Periph_t i2cPeriph[HYPER_I2C_BUSES] = {
+	{I2C1, RCC_APB1Periph_I2C1, GPIO_Pin_6, GPIO_Pin_7, DMA1_Channel6, DMA1_Channel7, DMA_IFCR_CGIF7, I2C1_EV_IRQn, I2C1_ER_IRQn, DMA1_Channel7_IRQn},
+	{I2C2, RCC_APB1Periph_I2C2, GPIO_Pin_10, GPIO_Pin_11, DMA1_Channel4, DMA1_Channel5, DMA_IFCR_CGIF5, I2C2_EV_IRQn, I2C2_ER_IRQn, DMA1_Channel5_IRQn}
+};
+
+/**
+ * @brief The state of each bus
+ */
+static HYPER_I2C_State_t i2cState[HYPER_I2C_BUSES] = {{0}};
+
+/**
+ * @brief Structure type that holds a device's timing and statistics
+ */
+typedef struct {
+	HYPER_I2C_DeviceStats_t stats;	/**< The failure statistics */
+	uint16_t ccr;					/**< The I2C_CCR value of the device's SCL frequency */
+	uint16_t trise;					/**< The I2C_TRISE value of the device's SCL frequency */
+} HYPER_I2C_Device_t;
+
+/**
+ * @brief The devices, added by their drivers (or registered by their first transfer). Updated with the bus' interrupts masked.
+ */
+static HYPER_I2C_Device_t i2cDevices[HYPER_I2C_MAX_DEVICES] = {{{0}}};
+
+/**
+ * @brief The timing of HYPER_I2C_DEFAULT_SPEED, used by the devices that weren't added by their drivers
+ */
+static HYPER_I2C_Device_t i2cDefaultTiming = {{0}};
+
+/**
+ * @brief The amount of the registered devices
+ */
+static uint8_t i2cDeviceCount = 0;
+
+static void HYPER_I2C_Init(HYPER_I2C_Bus_t bus);
+static void HYPER_I2C_Timing(uint32_t clock_speed, HYPER_I2C_Device_t *device);
+static uint8_t HYPER_I2C_FindDevice(HYPER_I2C_Bus_t bus, uint8_t address);
+static void HYPER_I2C_Setup(HYPER_I2C_Bus_t bus);
+static void HYPER_I2C_Recover(HYPER_I2C_Bus_t bus);
+static void HYPER_I2C_Start(HYPER_I2C_Bus_t bus);
+static void HYPER_I2C_Complete(HYPER_I2C_Bus_t bus, HYPER_I2C_Status_t status);
+
+/**
+ * @brief This function masks the I2C interrupts (through BASEPRI, with the other HYPER_IRQ_PRIORITY_I2C and lower
+ * priority ones), the CAN RX and SysTick interrupts keep running. The I2C functions must not be run from the interrupts
+ * of a higher priority.
+ * @return The previous mask, to be passed to HYPER_I2C_Unlock()
+ */
+static inline uint32_t HYPER_I2C_Lock(void) {
+	uint32_t basepri = __get_BASEPRI();
+	uint32_t mask = HYPER_IRQ_PRIORITY_I2C << (8 - __NVIC_PRIO_BITS);
+	if(basepri == 0 || basepri > mask)
+		__set_BASEPRI(mask);
+	return basepri;
+}
+
+/**
+ * @brief This function restores the interrupt mask
+ * @param basepri The mask returned by HYPER_I2C_Lock()
+ */
+static inline void HYPER_I2C_Unlock(uint32_t basepri) {
+	__set_BASEPRI(basepri);
+}
+
+/**
+ * @brief This function adds a device to a bus. It should be run by the device's driver before its first transfer, the bus is set up by the first call.
+ * @param bus The bus @see HYPER_I2C_Bus_t
+ * @param address The device's I2C address (shifted left)
+ * @param clock_speed The device's maximum SCL frequency (in Hz, limited to HYPER_I2C_MAX_SPEED)
+ * @return true if the device was added, false otherwise (invalid bus, no room left)
+ */
+bool HYPER_I2C_AddDevice(HYPER_I2C_Bus_t bus, uint8_t address, uint32_t clock_speed) {
+	if(bus >= HYPER_I2C_BUSES || clock_speed == 0)
+		return false;
+	if(clock_speed > HYPER_I2C_MAX_SPEED)
+		clock_speed = HYPER_I2C_MAX_SPEED;
+
+	HYPER_I2C_Init(bus);
+
+	// The device may already be registered by a transfer
+	HYPER_I2C_Device_t timing;
+	HYPER_I2C_Timing(clock_speed, &timing);
+	uint32_t basepri = HYPER_I2C_Lock();
+	uint8_t device = HYPER_I2C_FindDevice(bus, address);
+	if(device < HYPER_I2C_MAX_DEVICES) {
+		i2cDevices[device].ccr = timing.ccr;
+		i2cDevices[device].trise = timing.trise;
+	}
+	HYPER_I2C_Unlock(basepri);
+
+	return device < HYPER_I2C_MAX_DEVICES;
+}
+
+/**
+ * @brief This function sets up an I2C bus (once)
+ * @param bus The bus @see HYPER_I2C_Bus_t
+ */
+static void HYPER_I2C_Init(HYPER_I2C_Bus_t bus) {
+	if(i2cState[bus].initialized)
+		return;
+	const HYPER_I2C_Periph_t *periph = &i2cPeriph[bus];
+
+	// RCC setup
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOB, ENABLE);
+	RCC_APB1PeriphClockCmd(periph->rcc, ENABLE);
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+	if(i2cDefaultTiming.ccr == 0)
+		HYPER_I2C_Timing(HYPER_I2C_DEFAULT_SPEED, &i2cDefaultTiming);
+	HYPER_I2C_Setup(bus);
+
+	// A device may be holding the bus since before the reset
+	if(I2C_GetFlagStatus(periph->i2c, I2C_FLAG_BUSY))
+		HYPER_I2C_Recover(bus);
+
+	// Interrupts setup, the event, error and DMA handlers of a bus share the priority (they never preempt each other)
+	NVIC_InitTypeDef nvic_init;
+	nvic_init.NVIC_IRQChannelPreemptionPriority = HYPER_IRQ_PRIORITY_I2C;
+	nvic_init.NVIC_IRQChannelSubPriority = 0;
+	nvic_init.NVIC_IRQChannelCmd = ENABLE;
+	nvic_init.NVIC_IRQChannel = periph->irqEV;
+	NVIC_Init(&nvic_init);
+	nvic_init.NVIC_IRQChannel = periph->irqER;
+	NVIC_Init(&nvic_init);
+	nvic_init.NVIC_IRQChannel = periph->irqDMA;
+	NVIC_Init(&nvic_init);
+
+	i2cState[bus].initialized = true;
+}
+
+/**
+ * @brief This function sets up (or resets) the I2C peripheral of a bus
+ * @param bus The bus @see HYPER_I2C_Bus_t
+ */
+static void HYPER_I2C_Setup(HYPER_I2C_Bus_t bus) {
+	const HYPER_I2C_Periph_t *periph = &i2cPeriph[bus];
+
+	// SCL, SDA pins setup
+	GPIO_InitTypeDef gpio_init;
+	gpio_init.GPIO_Mode = GPIO_Mode_AF_OD;
+	gpio_init.GPIO_Pin = periph->scl | periph->sda;
+	gpio_init.GPIO_Speed = GPIO_Speed_10MHz;
+	GPIO_Init(GPIOB, &gpio_init);
+
+	// I2C setup (the peripheral is reset through RCC first)
+	I2C_DeInit(periph->i2c);
+	I2C_InitTypeDef i2c_init;
+	i2c_init.I2C_Mode = I2C_Mode_I2C;
+	i2c_init.I2C_ClockSpeed = HYPER_I2C_DEFAULT_SPEED; // Switched to each device's own timing by HYPER_I2C_Start()
+	i2c_init.I2C_DutyCycle = I2C_DutyCycle_2;
+	i2c_init.I2C_OwnAddress1 = 0;
+	i2c_init.I2C_Ack = I2C_Ack_Enable;
+	i2c_init.I2C_AcknowledgedAddress = I2C_AcknowledgedAddress_7bit;
+	I2C_Init(periph->i2c, &i2c_init);
+	I2C_Cmd(periph->i2c, ENABLE);
+	I2C_ITConfig(periph->i2c, I2C_IT_EVT | I2C_IT_ERR, ENABLE);
+}
+
+/**
+ * @brief This function computes the bus timing of an SCL frequency (the same way as I2C_Init(), rounded towards the lower frequency)
+ * @param clock_speed The SCL frequency (in Hz)
+ * @param device Pointer to the device, its timing is set
+ */
+static void HYPER_I2C_Timing(uint32_t clock_speed, HYPER_I2C_Device_t *device) {
+	RCC_ClocksTypeDef clocks;
+	RCC_GetClocksFreq(&clocks);
+	uint32_t pclk1 = clocks.PCLK1_Frequency;
+	uint32_t freq_mhz = pclk1 / 1000000;
+
+	if(clock_speed <= 100000) {
+		// Standard mode, 50% duty cycle, 1000ns max rise time
+		uint32_t ccr = (pclk1 + 2 * clock_speed - 1) / (2 * clock_speed);
+		device->ccr = ccr < 4 ? 4 : ccr;
+		device->trise = freq_mhz + 1;
+	}
+	else {
+		// Fast mode, tLOW/tHIGH = 2, 300ns max rise time
+		uint32_t ccr = (pclk1 + 3 * clock_speed - 1) / (3 * clock_speed);
+		device->ccr = I2C_CCR_FS | (ccr < 1 ? 1 : ccr);
+		device->trise = freq_mhz * 300 / 1000 + 1;
+	}
+}
+
+/**
+ * @brief This function frees a stuck bus: SCL is clocked until the devices release SDA (a device may be in the middle
+ * of a read), a STOP is generated by hand and the peripheral is reset. It is run with the I2C interrupts masked (never the higher priority ones).
+ * @param bus The bus @see HYPER_I2C_Bus_t
+ */
+static void HYPER_I2C_Recover(HYPER_I2C_Bus_t bus) {
+	const HYPER_I2C_Periph_t *periph = &i2cPeriph[bus];
+	HYPER_I2C_State_t *state = &i2cState[bus];
+
+	// Stop the DMA, take the pins over as open-drain outputs (released)
+	periph->i2c->CR2 &= ~(I2C_CR2_DMAEN | I2C_CR2_LAST | I2C_CR2_ITBUFEN);
+	periph->dmaTX->CCR = 0;
+	periph->dmaRX->CCR = 0;
+	I2C_Cmd(periph->i2c, DISABLE);
+	GPIOB->BSRR = periph->scl | periph->sda;
+	GPIO_InitTypeDef gpio_init;
+	gpio_init.GPIO_Mode = GPIO_Mode_Out_OD;
+	gpio_init.GPIO_Pin = periph->scl | periph->sda;
+	gpio_init.GPIO_Speed = GPIO_Speed_10MHz;
+	GPIO_Init(GPIOB, &gpio_init);
+	HYPER_Cycles_Delay(HYPER_I2C_RECOVERY_HALFCLOCK);
+
+	// Clock SCL until SDA is released (9 clocks finish any byte)
+	for(uint8_t i = 0; i < 9 && !(GPIOB->IDR & periph->sda); i++) {
+		GPIOB->BRR = periph->scl;
+		HYPER_Cycles_Delay(HYPER_I2C_RECOVERY_HALFCLOCK);
+		GPIOB->BSRR = periph->scl;
+		HYPER_Cycles_Delay(HYPER_I2C_RECOVERY_HALFCLOCK);
+	}
+
+	// STOP: SDA goes HIGH while SCL is HIGH
+	GPIOB->BRR = periph->scl;
+	HYPER_Cycles_Delay(HYPER_I2C_RECOVERY_HALFCLOCK);
+	GPIOB->BRR = periph->sda;
+	HYPER_Cycles_Delay(HYPER_I2C_RECOVERY_HALFCLOCK);
+	GPIOB->BSRR = periph->scl;
+	HYPER_Cycles_Delay(HYPER_I2C_RECOVERY_HALFCLOCK);
+	GPIOB->BSRR = periph->sda;
+	HYPER_Cycles_Delay(HYPER_I2C_RECOVERY_HALFCLOCK);
+
+	// Reset the peripheral, give it the pins back
+	HYPER_I2C_Setup(bus);
+
+	if(state->recoveries != 0xFFFF)
+		state->recoveries++;
+}
+
+/**
+ * @brief This function finds the statistics of a device, registers it if it's new. It is run with the I2C interrupts masked.
+ * @param bus The bus @see HYPER_I2C_Bus_t
+ * @param address The device's I2C address (shifted left)
+ * @return The device's index, HYPER_I2C_MAX_DEVICES if there is no room left
+ */
+static uint8_t HYPER_I2C_FindDevice(HYPER_I2C_Bus_t bus, uint8_t address) {
+	for(uint8_t i = 0; i < i2cDeviceCount; i++) {
+		if(i2cDevices[i].stats.bus == bus && i2cDevices[i].stats.address == address)
+			return i;
+	}
+
+	if(i2cDeviceCount >= HYPER_I2C_MAX_DEVICES)
+		return HYPER_I2C_MAX_DEVICES;
+	i2cDevices[i2cDeviceCount] = i2cDefaultTiming;
+	i2cDevices[i2cDeviceCount].stats = (HYPER_I2C_DeviceStats_t){bus, address, 0, 0, 0};
+	return i2cDeviceCount++;
+}
+
+/**
+ * @brief This function queues a transfer. It may be run from the transfer callbacks (not from the higher priority interrupts).
+ * @param transfer Pointer to the transfer descriptor @see HYPER_I2C_Transfer_t
+ * @return true if the transfer was queued, false if it is still pending (or invalid)
+ */
+bool HYPER_I2C_Submit(HYPER_I2C_Transfer_t *transfer) {
+	if(transfer->bus >= HYPER_I2C_BUSES || !i2cState[transfer->bus].initialized)
+		return false;
+	if(transfer->status == I2C_STATUS_PENDING || (transfer->txLength == 0 && transfer->rxLength == 0))
+		return false;
+	HYPER_I2C_State_t *state = &i2cState[transfer->bus];
+
+	transfer->status = I2C_STATUS_PENDING;
+	transfer->next = 0;
+
+	uint32_t basepri = HYPER_I2C_Lock();
+	transfer->device = HYPER_I2C_FindDevice(transfer->bus, transfer->address);
+	if(state->tail)
+		state->tail->next = transfer;
+	else
+		state->head = transfer;
+	state->tail = transfer;
+	if(!state->busy)
+		HYPER_I2C_Start(transfer->bus);
+	HYPER_I2C_Unlock(basepri);
+
+	return true;
+}
+
+/**
+ * @brief This function runs a transfer and waits until it completes (HYPER_I2C_TIMEOUT at most, the queued transfers first).
+ * For the initializations, it must not be run from the interrupts.
+ * @param transfer Pointer to the transfer descriptor @see HYPER_I2C_Transfer_t
+ * @return The transfer's final state (I2C_STATUS_DONE, I2C_STATUS_ERROR or I2C_STATUS_TIMEOUT)
+ */
+HYPER_I2C_Status_t HYPER_I2C_Run(HYPER_I2C_Transfer_t *transfer) {
+	if(!HYPER_I2C_Submit(transfer))
+		return I2C_STATUS_ERROR;
+
+	while(transfer->status == I2C_STATUS_PENDING)
+		HYPER_I2C_Tick();
+	return transfer->status;
+}
+
+/**
+ * @brief This function aborts the transfers that take longer than HYPER_I2C_TIMEOUT and recovers their buses. It should be run in the main loop.
+ */
+void HYPER_I2C_Tick(void) {
+	for(uint8_t bus = 0; bus < HYPER_I2C_BUSES; bus++) {
+		HYPER_I2C_State_t *state = &i2cState[bus];
+		if(!state->busy || !HYPER_Delay_Check(state->startTime, HYPER_I2C_TIMEOUT))
+			continue;
+
+		// Check again with the I2C interrupts masked, the transfer may complete meanwhile. The recovery takes a few
+		// hundred us, the brake commands (CAN RX) and SysTick aren't delayed by it.
+		uint32_t basepri = HYPER_I2C_Lock();
+		if(state->busy && HYPER_Delay_Check(state->startTime, HYPER_I2C_TIMEOUT)) {
+			HYPER_I2C_Recover(bus);
+			HYPER_I2C_Complete(bus, I2C_STATUS_TIMEOUT);
+		}
+		HYPER_I2C_Unlock(basepri);
+	}
+}
+
+/**
+ * @brief This function checks if a device keeps failing (HYPER_I2C_FAIL_THRESHOLD consecutive failed transfers), its readings should be treated as invalid
+ * @param bus The bus @see HYPER_I2C_Bus_t
+ * @param address The device's I2C address (shifted left)
+ * @return true if the device is failing, false otherwise (also if it wasn't used yet)
+ */
+bool HYPER_I2C_IsFailed(HYPER_I2C_Bus_t bus, uint8_t address) {
+	for(uint8_t i = 0; i < i2cDeviceCount; i++) {
+		if(i2cDevices[i].stats.bus == bus && i2cDevices[i].stats.address == address)
+			return i2cDevices[i].stats.failures >= HYPER_I2C_FAIL_THRESHOLD;
+	}
+
+	return false;
+}
+
+/**
+ * @brief This function returns the amount of the devices that have statistics
+ * @return The amount of devices
+ */
+uint8_t HYPER_I2C_GetDeviceCount(void) {
+	return i2cDeviceCount;
+}
+
+/**
+ * @brief This function copies the failure statistics of a device
+ * @param device The device's index (in the order of their first transfers)
+ * @param stats Pointer to the output structure
+ * @return true if the device exists, false otherwise
+ */
+bool HYPER_I2C_GetDeviceStats(uint8_t device, HYPER_I2C_DeviceStats_t *stats) {
+	if(device >= i2cDeviceCount)
+		return false;
+
+	uint32_t basepri = HYPER_I2C_Lock();
+	*stats = i2cDevices[device].stats;
+	HYPER_I2C_Unlock(basepri);
+	return true;
+}
+
+/**
+ * @brief This function returns the amount of the recoveries of a bus
+ * @param bus The bus @see HYPER_I2C_Bus_t
+ * @return The amount of recoveries
+ */
+uint16_t HYPER_I2C_GetRecoveries(HYPER_I2C_Bus_t bus) {
+	if(bus >= HYPER_I2C_BUSES)
+		return 0;
+
+	return i2cState[bus].recoveries;
+}
+
+/**
+ * @brief This function starts the head transfer of a bus. It is run with the bus' interrupts masked.
+ * @param bus The bus @see HYPER_I2C_Bus_t
+ */
+static void HYPER_I2C_Start(HYPER_I2C_Bus_t bus) {
+	const HYPER_I2C_Periph_t *periph = &i2cPeriph[bus];
+	HYPER_I2C_State_t *state = &i2cState[bus];
+
+	state->busy = true;
+	state->receiving = (state->head->txLength == 0);
+	state->startTime = HYPER_Delay_GetTime();
+
+	// The previous transfer's STOP has to be sent first (if it isn't, the START is lost and the transfer times out)
+	uint32_t start = HYPER_Cycles_Get();
+	uint32_t wait = HYPER_Cycles_FromMicros(HYPER_I2C_STOP_WAIT);
+	while((periph->i2c->CR1 & I2C_CR1_STOP) && !HYPER_Cycles_Check(start, wait));
+
+	// Switch to the device's timing, it can only be changed with the peripheral disabled (the bus is idle now)
+	const HYPER_I2C_Device_t *device = (state->head->device < HYPER_I2C_MAX_DEVICES) ? &i2cDevices[state->head->device] : &i2cDefaultTiming;
+	if(periph->i2c->CCR != device->ccr) {
+		periph->i2c->CR1 &= ~I2C_CR1_PE;
+		periph->i2c->CCR = device->ccr;
+		periph->i2c->TRISE = device->trise;
+		periph->i2c->CR1 |= I2C_CR1_PE;
+	}
+
+	periph->i2c->CR1 |= I2C_CR1_ACK | I2C_CR1_START;
+}
+
+/**
+ * @brief This function sets up a DMA channel for a transfer's phase
+ * @param channel The DMA channel
+ * @param i2c The I2C peripheral
+ * @param data The transferred data
+ * @param length The amount of the transferred bytes
+ * @param receive true for the read phase, false for the write phase
+ */
+static void HYPER_I2C_DMA(DMA_Channel_TypeDef *channel, I2C_TypeDef *i2c, const uint8_t *data, uint8_t length, bool receive) {
+	channel->CCR = 0;
+	channel->CPAR = (uint32_t)&i2c->DR;
+	channel->CMAR = (uint32_t)data;
+	channel->CNDTR = length;
+	channel->CCR = DMA_CCR1_MINC | (receive ? DMA_CCR1_TCIE : DMA_CCR1_DIR) | DMA_CCR1_EN;
+}
+
+/**
+ * @brief This function completes the head transfer of a bus, runs its callback and starts the next queued one
+ * @param bus The bus @see HYPER_I2C_Bus_t
+ * @param status The transfer's final state
+ */
+static void HYPER_I2C_Complete(HYPER_I2C_Bus_t bus, HYPER_I2C_Status_t status) {
+	HYPER_I2C_State_t *state = &i2cState[bus];
+	HYPER_I2C_Transfer_t *transfer = state->head;
+
+	state->head = transfer->next;
+	if(state->head == 0)
+		state->tail = 0;
+	state->busy = false;
+
+	// A corrupted read is a failure of the device, the same as a NACK
+	if(status == I2C_STATUS_DONE && transfer->verify && !transfer->verify(transfer))
+		status = I2C_STATUS_ERROR;
+
+	// Count the device's failures
+	if(transfer->device < HYPER_I2C_MAX_DEVICES) {
+		HYPER_I2C_DeviceStats_t *device = &i2cDevices[transfer->device].stats;
+		if(status == I2C_STATUS_DONE) {
+			device->failures = 0;
+		}
+		else {
+			if(status == I2C_STATUS_TIMEOUT && device->timeouts != 0xFFFF)
+				device->timeouts++;
+			else if(status == I2C_STATUS_ERROR && device->errors != 0xFFFF)
+				device->errors++;
+			if(device->failures != 0xFF)
+				device->failures++;
+		}
+	}
+	if(status != I2C_STATUS_DONE)
+		HYPER_Health_Report(HEALTH_I2CFAILURE);
+
+	transfer->time = HYPER_Delay_GetMicros();
+	transfer->status = status;
+	if(transfer->callback)
+		transfer->callback(transfer);
+
+	// The callback may have started a transfer already
+	if(!state->busy && state->head)
+		HYPER_I2C_Start(bus);
+}
+
+/**
+ * @brief This function handles the event interrupt of a bus (START sent, address sent, write done, single byte read)
+ * @param bus The bus @see HYPER_I2C_Bus_t
+ */
+static void HYPER_I2C_EventHandler(HYPER_I2C_Bus_t bus) {
+	const HYPER_I2C_Periph_t *periph = &i2cPeriph[bus];
+	HYPER_I2C_State_t *state = &i2cState[bus];
+	I2C_TypeDef *i2c = periph->i2c;
+	HYPER_I2C_Transfer_t *transfer = state->head;
+
+	uint16_t sr1 = i2c->SR1;
+	if(!state->busy) {
+		// Nothing in progress, clear the flags
+		(void)i2c->SR2;
+		return;
+	}
+
+	if(sr1 & I2C_SR1_SB) {
+		// START sent, send the address
+		i2c->DR = transfer->address | (state->receiving ? 0x01 : 0x00);
+	}
+	else if(sr1 & I2C_SR1_ADDR) {
+		if(!state->receiving) {
+			// Write phase, the data is sent by DMA (BTF follows the last byte)
+			HYPER_I2C_DMA(periph->dmaTX, i2c, transfer->txData, transfer->txLength, false);
+			i2c->CR2 |= I2C_CR2_DMAEN;
+			(void)i2c->SR2;
+		}
+		else if(transfer->rxLength == 1) {
+			// Single byte read, NACK and STOP have to be set up before the byte is received (no preemption in between)
+			i2c->CR1 &= ~I2C_CR1_ACK;
+			__disable_irq();
+			(void)i2c->SR2;
+			i2c->CR1 |= I2C_CR1_STOP;
+			__enable_irq();
+			i2c->CR2 |= I2C_CR2_ITBUFEN;
+		}
+		else {
+			// Multiple bytes read by DMA, the last one is NACKed (the DMA interrupt follows)
+			HYPER_I2C_DMA(periph->dmaRX, i2c, transfer->rxData, transfer->rxLength, true);
+			i2c->CR2 |= I2C_CR2_DMAEN | I2C_CR2_LAST;
+			(void)i2c->SR2;
+		}
+	}
+	else if((sr1 & I2C_SR1_BTF) && !state->receiving) {
+		// Write phase done
+		i2c->CR2 &= ~I2C_CR2_DMAEN;
+		periph->dmaTX->CCR = 0;
+		if(transfer->rxLength) {
+			state->receiving = true;
+			i2c->CR1 |= I2C_CR1_START;
+		}
+		else {
+			i2c->CR1 |= I2C_CR1_STOP;
+			HYPER_I2C_Complete(bus, I2C_STATUS_DONE);
+		}
+	}
+	else if(sr1 & I2C_SR1_RXNE) {
+		// Single byte read done (STOP already set)
+		i2c->CR2 &= ~I2C_CR2_ITBUFEN;
+		transfer->rxData[0] = i2c->DR;
+		HYPER_I2C_Complete(bus, I2C_STATUS_DONE);
+	}
+}
+
+/**
+ * @brief This function handles the error interrupt of a bus, the transfer in progress is aborted
+ * @param bus The bus @see HYPER_I2C_Bus_t
+ */
+static void HYPER_I2C_ErrorHandler(HYPER_I2C_Bus_t bus) {
+	const HYPER_I2C_Periph_t *periph = &i2cPeriph[bus];
+	I2C_TypeDef *i2c = periph->i2c;
+
+	uint16_t sr1 = i2c->SR1;
+	i2c->SR1 = sr1 & ~(I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_OVR);
+
+	// Stop the DMA
+	i2c->CR2 &= ~(I2C_CR2_DMAEN | I2C_CR2_LAST | I2C_CR2_ITBUFEN);
+	periph->dmaTX->CCR = 0;
+	periph->dmaRX->CCR = 0;
+
+	// Release the bus, a bus error or a lost arbitration may leave it stuck (the master mode is already lost after the latter)
+	if(sr1 & (I2C_SR1_BERR | I2C_SR1_ARLO))
+		HYPER_I2C_Recover(bus);
+	else
+		i2c->CR1 |= I2C_CR1_STOP;
+
+	if(i2cState[bus].busy)
+		HYPER_I2C_Complete(bus, I2C_STATUS_ERROR);
+}
+
+/**
+ * @brief This function handles the read DMA interrupt of a bus (multiple bytes read done)
+ * @param bus The bus @see HYPER_I2C_Bus_t
+ */
+static void HYPER_I2C_DMAHandler(HYPER_I2C_Bus_t bus) {
+	const HYPER_I2C_Periph_t *periph = &i2cPeriph[bus];
+	I2C_TypeDef *i2c = periph->i2c;
+
+	DMA1->IFCR = periph->dmaRXFlags;
+	i2c->CR2 &= ~(I2C_CR2_DMAEN | I2C_CR2_LAST);
+	periph->dmaRX->CCR = 0;
+	i2c->CR1 |= I2C_CR1_STOP;
+
+	if(i2cState[bus].busy)
+		HYPER_I2C_Complete(bus, I2C_STATUS_DONE);
+}
+
+/**
+ * @brief This function handles the I2C1_EV_IRQ
+ */
+void I2C1_EV_IRQHandler(void) {
+	uint32_t entry = HYPER_Trace_Enter();
+	HYPER_I2C_EventHandler(I2C_BUS1);
+	HYPER_Trace_Exit(TRACE_I2C, entry);
+}
+
+/**
+ * @brief This function handles the I2C1_ER_IRQ
+ */
+void I2C1_ER_IRQHandler(void) {
+	uint32_t entry = HYPER_Trace_Enter();
+	HYPER_I2C_ErrorHandler(I2C_BUS1);
+	HYPER_Trace_Exit(TRACE_I2C, entry);
+}
+
+/**
+ * @brief This function handles the DMA1_Channel7_IRQ (I2C1 reads)
+ */
+void DMA1_Channel7_IRQHandler(void) {
+	uint32_t entry = HYPER_Trace_Enter();
+	HYPER_I2C_DMAHandler(I2C_BUS1);
+	HYPER_Trace_Exit(TRACE_I2C, entry);
+}
+
+/**
+ * @brief This function handles the I2C2_EV_IRQ
+ */
+void I2C2_EV_IRQHandler(void) {
+	uint32_t entry = HYPER_Trace_Enter();
+	HYPER_I2C_EventHandler(I2C_BUS2);
+	HYPER_Trace_Exit(TRACE_I2C, entry);
+}
+
+/**
+ * @brief This function handles the I2C2_ER_IRQ
+ */
+void I2C2_ER_IRQHandler(void) {
+	uint32_t entry = HYPER_Trace_Enter();
+	HYPER_I2C_ErrorHandler(I2C_BUS2);
+	HYPER_Trace_Exit(TRACE_I2C, entry);
+}
+
+/**
+ * @brief This function handles the DMA1_Channel5_IRQ (I2C2 reads)
+ */
+void DMA1_Channel5_IRQHandler(void) {
+	uint32_t entry = HYPER_Trace_Enter();
+	HYPER_I2C_DMAHandler(I2C_BUS2);
+	HYPER_Trace_Exit(TRACE_I2C, entry);
+}
@@ -0,0 +1,76 @@
+/**
+ * @file hyper_i2c.h
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the headers of the asynchronous I2C master driver
+ */
+
+#ifndef HYPER_I2C_H_
+#define HYPER_I2C_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief This enum represents the I2C buses
+ */
+typedef enum {
+	I2C_BUS1 = 0,		/**< I2C1 (SCL - PB6, SDA - PB7) */
+	I2C_BUS2,			/**< I2C2 (SCL - PB10, SDA - PB11) */
+	HYPER_I2C_BUSES		/**< The amount of the I2C buses */
+} HYPER_I2C_Bus_t;
+
+/**
+ * @brief This enum represents the states of a transfer
+ */
+typedef enum {
+	I2C_STATUS_IDLE = 0,	/**< The transfer was never submitted */
+	I2C_STATUS_PENDING,		/**< The transfer is queued or in progress */
+	I2C_STATUS_DONE,		/**< The transfer completed */
+	I2C_STATUS_ERROR,		/**< The transfer failed (NACK, bus error, arbitration lost or the read data didn't pass the verification) */
+	I2C_STATUS_TIMEOUT		/**< The transfer didn't complete in HYPER_I2C_TIMEOUT (the bus was recovered) */
+} HYPER_I2C_Status_t;
+
+typedef struct HYPER_I2C_Transfer_s HYPER_I2C_Transfer_t;
+
+/**
+ * @brief Structure type that describes a transfer: a write of txLength bytes, then (after a repeated START) a read of rxLength bytes.
+ * Either of the phases may be empty. The descriptor (and the buffers) have to stay valid until the transfer completes.
+ */
+struct HYPER_I2C_Transfer_s {
+	HYPER_I2C_Bus_t bus;			/**< The bus the device is connected to */
+	uint8_t address;				/**< The device's I2C address (shifted left, R/W bit cleared) */
+	const uint8_t *txData;			/**< The written data */
+	uint8_t txLength;				/**< The amount of the written bytes */
+	uint8_t *rxData;				/**< The read data buffer */
+	uint8_t rxLength;				/**< The amount of the read bytes */
+	bool (*verify)(const HYPER_I2C_Transfer_t *transfer);	/**< Run from the interrupt when the transfer completes, checks the read data (eg. its PEC), false fails the transfer (optional) */
+	void (*callback)(HYPER_I2C_Transfer_t *transfer);	/**< Run from the interrupt when the transfer completes or fails (optional, may submit another transfer) */
+	void *context;					/**< User data for the callback */
+	volatile HYPER_I2C_Status_t status;	/**< The transfer's state @see HYPER_I2C_Status_t */
+	uint32_t time;					/**< The local time the transfer completed or failed at (in us, set by the driver), the acquisition time of the read data */
+	HYPER_I2C_Transfer_t *next;		/**< The next queued transfer (used by the driver) */
+	uint8_t device;					/**< The device's index in the failure statistics (used by the driver) */
+};
+
+/**
+ * @brief Structure type that holds the failure statistics of a device
+ */
+typedef struct {
+	uint8_t bus;			/**< The bus the device is connected to @see HYPER_I2C_Bus_t */
+	uint8_t address;		/**< The device's I2C address (shifted left) */
+	uint16_t errors;		/**< The amount of failed transfers (NACK, bus error, arbitration lost, corrupted data) (saturates at 0xFFFF) */
+	uint16_t timeouts;		/**< The amount of timed out transfers (saturates at 0xFFFF) */
+	uint8_t failures;		/**< The amount of consecutive failed transfers, cleared by a completed one (saturates at 0xFF) */
+} HYPER_I2C_DeviceStats_t;
+
+bool HYPER_I2C_AddDevice(HYPER_I2C_Bus_t bus, uint8_t address, uint32_t clock_speed);
+bool HYPER_I2C_Submit(HYPER_I2C_Transfer_t *transfer);
+HYPER_I2C_Status_t HYPER_I2C_Run(HYPER_I2C_Transfer_t *transfer);
+void HYPER_I2C_Tick(void);
+bool HYPER_I2C_IsFailed(HYPER_I2C_Bus_t bus, uint8_t address);
+uint8_t HYPER_I2C_GetDeviceCount(void);
+bool HYPER_I2C_GetDeviceStats(uint8_t device, HYPER_I2C_DeviceStats_t *stats);
+uint16_t HYPER_I2C_GetRecoveries(HYPER_I2C_Bus_t bus);
+
+#endif /* HYPER_I2C_H_ */
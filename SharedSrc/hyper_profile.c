@@ -0,0 +1,124 @@
+/**
+ * @file hyper_profile.c
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the main loop profiler. The duration of each stage (the scheduled tasks, the CAN and
+ * health processing, the whole pass) is measured with the cycle counter and kept as min/max/mean and a log2 histogram.
+ * The reports are sent on request (DIAG_PROFILE), so the units can be profiled in the pod without a debugger.
+ */
+
+#include "stm32f10x.h"
+#include "hyper_profile.h"
+#include "hyper_can.h"
+#include "hyper_unit_defs.h"
+#include "hyper_settings.h"
+#include "hyper_utils.h"
+
+#define HYPER_PROFILE_SLOTS		(PROFILE_TASKS + HYPER_SCHED_MAX_TASKS)	/**< The amount of the profiled stages */
+
+/**
+ * @brief Structure type that holds the statistics of a profiled stage
+ */
+typedef struct {
+	uint32_t count;								/**< The amount of samples */
+	uint32_t min;								/**< The shortest duration (in cycles) */
+	uint32_t max;								/**< The longest duration (in cycles) */
+	uint64_t sum;								/**< The sum of the durations (in cycles) */
+	uint32_t since;								/**< The time of the latest reset (in ms) */
+	uint16_t histogram[HYPER_PROFILE_BUCKETS];	/**< The log2 histogram of the durations */
+} HYPER_Profile_Stats_t;
+
+/**
+ * @brief The statistics of each stage. Updated and read in the main loop only.
+ */
+static HYPER_Profile_Stats_t profileStats[HYPER_PROFILE_SLOTS] = {{0}};
+
+/**
+ * @brief This function records a duration of a stage
+ * @param slot The stage @see HYPER_Profile_Slot_t
+ * @param cycles The duration (in cycles)
+ */
+void HYPER_Profile_Record(uint8_t slot, uint32_t cycles) {
+	if(slot >= HYPER_PROFILE_SLOTS)
+		return;
+	HYPER_Profile_Stats_t *stats = &profileStats[slot];
+
+	if(stats->count == 0 || cycles < stats->min)
+		stats->min = cycles;
+	if(cycles > stats->max)
+		stats->max = cycles;
+	stats->count++;
+	stats->sum += cycles;
+
+	// Bucket n (n > 0) holds the durations from 2^(HYPER_PROFILE_BUCKET_SHIFT + n) cycles up to twice as much
+	int32_t bucket = 31 - (int32_t)__CLZ(cycles) - HYPER_PROFILE_BUCKET_SHIFT;
+	if(bucket < 0)
+		bucket = 0;
+	else if(bucket >= HYPER_PROFILE_BUCKETS)
+		bucket = HYPER_PROFILE_BUCKETS - 1;
+	if(stats->histogram[bucket] != 0xFFFF)
+		stats->histogram[bucket]++;
+}
+
+/**
+ * @brief This function records the duration of a stage that started at the given time. Chains the consecutive stages:
+ * t = HYPER_Profile_Mark(PROFILE_A, t); stage B; t = HYPER_Profile_Mark(PROFILE_B, t);
+ * @param slot The stage @see HYPER_Profile_Slot_t
+ * @param start_cycles The stage start time (acquired through HYPER_Cycles_Get())
+ * @return The current time, the start time of the next stage
+ */
+uint32_t HYPER_Profile_Mark(uint8_t slot, uint32_t start_cycles) {
+	uint32_t now = HYPER_Cycles_Get();
+	HYPER_Profile_Record(slot, now - start_cycles);
+	return now;
+}
+
+/**
+ * @brief This function clears the statistics of a stage
+ * @param slot The stage @see HYPER_Profile_Slot_t, 0xFF clears all of them
+ */
+void HYPER_Profile_Reset(uint8_t slot) {
+	for(uint8_t i = 0; i < HYPER_PROFILE_SLOTS; i++) {
+		if(slot != 0xFF && slot != i)
+			continue;
+		profileStats[i] = (HYPER_Profile_Stats_t){0};
+		profileStats[i].since = HYPER_Delay_GetTime();
+	}
+}
+
+/**
+ * @brief This function fills the report of a stage
+ * @param slot The stage @see HYPER_Profile_Slot_t
+ * @param report Pointer to the output structure
+ * @return true if the stage exists, false otherwise
+ */
+bool HYPER_Profile_GetReport(uint8_t slot, HYPER_Profile_Report_t *report) {
+	if(slot >= HYPER_PROFILE_SLOTS)
+		return false;
+	const HYPER_Profile_Stats_t *stats = &profileStats[slot];
+
+	report->slot = slot;
+	report->clockMHz = SystemCoreClock / 1000000;
+	report->count = stats->count;
+	report->min = stats->min;
+	report->max = stats->max;
+	report->mean = stats->count ? stats->sum / stats->count : 0;
+
+	uint32_t elapsed = HYPER_Delay_GetTime() - stats->since;
+	uint64_t rate = elapsed ? (uint64_t)stats->count * 1000 / elapsed : 0;
+	report->rate = rate > 0xFFFF ? 0xFFFF : rate;
+
+	for(uint8_t i = 0; i < HYPER_PROFILE_BUCKETS; i++)
+		report->histogram[i] = stats->histogram[i];
+	return true;
+}
+
+/**
+ * @brief This function sends the report of a stage (segmented transfer with UNIT_CAN_ID_PROFILE)
+ * @param slot The stage @see HYPER_Profile_Slot_t
+ */
+void HYPER_Profile_Send(uint8_t slot) {
+	HYPER_Profile_Report_t report;
+	if(HYPER_Profile_GetReport(slot, &report))
+		HYPER_CAN_SendSegmented(UNIT_CAN_ID_PROFILE, sizeof(report), (uint8_t *)&report);
+}
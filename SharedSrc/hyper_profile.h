@@ -0,0 +1,21 @@
+/**
+ * @file hyper_profile.h
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the headers of the main loop profiler
+ */
+
+#ifndef HYPER_PROFILE_H_
+#define HYPER_PROFILE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hyper_can_frames.h"
+
+void HYPER_Profile_Record(uint8_t slot, uint32_t cycles);
+uint32_t HYPER_Profile_Mark(uint8_t slot, uint32_t start_cycles);
+void HYPER_Profile_Reset(uint8_t slot);
+bool HYPER_Profile_GetReport(uint8_t slot, HYPER_Profile_Report_t *report);
+void HYPER_Profile_Send(uint8_t slot);
+
+#endif /* HYPER_PROFILE_H_ */
@@ -0,0 +1,155 @@
+/**
+ * @file hyper_sched.c
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the cooperative task scheduler. Each unit declares its periodic work as a constant
+ * table of tasks (period, offset, priority, deadline), the scheduler releases them on time and counts the deadline misses.
+ */
+
+#include "stm32f10x.h"
+#include "hyper_sched.h"
+#include "hyper_health.h"
+#include "hyper_profile.h"
+#include "hyper_settings.h"
+#include "hyper_utils.h"
+
+/**
+ * @brief Structure type that holds the run-time state of a task
+ */
+typedef struct {
+	uint32_t release;			/**< The time of the next release (in ms) */
+	HYPER_Sched_Stats_t stats;	/**< The task's statistics */
+} HYPER_Sched_State_t;
+
+/**
+ * @brief The unit's task table
+ */
+static const HYPER_Sched_Task_t *schedTasks = 0;
+
+/**
+ * @brief The amount of tasks in schedTasks
+ */
+static uint8_t schedCount = 0;
+
+/**
+ * @brief The task indexes sorted by priority
+ */
+static uint8_t schedOrder[HYPER_SCHED_MAX_TASKS];
+
+/**
+ * @brief The run-time state of each task
+ */
+static HYPER_Sched_State_t schedState[HYPER_SCHED_MAX_TASKS];
+
+/**
+ * @brief This function increments a saturating 16-bit counter
+ * @param counter Pointer to the counter
+ * @param amount The amount to add
+ */
+static void HYPER_Sched_Count(uint16_t *counter, uint32_t amount) {
+	uint32_t value = *counter + amount;
+	*counter = value > 0xFFFF ? 0xFFFF : value;
+}
+
+/**
+ * @brief This function sets the unit's task table. It should be run in UNIT_Init().
+ * @param tasks Pointer to the task table (has to stay valid, usually a constant array)
+ * @param count The amount of tasks (HYPER_SCHED_MAX_TASKS max, the rest is ignored)
+ */
+void HYPER_Sched_Init(const HYPER_Sched_Task_t *tasks, uint8_t count) {
+	if(count > HYPER_SCHED_MAX_TASKS)
+		count = HYPER_SCHED_MAX_TASKS;
+
+	// Sort the tasks by priority (insertion sort, keeps the table order of equal priorities)
+	for(uint8_t i = 0; i < count; i++) {
+		uint8_t j = i;
+		while(j > 0 && tasks[schedOrder[j - 1]].priority > tasks[i].priority) {
+			schedOrder[j] = schedOrder[j - 1];
+			j--;
+		}
+		schedOrder[j] = i;
+	}
+
+	schedTasks = tasks;
+	schedCount = count;
+}
+
+/**
+ * @brief This function releases the tasks for the first time (after their offsets). It should be run right before the main loop.
+ */
+void HYPER_Sched_Start(void) {
+	uint32_t now = HYPER_Delay_GetTime();
+	for(uint8_t i = 0; i < schedCount; i++) {
+		schedState[i].release = now + schedTasks[i].offset;
+		schedState[i].stats = (HYPER_Sched_Stats_t){0};
+	}
+}
+
+/**
+ * @brief This function runs the tasks that are due, in the order of their priorities. It should be run in the main loop.
+ */
+void HYPER_Sched_Tick(void) {
+	for(uint8_t i = 0; i < schedCount; i++) {
+		uint8_t index = schedOrder[i];
+		const HYPER_Sched_Task_t *task = &schedTasks[index];
+		HYPER_Sched_State_t *state = &schedState[index];
+
+		// Background tasks run on every pass, they have no deadline
+		if(task->period == 0) {
+			uint32_t start = HYPER_Cycles_Get();
+			task->run();
+			HYPER_Profile_Mark(PROFILE_TASKS + index, start);
+			HYPER_Sched_Count(&state->stats.runs, 1);
+			continue;
+		}
+
+		if(HYPER_TIME_BEFORE(HYPER_Delay_GetTime(), state->release))
+			continue;
+
+		uint32_t start = HYPER_Cycles_Get();
+		task->run();
+		HYPER_Profile_Mark(PROFILE_TASKS + index, start);
+		uint32_t finish = HYPER_Delay_GetTime();
+		HYPER_Sched_Count(&state->stats.runs, 1);
+
+		// Check the deadline
+		uint32_t response = finish - state->release;
+		uint16_t deadline = task->deadline ? task->deadline : task->period;
+		if(response > state->stats.response)
+			state->stats.response = response > 0xFFFF ? 0xFFFF : response;
+		if(response > deadline) {
+			HYPER_Sched_Count(&state->stats.misses, 1);
+			HYPER_Health_Report(HEALTH_DEADLINEMISS);
+		}
+
+		// Schedule the next release, drop the ones that already passed (no catch-up bursts, the phase is kept)
+		state->release += task->period;
+		if(!HYPER_TIME_BEFORE(finish, state->release)) {
+			uint32_t skipped = (finish - state->release) / task->period + 1;
+			state->release += skipped * task->period;
+			HYPER_Sched_Count(&state->stats.misses, skipped);
+		}
+	}
+}
+
+/**
+ * @brief This function returns the amount of the unit's tasks
+ * @return The amount of tasks
+ */
+uint8_t HYPER_Sched_GetCount(void) {
+	return schedCount;
+}
+
+/**
+ * @brief This function copies the statistics of a task
+ * @param task The task index (its position in the unit's task table)
+ * @param stats Pointer to the output structure
+ * @return true if the task exists, false otherwise
+ */
+bool HYPER_Sched_GetStats(uint8_t task, HYPER_Sched_Stats_t *stats) {
+	if(task >= schedCount)
+		return false;
+
+	*stats = schedState[task].stats;
+	return true;
+}
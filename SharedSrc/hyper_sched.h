@@ -0,0 +1,40 @@
+/**
+ * @file hyper_sched.h
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the headers of the cooperative task scheduler
+ */
+
+#ifndef HYPER_SCHED_H_
+#define HYPER_SCHED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Structure type that describes a periodic task. Each unit declares a constant table of them.
+ */
+typedef struct {
+	void (*run)(void);		/**< The task function */
+	uint16_t period;		/**< The time between the task's releases (in ms), 0 runs it on every scheduler pass */
+	uint16_t offset;		/**< The time between the scheduler start and the first release (in ms), spreads the tasks that share a period */
+	uint8_t priority;		/**< The order of the tasks released at the same pass, lower value runs first */
+	uint16_t deadline;		/**< The maximum time from the release to the completion (in ms), 0 sets it to the period */
+} HYPER_Sched_Task_t;
+
+/**
+ * @brief Structure type that holds the statistics of a task
+ */
+typedef struct {
+	uint16_t runs;			/**< The amount of times the task was run (saturates at 0xFFFF) */
+	uint16_t misses;		/**< The amount of missed deadlines, including the releases dropped because the task fell a whole period behind (saturates at 0xFFFF) */
+	uint16_t response;		/**< The longest time from the release to the completion (in ms) */
+} HYPER_Sched_Stats_t;
+
+void HYPER_Sched_Init(const HYPER_Sched_Task_t *tasks, uint8_t count);
+void HYPER_Sched_Start(void);
+void HYPER_Sched_Tick(void);
+uint8_t HYPER_Sched_GetCount(void);
+bool HYPER_Sched_GetStats(uint8_t task, HYPER_Sched_Stats_t *stats);
+
+#endif /* HYPER_SCHED_H_ */
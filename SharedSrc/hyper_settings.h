@@ -12,6 +12,60 @@
 
 #define HYPER_CAN_SPEED			HYPER_CAN_SPEED_1000KBPS	/**< CAN bus speed*/
 
+#define HYPER_CAN_PUBLISH_PERIOD	10		/**< The default time between unsolicited data frames (in ms), 0 disables the push mode (RTR requests only) */
+#define HYPER_CAN_PUBLISH_SLOTS		6		/**< The number of slots each publish period is divided into (one slot per unit) */
+#define HYPER_CAN_RECORD_DIVIDER	2		/**< The full resolution record is sent every n-th publish slot, 0 disables the records */
+#define HYPER_CAN_TX_QUEUE_LENGTH	16		/**< The amount of outgoing frames that can wait for a free transmit mailbox */
+#define HYPER_CAN_TX_PRIORITY		1		/**< Order the waiting frames by their IDs (1) or send them in FIFO order (0) */
+#define HYPER_CAN_RX_QUEUE_LENGTH	16		/**< The amount of incoming frames waiting to be processed in the main loop (power of 2, 128 max) */
+
+/**
+ * @brief Safety-critical messages, processed directly in the CAN RX interrupt instead of the main loop.
+ * All the messages that drive the brake outputs or change the unit 6 brakes lock and watchdog state (which gates
+ * the brake commands) are kept together, so they can never be reordered.
+ */
+#define HYPER_CAN_ISR_MESSAGES		((1 << MSG_BRAKESHOLD) | (1 << MSG_BRAKESRELEASE) | (1 << MSG_BRAKESPOWEROFF) | (1 << MSG_POWERDOWN) | \
+									(1 << MSG_BRAKESLOCKUPDATE) | (1 << MSG_WATCHDOGRESET) | (1 << MSG_START))
+
+#define HYPER_CAN_BUSERROR_HOLDOFF	10		/**< The time the bus error interrupt stays disabled after each bus error (in ms), limits the interrupt load on a faulty bus */
+
+#define HYPER_HEALTH_PERIOD			1000	/**< The time between health frames (in ms), 0 disables them */
+#define HYPER_HEALTH_ERROR_INTERVAL	100		/**< The minimum time between error event frames (in ms) */
+#define HYPER_HEALTH_LOOP_MAX		20		/**< Main loop pass duration (in ms) above which a loop overrun is reported */
+
+#define HYPER_SCHED_MAX_TASKS		16		/**< The maximum amount of tasks in a unit's task table */
+#define HYPER_BOOT_MAX_STEPS		8		/**< The maximum amount of steps in a unit's initialization step table */
+
+#define HYPER_I2C_TIMEOUT			5		/**< The time after which an I2C transfer is aborted and its bus recovered (in ms) */
+#define HYPER_I2C_STOP_WAIT			100		/**< The maximum wait for the previous STOP before the next START (in us) */
+#define HYPER_I2C_RECOVERY_HALFCLOCK	5	/**< SCL half period of the bus recovery (in us), 100kHz */
+#define HYPER_I2C_FAIL_THRESHOLD	3		/**< The amount of consecutive failed transfers after which a device's readings are invalid */
+#define HYPER_I2C_MAX_DEVICES		8		/**< The maximum amount of I2C devices (their timing and failure statistics) */
+#define HYPER_I2C_MAX_SPEED			400000	/**< The maximum SCL frequency of the buses (in Hz), the devices' own maximums are limited to it */
+#define HYPER_I2C_DEFAULT_SPEED		100000	/**< The SCL frequency of the devices that weren't added by their drivers (in Hz) */
+
+#define HYPER_SYNC_STEP_THRESHOLD	1000	/**< Pod time offset (in us) above which the clock is stepped instead of being slewed by the servo */
+#define HYPER_SYNC_LOCK_THRESHOLD	50		/**< Pod time offset (in us) below which the clock is considered locked */
+#define HYPER_SYNC_KP_SHIFT			1		/**< Proportional gain of the clock servo, 1/2^n */
+#define HYPER_SYNC_RATE_WINDOW		1000	/**< The minimum interval of a drift measurement (in ms), the reception jitter is spread over it */
+#define HYPER_SYNC_RATE_SHIFT		3		/**< Smoothing of the drift compensation, each drift measurement moves it by 1/2^n of the difference */
+#define HYPER_SYNC_MAX_RATE_PPM		500		/**< The maximum drift compensation of the clock servo (in ppm) */
+
+/**
+ * @brief Interrupt priorities (NVIC_PriorityGroup_4 - preemption only, lower value preempts higher ones).
+ * The brake commands are applied in the CAN RX interrupts, only SysTick (a few cycles long) may delay them.
+ */
+#define HYPER_IRQ_PRIORITY_SYSTICK	0		/**< SysTick (the millisecond timebase) */
+#define HYPER_IRQ_PRIORITY_CAN_RX	1		/**< CAN1 RX0 and RX1 (brake commands and SYNC timestamps), has to be the same for both FIFOs */
+#define HYPER_IRQ_PRIORITY_BUTTONS	2		/**< EXTI0..2 (unit 6 brakes buttons) */
+#define HYPER_IRQ_PRIORITY_ENCODER	2		/**< TIM3 (units 3 and 4 angular encoder) */
+#define HYPER_IRQ_PRIORITY_CAN_TX	3		/**< CAN1 TX (transmit queue) */
+#define HYPER_IRQ_PRIORITY_CAN_SCE	3		/**< CAN1 SCE (bus errors) */
+#define HYPER_IRQ_PRIORITY_I2C		3		/**< I2C1 and I2C2 events, errors and their read DMA channels (sensor transfers), the driver masks this level (BASEPRI) for the bus recovery */
+#define HYPER_IRQ_PRIORITY_RANGE	3		/**< EXTI lines of the VL6180X sensors' GPIO1 (sample ready, only sets a flag) */
+
+#define HYPER_TRACE_ENABLE			1		/**< Trace the interrupts' durations and latencies (1) or compile the tracing out (0) */
+
 #define HYPER_LED_BLINK_OK		1000 	/**< Status LED on-off time (in ms) when no error is detected */
 #define HYPER_LED_BLINK_ERROR	100		/**< Status LED on-off time (in ms) when error is detected */
 
@@ -20,6 +74,8 @@
 
 #define HYPER_WATCHDOG_TIMEOUT		4000	/**< The time it takes for the IWDG to overflow (in 0.1ms, 4095 max), eg. 4000 = 0.4s */
 
+#define UNIT1_TUBE_PRESSURE			1000	/**< The default static pressure in the tube (in Pa), the air density of the airspeed computation @see MSG_TUBEPRESSURE */
+
 #define UNIT6_WATCHDOG_TIMEOUT		1000	/**< The time it takes for the unit 6 watchdog to overflow (in ms) */
 
 #endif /* HYPER_SETTINGS_H_ */
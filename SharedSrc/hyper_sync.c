@@ -0,0 +1,215 @@
+/**
+ * @file hyper_sync.c
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the pod time synchronization functions. The central node broadcasts a SYNC message
+ * followed by a FOLLOW-UP carrying the exact time it was sent at. Each unit timestamps the SYNC reception and
+ * disciplines its local clock (offset and drift) with a servo, so that all the units share a common pod time.
+ */
+
+#include "stm32f10x.h"
+#include "hyper_sync.h"
+#include "hyper_settings.h"
+#include "hyper_utils.h"
+
+/**
+ * @brief Structure type that maps the local time to the pod time: pod = refPod + elapsed + elapsed * rate / 2^32
+ */
+typedef struct {
+	uint32_t refLocal;		/**< Local time of the reference point (in us) */
+	uint32_t refPod;		/**< Pod time of the reference point (in us) */
+	int32_t rate;			/**< Drift compensation (fraction of the elapsed time, scaled by 2^32) */
+} HYPER_Sync_Model_t;
+
+/**
+ * @brief Clock models, the one pointed by syncModelFront is in use. Updated in the main loop only, read from anywhere.
+ */
+static HYPER_Sync_Model_t syncModel[2] = {{0}};
+
+/**
+ * @brief The index of the clock model that is currently in use
+ */
+static volatile uint8_t syncModelFront = 0;
+
+/**
+ * @brief The sequence number of the latest SYNC message
+ */
+static volatile uint8_t captureSequence = 0;
+
+/**
+ * @brief The local reception time of the latest SYNC message (in us)
+ */
+static volatile uint32_t captureTime = 0;
+
+/**
+ * @brief A SYNC message was captured and is waiting for its follow-up
+ */
+static volatile bool capturePending = false;
+
+/**
+ * @brief The local reception time of the SYNC message the current drift measurement started at (in us)
+ */
+static uint32_t windowLocal = 0;
+
+/**
+ * @brief The pod time of the SYNC message the current drift measurement started at (in us)
+ */
+static uint32_t windowPod = 0;
+
+/**
+ * @brief The drift measurement has a starting point
+ */
+static bool windowStarted = false;
+
+/**
+ * @brief The drift compensation has been measured at least once since the last step
+ */
+static bool rateMeasured = false;
+
+/**
+ * @brief The offset measured at the previous SYNC message (in us), 0 right after a step
+ */
+static int32_t lastOffset = 0;
+
+/**
+ * @brief The clock has been set at least once
+ */
+static bool syncStarted = false;
+
+/**
+ * @brief Jitter estimate scaled by 16 (RFC 3550 style smoothing)
+ */
+static uint32_t jitter16 = 0;
+
+/**
+ * @brief The time synchronization statistics
+ */
+static HYPER_Sync_Stats_t syncStats = {0};
+
+/**
+ * @brief This function converts the local time to the pod time using the given clock model
+ * @param model Pointer to the clock model
+ * @param local_us Local time (in us)
+ * @return Pod time (in us)
+ */
+static uint32_t HYPER_Sync_Apply(const HYPER_Sync_Model_t *model, uint32_t local_us) {
+	int32_t elapsed = local_us - model->refLocal;
+	return model->refPod + elapsed + (int32_t)(((int64_t)elapsed * model->rate) >> 32);
+}
+
+/**
+ * @brief This function converts a local time stamp (acquired through HYPER_Delay_GetMicros()) to the pod time
+ * @param local_us Local time (in us)
+ * @return Pod time (in us), equal to the local time until the first SYNC is received
+ */
+uint32_t HYPER_Sync_ToPodTime(uint32_t local_us) {
+	HYPER_Sync_Model_t model = syncModel[syncModelFront];
+	return HYPER_Sync_Apply(&model, local_us);
+}
+
+/**
+ * @brief This function returns the current pod time
+ * @return Pod time (in us)
+ */
+uint32_t HYPER_Sync_GetTime(void) {
+	return HYPER_Sync_ToPodTime(HYPER_Delay_GetMicros());
+}
+
+/**
+ * @brief This function stores the reception time of a SYNC message. Called from the CAN RX interrupt.
+ * @param sequence The SYNC sequence number
+ * @param local_us Local reception time (in us)
+ */
+void HYPER_Sync_Capture(uint8_t sequence, uint32_t local_us) {
+	captureSequence = sequence;
+	captureTime = local_us;
+	capturePending = true;
+}
+
+/**
+ * @brief This function processes a FOLLOW-UP message and runs the clock servo. It should be run in the main loop.
+ * @param sequence The sequence number of the matching SYNC
+ * @param master_us The pod time of the SYNC transmission (in us)
+ */
+void HYPER_Sync_FollowUp(uint8_t sequence, uint32_t master_us) {
+	// Take the captured SYNC time (written by the CAN RX interrupt)
+	__disable_irq();
+	bool pending = capturePending && captureSequence == sequence;
+	uint32_t local = captureTime;
+	capturePending = false;
+	__enable_irq();
+
+	if(!pending) {
+		syncStats.missed++;
+		return;
+	}
+
+	HYPER_Sync_Model_t model = syncModel[syncModelFront];
+	uint32_t predicted = HYPER_Sync_Apply(&model, local);
+	int32_t offset = master_us - predicted;
+
+	if(!syncStarted || offset > HYPER_SYNC_STEP_THRESHOLD || offset < -HYPER_SYNC_STEP_THRESHOLD) {
+		// Too far off (or not set yet) - step the clock, keep the drift compensation
+		model.refPod = master_us;
+		syncStats.steps++;
+		jitter16 = 0;
+		lastOffset = 0;
+		windowStarted = false;
+		rateMeasured = false;
+	}
+	else {
+		// Drift - the pod time elapsed against the local time, measured over at least HYPER_SYNC_RATE_WINDOW (the reception
+		// jitter of a single SYNC divided by a short interval would swamp the drift)
+		int32_t interval = local - windowLocal;
+		if(windowStarted && interval >= HYPER_SYNC_RATE_WINDOW * 1000) {
+			int32_t drift = (int32_t)(master_us - windowPod) - interval;
+			int64_t measured = ((int64_t)drift << 32) / interval;
+			int64_t rate = rateMeasured ? model.rate + ((measured - model.rate) >> HYPER_SYNC_RATE_SHIFT) : measured;
+			int64_t max_rate = ((int64_t)HYPER_SYNC_MAX_RATE_PPM << 32) / 1000000;
+			if(rate > max_rate)
+				rate = max_rate;
+			else if(rate < -max_rate)
+				rate = -max_rate;
+			model.rate = rate;
+			rateMeasured = true;
+			windowStarted = false;
+		}
+
+		// Proportional term - correct a part of the offset right away
+		model.refPod = predicted + (offset >> HYPER_SYNC_KP_SHIFT);
+
+		// Jitter - smoothed difference between consecutive offsets
+		int32_t diff = offset - lastOffset;
+		if(diff < 0)
+			diff = -diff;
+		jitter16 += diff - ((jitter16 + 8) >> 4);
+		lastOffset = offset;
+	}
+	model.refLocal = local;
+	syncStarted = true;
+	if(!windowStarted) {
+		windowLocal = local;
+		windowPod = master_us;
+		windowStarted = true;
+	}
+
+	// Switch to the new model (the interrupts keep using the old one until the swap)
+	uint8_t back = !syncModelFront;
+	syncModel[back] = model;
+	HYPER_BARRIER();
+	syncModelFront = back;
+
+	// Update the statistics
+	syncStats.offset = offset;
+	syncStats.jitter = (jitter16 >> 4) > 0xFFFF ? 0xFFFF : (jitter16 >> 4);
+	syncStats.locked = offset < HYPER_SYNC_LOCK_THRESHOLD && offset > -HYPER_SYNC_LOCK_THRESHOLD;
+	syncStats.rate = ((int64_t)model.rate * 1000000000) >> 32;
+}
+
+/**
+ * @brief This function copies the time synchronization statistics
+ * @param stats Pointer to the output structure
+ */
+void HYPER_Sync_GetStats(HYPER_Sync_Stats_t *stats) {
+	*stats = syncStats;
+}
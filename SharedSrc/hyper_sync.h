@@ -0,0 +1,32 @@
+/**
+ * @file hyper_sync.h
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the headers of the pod time synchronization functions
+ */
+
+#ifndef HYPER_SYNC_H_
+#define HYPER_SYNC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Structure type that holds the time synchronization statistics
+ */
+typedef struct {
+	int32_t offset;			/**< The latest measured offset between the central node and this unit's pod time (in us) */
+	uint16_t jitter;		/**< Smoothed variation of the offset between consecutive SYNC messages (in us) */
+	bool locked;			/**< The latest offset was below HYPER_SYNC_LOCK_THRESHOLD */
+	int32_t rate;			/**< The current drift compensation (in ppb) */
+	uint16_t steps;			/**< The amount of times the clock was stepped */
+	uint8_t missed;			/**< The amount of follow-up messages that didn't match the captured SYNC */
+} HYPER_Sync_Stats_t;
+
+uint32_t HYPER_Sync_GetTime(void);
+uint32_t HYPER_Sync_ToPodTime(uint32_t local_us);
+void HYPER_Sync_Capture(uint8_t sequence, uint32_t local_us);
+void HYPER_Sync_FollowUp(uint8_t sequence, uint32_t master_us);
+void HYPER_Sync_GetStats(HYPER_Sync_Stats_t *stats);
+
+#endif /* HYPER_SYNC_H_ */
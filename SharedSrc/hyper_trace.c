@@ -0,0 +1,85 @@
+/**
+ * @file hyper_trace.c
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the interrupt tracing functions. The interrupt handlers timestamp their entry and exit
+ * with the cycle counter, the worst-case duration and entry latency of each vector is kept, so the interrupt
+ * priorities (@see hyper_settings.h) can be checked against the latency budget of the brake commands.
+ */
+
+#include "stm32f10x.h"
+#include "hyper_trace.h"
+#include "hyper_settings.h"
+#include "hyper_utils.h"
+
+/**
+ * @brief The trace of each vector. Each entry is written only by its own interrupt handler.
+ */
+static volatile HYPER_Trace_Stats_t traceStats[TRACE_VECTORS] = {{0}};
+
+/**
+ * @brief This function timestamps an interrupt handler's entry. It should be the first thing the handler does.
+ * @return The entry time (in cycles), to be passed to HYPER_Trace_Exit()
+ */
+uint32_t HYPER_Trace_Enter(void) {
+#if HYPER_TRACE_ENABLE
+	return HYPER_Cycles_Get();
+#else
+	return 0;
+#endif
+}
+
+/**
+ * @brief This function timestamps an interrupt handler's exit and updates the vector's trace
+ * @param vector The traced vector @see HYPER_Trace_Vector_t
+ * @param entry_cycles The entry time (acquired through HYPER_Trace_Enter())
+ */
+void HYPER_Trace_Exit(HYPER_Trace_Vector_t vector, uint32_t entry_cycles) {
+#if HYPER_TRACE_ENABLE
+	uint32_t duration = HYPER_Cycles_Get() - entry_cycles;
+	volatile HYPER_Trace_Stats_t *stats = &traceStats[vector];
+	stats->count++;
+	stats->total += duration;
+	if(duration > stats->wcet)
+		stats->wcet = duration;
+#endif
+}
+
+/**
+ * @brief This function records the entry latency of an interrupt, for the vectors that can tell when they were triggered
+ * @param vector The traced vector @see HYPER_Trace_Vector_t
+ * @param latency_cycles The time between the interrupt request and the handler's entry (in cycles)
+ */
+void HYPER_Trace_Latency(HYPER_Trace_Vector_t vector, uint32_t latency_cycles) {
+#if HYPER_TRACE_ENABLE
+	if(latency_cycles > traceStats[vector].latency)
+		traceStats[vector].latency = latency_cycles;
+#endif
+}
+
+/**
+ * @brief This function copies the trace of a vector
+ * @param vector The traced vector @see HYPER_Trace_Vector_t
+ * @param stats Pointer to the output structure
+ * @return true if the vector exists, false otherwise
+ */
+bool HYPER_Trace_GetStats(uint8_t vector, HYPER_Trace_Stats_t *stats) {
+	if(vector >= TRACE_VECTORS)
+		return false;
+
+	// The handlers may update the trace meanwhile
+	__disable_irq();
+	*stats = traceStats[vector];
+	__enable_irq();
+	return true;
+}
+
+/**
+ * @brief This function clears the traces of all the vectors
+ */
+void HYPER_Trace_Reset(void) {
+	__disable_irq();
+	for(uint8_t i = 0; i < TRACE_VECTORS; i++)
+		traceStats[i] = (HYPER_Trace_Stats_t){0};
+	__enable_irq();
+}
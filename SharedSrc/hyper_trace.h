@@ -0,0 +1,31 @@
+/**
+ * @file hyper_trace.h
+ * @author Łukasz Kilaszewski (luktor99)
+ * @date 17-October-2026
+ * @brief This file contains the headers of the interrupt tracing functions
+ */
+
+#ifndef HYPER_TRACE_H_
+#define HYPER_TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hyper_can_frames.h"
+
+/**
+ * @brief Structure type that holds the trace of an interrupt vector
+ */
+typedef struct {
+	uint32_t count;			/**< The amount of traced calls */
+	uint32_t wcet;			/**< The worst-case duration (in cycles) */
+	uint32_t latency;		/**< The worst-case entry latency (in cycles), only for the vectors that can measure it */
+	uint32_t total;			/**< The total time spent in the vector since the latest reset (in cycles, wraps around) */
+} HYPER_Trace_Stats_t;
+
+uint32_t HYPER_Trace_Enter(void);
+void HYPER_Trace_Exit(HYPER_Trace_Vector_t vector, uint32_t entry_cycles);
+void HYPER_Trace_Latency(HYPER_Trace_Vector_t vector, uint32_t latency_cycles);
+bool HYPER_Trace_GetStats(uint8_t vector, HYPER_Trace_Stats_t *stats);
+void HYPER_Trace_Reset(void);
+
+#endif /* HYPER_TRACE_H_ */
@@ -20,26 +20,56 @@
 #define UNIT_CAN_ID_DATA_OUT		60	/**< The message ID for outgoing data requests and transfers */
 #define UNIT_CAN_ID_DATA_IN			40	/**< The message ID for incoming data transfers */
 #define UNIT_CAN_ID_ERROR			30	/**< The message ID for errors */
+#define UNIT_CAN_ID_DIAG			50	/**< The message ID for diagnostic reports */
+#define UNIT_CAN_ID_RECORD			70	/**< The message ID for outgoing full resolution records (segmented transfers) */
+#define UNIT_CAN_ID_PROFILE			80	/**< The message ID for outgoing profiler reports (segmented transfers) */
+#define UNIT_CAN_ID_GROUP			HYPER_CAN_ID_BROADCAST		/**< The message ID for incoming multicast group commands (no group, same as the broadcast) */
+#define UNIT_CAN_PUBLISH_SLOT		0	/**< The publish slot (phase offset) of the unsolicited data frames */
 #elif defined UNIT_2
 #define UNIT_CAN_ID_DATA_OUT		61	/**< The message ID for outgoing data requests and transfers */
 #define UNIT_CAN_ID_DATA_IN			41	/**< The message ID for incoming data transfers */
 #define UNIT_CAN_ID_ERROR			31	/**< The message ID for errors */
+#define UNIT_CAN_ID_DIAG			51	/**< The message ID for diagnostic reports */
+#define UNIT_CAN_ID_RECORD			71	/**< The message ID for outgoing full resolution records (segmented transfers) */
+#define UNIT_CAN_ID_PROFILE			81	/**< The message ID for outgoing profiler reports (segmented transfers) */
+#define UNIT_CAN_ID_GROUP			HYPER_CAN_ID_GROUP_BRAKES	/**< The message ID for incoming multicast group commands (brake units) */
+#define UNIT_CAN_PUBLISH_SLOT		1	/**< The publish slot (phase offset) of the unsolicited data frames */
 #elif defined UNIT_3
 #define UNIT_CAN_ID_DATA_OUT		62	/**< The message ID for outgoing data requests and transfers */
 #define UNIT_CAN_ID_DATA_IN			42	/**< The message ID for incoming data transfers */
 #define UNIT_CAN_ID_ERROR			32	/**< The message ID for errors */
+#define UNIT_CAN_ID_DIAG			52	/**< The message ID for diagnostic reports */
+#define UNIT_CAN_ID_RECORD			72	/**< The message ID for outgoing full resolution records (segmented transfers) */
+#define UNIT_CAN_ID_PROFILE			82	/**< The message ID for outgoing profiler reports (segmented transfers) */
+#define UNIT_CAN_ID_GROUP			HYPER_CAN_ID_BROADCAST		/**< The message ID for incoming multicast group commands (no group, same as the broadcast) */
+#define UNIT_CAN_PUBLISH_SLOT		2	/**< The publish slot (phase offset) of the unsolicited data frames */
 #elif defined UNIT_4
 #define UNIT_CAN_ID_DATA_OUT		63	/**< The message ID for outgoing  data requests and transfers */
 #define UNIT_CAN_ID_DATA_IN			43	/**< The message ID for incoming data transfers */
 #define UNIT_CAN_ID_ERROR			33	/**< The message ID for errors */
+#define UNIT_CAN_ID_DIAG			53	/**< The message ID for diagnostic reports */
+#define UNIT_CAN_ID_RECORD			73	/**< The message ID for outgoing full resolution records (segmented transfers) */
+#define UNIT_CAN_ID_PROFILE			83	/**< The message ID for outgoing profiler reports (segmented transfers) */
+#define UNIT_CAN_ID_GROUP			HYPER_CAN_ID_BROADCAST		/**< The message ID for incoming multicast group commands (no group, same as the broadcast) */
+#define UNIT_CAN_PUBLISH_SLOT		3	/**< The publish slot (phase offset) of the unsolicited data frames */
 #elif defined UNIT_5
 #define UNIT_CAN_ID_DATA_OUT		64	/**< The message ID for outgoing  data requests and transfers */
 #define UNIT_CAN_ID_DATA_IN			44	/**< The message ID for incoming data transfers */
 #define UNIT_CAN_ID_ERROR			34	/**< The message ID for errors */
+#define UNIT_CAN_ID_DIAG			54	/**< The message ID for diagnostic reports */
+#define UNIT_CAN_ID_RECORD			74	/**< The message ID for outgoing full resolution records (segmented transfers) */
+#define UNIT_CAN_ID_PROFILE			84	/**< The message ID for outgoing profiler reports (segmented transfers) */
+#define UNIT_CAN_ID_GROUP			HYPER_CAN_ID_BROADCAST		/**< The message ID for incoming multicast group commands (no group, same as the broadcast) */
+#define UNIT_CAN_PUBLISH_SLOT		4	/**< The publish slot (phase offset) of the unsolicited data frames */
 #elif defined UNIT_6
 #define UNIT_CAN_ID_DATA_OUT		65	/**< The message ID for outgoing  data requests and transfers */
 #define UNIT_CAN_ID_DATA_IN			45	/**< The message ID for incoming data transfers */
 #define UNIT_CAN_ID_ERROR			35	/**< The message ID for errors */
+#define UNIT_CAN_ID_DIAG			55	/**< The message ID for diagnostic reports */
+#define UNIT_CAN_ID_RECORD			75	/**< The message ID for outgoing full resolution records (segmented transfers) */
+#define UNIT_CAN_ID_PROFILE			85	/**< The message ID for outgoing profiler reports (segmented transfers) */
+#define UNIT_CAN_ID_GROUP			HYPER_CAN_ID_GROUP_BRAKES	/**< The message ID for incoming multicast group commands (brake units) */
+#define UNIT_CAN_PUBLISH_SLOT		5	/**< The publish slot (phase offset) of the unsolicited data frames */
 #else
 #error "Target unit undefined! Please define it before building (-DUNIT_X)."
 #endif
@@ -7,8 +7,10 @@
 
 #include "stm32f10x.h"
 #include "hyper_utils.h"
+#include "hyper_can.h"
 #include "hyper_unit_defs.h"
 #include "hyper_settings.h"
+#include "hyper_boot.h"
 
 #if defined(UNIT_3) || defined(UNIT_4)
 #define ADC			ADC2					/**< The ADC peripheral used for common actions */
@@ -18,11 +20,20 @@
 #define ADC_RCC		RCC_APB2Periph_ADC1		/**< The ADC RCC clock */
 #endif
 
+#define DWT_CTRL			(*(volatile uint32_t *)0xE0001000)	/**< DWT control register (not defined by this CMSIS version) */
+#define DWT_CYCCNT			(*(volatile uint32_t *)0xE0001004)	/**< DWT cycle counter register */
+#define DWT_CTRL_CYCCNTENA	(1UL << 0)							/**< DWT_CTRL cycle counter enable bit */
+
 /**
  * @brief Milliseconds counter, incremented in SysTick_Handler() by calling HYPER_Tick();
  */
 static volatile uint32_t sysTickCounter = 0;
 
+/**
+ * @brief The amount of CPU cycles per microsecond, set by HYPER_Cycles_Init()
+ */
+static uint32_t cyclesPerMicro = 1;
+
 /**
  * @brief Status LED state (OK - true / ERROR - false). Updated through HYPER_LED_UpdateOK()
  */
@@ -31,7 +42,16 @@ static bool statusLEDStateOK = true;
 /**
  * @brief Unit execution state (STARTED - true / NOT STARTED - false). Updated through HYPER_Start()
  */
-static bool unitStarted = false;
+static volatile bool unitStarted = false;
+
+/**
+ * @brief This function sets the interrupt priority grouping. It has to be run before any interrupt is set up,
+ * the priorities of all the interrupts are listed in hyper_settings.h.
+ */
+void HYPER_NVIC_Init(void) {
+	// Preemption priorities only (0..15), no subpriorities
+	NVIC_PriorityGroupConfig(NVIC_PriorityGroup_4);
+}
 
 /**
  * @brief This function initializes the SysTick counter, used as milliseconds counter for delays
@@ -40,6 +60,19 @@ void HYPER_SysTick_Init(void) {
 	// Initialize SysTick @ 1kHz
 	if(SysTick_Config(SystemCoreClock / 1000))
 		NVIC_SystemReset();
+	NVIC_SetPriority(SysTick_IRQn, HYPER_IRQ_PRIORITY_SYSTICK);
+}
+
+/**
+ * @brief This function starts the DWT cycle counter, used as the cycle-accurate timebase
+ */
+void HYPER_Cycles_Init(void) {
+	cyclesPerMicro = SystemCoreClock / 1000000;
+
+	// The DWT unit is only clocked when the trace is enabled
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT_CYCCNT = 0;
+	DWT_CTRL |= DWT_CTRL_CYCCNTENA;
 }
 
 /**
@@ -128,6 +161,25 @@ uint32_t HYPER_Delay_GetTime(void) {
 	return sysTickCounter;
 }
 
+/**
+ * @brief This function returns the current time with microsecond resolution (milliseconds counter extended with the SysTick counter value).
+ * It may be called from interrupts, including the ones that preempt SysTick_Handler().
+ * @return Up time in microseconds (wraps around every ~71 minutes)
+ */
+uint32_t HYPER_Delay_GetMicros(void) {
+	uint32_t ms, ticks;
+	do {
+		ms = sysTickCounter;
+		ticks = SysTick->VAL;
+	} while(ms != sysTickCounter);
+
+	// The counter has reloaded, but SysTick_Handler() didn't get a chance to run yet
+	if((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) && ticks > SysTick->LOAD / 2)
+		ms++;
+
+	return ms * 1000 + (SysTick->LOAD - ticks) * 1000 / (SysTick->LOAD + 1);
+}
+
 /**
  * This function checks if a given delay has elapsed
  * @param start_time The delay start time (acquired through HYPER_Delay_GetTime())
@@ -138,6 +190,52 @@ bool HYPER_Delay_Check(uint32_t start_time, uint32_t duration_ms) {
 	return (sysTickCounter - start_time) >= duration_ms;
 }
 
+/**
+ * @brief This function returns the current value of the cycle counter. It may be called from anywhere.
+ * @return CPU cycles since HYPER_Cycles_Init() (wraps around every ~59.6s @ 72MHz, use the differences only)
+ */
+uint32_t HYPER_Cycles_Get(void) {
+	return DWT_CYCCNT;
+}
+
+/**
+ * @brief This function converts a cycle count (eg. a difference of two HYPER_Cycles_Get() values) to microseconds
+ * @param cycles The amount of CPU cycles
+ * @return The duration in microseconds
+ */
+uint32_t HYPER_Cycles_ToMicros(uint32_t cycles) {
+	return cycles / cyclesPerMicro;
+}
+
+/**
+ * @brief This function converts microseconds to a cycle count
+ * @param duration_us The duration in microseconds (59 seconds max @ 72MHz)
+ * @return The amount of CPU cycles
+ */
+uint32_t HYPER_Cycles_FromMicros(uint32_t duration_us) {
+	return duration_us * cyclesPerMicro;
+}
+
+/**
+ * This function checks if a given delay has elapsed, with the cycle resolution
+ * @param start_cycles The delay start time (acquired through HYPER_Cycles_Get())
+ * @param duration_cycles Delay duration in CPU cycles (@see HYPER_Cycles_FromMicros())
+ * @return true if the delay has elapsed, false otherwise
+ */
+bool HYPER_Cycles_Check(uint32_t start_cycles, uint32_t duration_cycles) {
+	return (DWT_CYCCNT - start_cycles) >= duration_cycles;
+}
+
+/**
+ * @brief This functions blocks program execution for a given amount of time, with the cycle resolution
+ * @param duration_us Delay duration in microseconds
+ */
+void HYPER_Cycles_Delay(uint32_t duration_us) {
+	uint32_t start = DWT_CYCCNT;
+	uint32_t duration = duration_us * cyclesPerMicro;
+	while((DWT_CYCCNT - start) < duration);
+}
+
 /**
  * @brief This functions updates the status LED. It should be run in the main loop.
  */
@@ -202,6 +300,10 @@ static bool HYPER_WaitLED(bool led_state, uint32_t delay) {
 	// Delay
 	uint32_t timestamp = HYPER_Delay_GetTime();
 	while(!HYPER_Delay_Check(timestamp, delay)) {
+		// The start message is processed in the CAN interrupt, the rest of the received frames here
+		HYPER_CAN_Dispatch();
+		// The unit's initialization keeps going meanwhile
+		HYPER_Boot_Tick();
 		if(unitStarted)
 			return true;
 	}
@@ -11,14 +11,33 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/**
+ * @brief Compiler memory barrier, keeps the memory accesses from being reordered across it (used by the lock-free buffers)
+ */
+#define HYPER_BARRIER()		__asm volatile ("" ::: "memory")
+
+/**
+ * @brief Wrap-safe comparison of two time stamps of the same timebase (milliseconds, microseconds or cycles),
+ * true if a is earlier than b. Valid as long as they are less than half of the timebase range apart.
+ */
+#define HYPER_TIME_BEFORE(a, b)	((int32_t)((uint32_t)(a) - (uint32_t)(b)) < 0)
+
+void HYPER_NVIC_Init(void);
 void HYPER_SysTick_Init(void);
+void HYPER_Cycles_Init(void);
 void HYPER_LED_Init(void);
 void HYPER_TempSensor_Init(void);
 
 void HYPER_Tick(void);
 void HYPER_Delay(uint32_t duration_ms);
 uint32_t HYPER_Delay_GetTime(void);
+uint32_t HYPER_Delay_GetMicros(void);
 bool HYPER_Delay_Check(uint32_t start_time, uint32_t duration_ms);
+uint32_t HYPER_Cycles_Get(void);
+uint32_t HYPER_Cycles_ToMicros(uint32_t cycles);
+uint32_t HYPER_Cycles_FromMicros(uint32_t duration_us);
+bool HYPER_Cycles_Check(uint32_t start_cycles, uint32_t duration_cycles);
+void HYPER_Cycles_Delay(uint32_t duration_us);
 void HYPER_LED_Tick(void);
 void HYPER_LED_UpdateOK(void);
 
@@ -36,11 +36,17 @@
 int main(void) {
 	HYPER_Init();
 	UNIT_Init();
+	HYPER_Boot_Mark(BOOT_UNITINIT);
 
 	// Don't wait for the start message if IWDG caused the reset
 	if(RCC_GetFlagStatus(RCC_FLAG_IWDGRST) != SET) {
 		HYPER_WaitForStart();
 	}
+	else {
+		HYPER_Health_Report(HEALTH_WATCHDOGRESET);
+	}
+
+	HYPER_Boot_Mark(BOOT_STARTED);
 
 	// Clear the reset flags
 	RCC_ClearFlag();
@@ -48,13 +54,33 @@ int main(void) {
 	// Enable IWDG
 	IWDG_Enable();
 
+	// Release the unit's tasks
+	HYPER_Sched_Start();
+	HYPER_Profile_Reset(0xFF);
+
+	uint32_t loop_start = HYPER_Cycles_Get();
 	for(;;) {
-		UNIT_Loop();
+		uint32_t stage_start = loop_start;
+		HYPER_Sched_Tick();
+		stage_start = HYPER_Profile_Mark(PROFILE_SCHED, stage_start);
+		HYPER_CAN_Tick();
+		stage_start = HYPER_Profile_Mark(PROFILE_CAN, stage_start);
+		HYPER_Health_Tick();
+		HYPER_Profile_Mark(PROFILE_HEALTH, stage_start);
 
 		//HYPER_TempSensor_Check();
 		HYPER_LED_Tick();
 
+		// Complete the unit's initialization in the background (nothing to do once it's done)
+		HYPER_Boot_Tick();
+
+		// Abort the stuck I2C transfers
+		HYPER_I2C_Tick();
+
 		IWDG_ReloadCounter();
+
+		// Profile the whole pass, the next one starts right away
+		loop_start = HYPER_Profile_Mark(PROFILE_LOOP, loop_start);
 	}
 }
 
@@ -9,9 +9,10 @@
 
 #include "stm32f10x.h"
 #include "brakes.h"
-#include "hyper_can.h"
 #include "hyper_unit_defs.h"
 #include "hyper_utils.h"
+#include "hyper_settings.h"
+#include "hyper_trace.h"
 
 #if defined(UNIT_2)
 #define DEFAULT_STATE	BRAKES_NORMAL	/**< The default brakes state for UNIT_2 */
@@ -23,6 +24,8 @@
 #define GPIO_HOLD		GPIO_Pin_2		/**< The GPIO pin connected to the BRAKES_1 button */
 #define GPIO_RELEASE	GPIO_Pin_1		/**< The GPIO pin connected to the BRAKES_0 button */
 
+#define BUTTONS_SETTLE_TIME	200		/**< The time the manual control buttons' inputs need to settle (in ms) */
+
 #define ON(x) GPIO_ReadInputDataBit(GPIOB, x)
 
 /**
@@ -38,10 +41,21 @@ typedef enum {
 /**
  * @brief This variable holds the current state of the braking system
  */
-static BrakesState_t brakesState = BRAKES_POWEROFF;
+static volatile BrakesState_t brakesState = BRAKES_POWEROFF;
+
+#if defined(UNIT_6)
+/**
+ * @brief The time the manual control buttons were set up at
+ */
+static uint32_t buttonsTimestamp = 0;
+
+/**
+ * @brief This variable is true once the manual control buttons' interrupts are enabled
+ */
+static bool buttonsArmed = false;
+#endif
 
 static void Brakes_SetState(BrakesState_t state);
-void updateBrakes(unit_DataBuffer_t *buffer, void *value); // function from unit_can.h
 
 /**
  * @brief This function initializes peripherals required to drive the brakes
@@ -71,13 +85,29 @@ void Brakes_Init(void) {
 	gpio.GPIO_Mode = GPIO_Mode_IN_FLOATING;
 	GPIO_Init(GPIOB, &gpio);
 
-	HYPER_Delay(200);
+	// The interrupts are enabled once the inputs settle (@see Brakes_InitTick())
+	buttonsTimestamp = HYPER_Delay_GetTime();
+	buttonsArmed = false;
+#endif
+}
+
+/**
+ * @brief This function completes the brakes initialization without blocking. It should be run until it returns true (@see hyper_boot.h).
+ * In UNIT_6 it enables the manual control buttons' interrupts once their inputs settle.
+ * @return true once the brakes are fully initialized, false otherwise
+ */
+bool Brakes_InitTick(void) {
+#if defined(UNIT_6)
+	if(buttonsArmed)
+		return true;
+	if(!HYPER_Delay_Check(buttonsTimestamp, BUTTONS_SETTLE_TIME))
+		return false;
 
 	// Interrupts setup
 	RCC_APB2PeriphClockCmd(RCC_APB2Periph_AFIO, ENABLE);
 
 	NVIC_InitTypeDef nvic_init;
-	nvic_init.NVIC_IRQChannelPreemptionPriority = 2;
+	nvic_init.NVIC_IRQChannelPreemptionPriority = HYPER_IRQ_PRIORITY_BUTTONS;
 	nvic_init.NVIC_IRQChannelSubPriority = 0;
 	nvic_init.NVIC_IRQChannelCmd = ENABLE;
 	nvic_init.NVIC_IRQChannel = EXTI0_IRQn;
@@ -97,7 +127,10 @@ void Brakes_Init(void) {
 	exti_init.EXTI_Trigger = EXTI_Trigger_Rising;
 	exti_init.EXTI_LineCmd = ENABLE;
 	EXTI_Init(&exti_init);
+
+	buttonsArmed = true;
 #endif
+	return true;
 }
 
 /**
@@ -128,15 +161,19 @@ void Brakes_PowerOff(void) {
 	Brakes_SetState(BRAKES_POWEROFF);
 }
 
+/**
+ * @brief This function checks if the braking system is commanded to brake
+ * @return true if the brakes are in the HOLD state, false otherwise
+ */
+bool Brakes_IsHolding(void) {
+	return brakesState == BRAKES_HOLD;
+}
+
 /**
  * @brief This function sets the braking system to the desired state
  * @param state The desired state @see BrakesState_t
  */
 static void Brakes_SetState(BrakesState_t state) {
-	// Update the state in the CAN buffer
-	uint8_t can_brakes_state = (state == BRAKES_HOLD);
-	HYPER_CAN_Update(updateBrakes, &can_brakes_state);
-
 	// Output the new state
 	if(state == BRAKES_NORMAL)
 		UNIT_BRAKES_GPIO->BSRR = UNIT_BRAKES_PIN_A | UNIT_BRAKES_PIN_B | (UNIT_BRAKES_PIN_C << 16U); // A-HIGH, B-HIGH, C-LOW
@@ -176,24 +213,30 @@ void Buttons_Tick(void) {
  * @brief This function handles the EXTI0_IRQ
  */
 void EXTI0_IRQHandler(void) {
+	uint32_t entry = HYPER_Trace_Enter();
 	Buttons_Tick();
 	EXTI_ClearITPendingBit(EXTI_Line0);
+	HYPER_Trace_Exit(TRACE_BUTTONS, entry);
 }
 
 /**
  * @brief This function handles the EXTI1_IRQ
  */
 void EXTI1_IRQHandler(void) {
+	uint32_t entry = HYPER_Trace_Enter();
 	Buttons_Tick();
 	EXTI_ClearITPendingBit(EXTI_Line1);
+	HYPER_Trace_Exit(TRACE_BUTTONS, entry);
 }
 
 /**
  * @brief This function handles the EXTI2_IRQ
  */
 void EXTI2_IRQHandler(void) {
+	uint32_t entry = HYPER_Trace_Enter();
 	Buttons_Tick();
 	EXTI_ClearITPendingBit(EXTI_Line2);
+	HYPER_Trace_Exit(TRACE_BUTTONS, entry);
 }
 #endif
 
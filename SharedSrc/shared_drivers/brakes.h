@@ -8,11 +8,15 @@
 #ifndef SHARED_DRIVERS_BRAKES_H_
 #define SHARED_DRIVERS_BRAKES_H_
 
+#include <stdbool.h>
+
 void Brakes_Init(void);
+bool Brakes_InitTick(void);
 void Brakes_PowerOff(void);
 void Brakes_Normal(void);
 void Brakes_Hold(void);
 void Brakes_Release(void);
+bool Brakes_IsHolding(void);
 #ifdef UNIT_6
 void Buttons_Tick(void);
 #endif
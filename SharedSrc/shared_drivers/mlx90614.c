@@ -9,118 +9,152 @@
 
 #include "stm32f10x.h"
 #include "mlx90614.h"
+#include "hyper_i2c.h"
+#include "hyper_utils.h"
 
 #define MLX90614_ADDR (0x5A << 1) /**< MLX90614's I2C address */
 
-#define TOBJ1 0x07 /**< TOBJ1 register's address */
+#define TA		0x06 /**< TA register's address (ambient temperature) */
+#define TOBJ1	0x07 /**< TOBJ1 register's address (object temperature, zone 1) */
+#define TOBJ2	0x08 /**< TOBJ2 register's address (object temperature, zone 2) */
 
-static uint16_t MLX90614_ReadReg(uint8_t reg);
+#define MLX90614_REFRESH_PERIOD	100		/**< The output refresh period of the factory configuration (in ms), the registers aren't read more often */
+#define MLX90614_REGS			3		/**< The amount of the read registers */
+#define MLX90614_ERROR_FLAG		0x8000	/**< Set in a temperature register when the measurement failed */
 
 /**
- * @brief This function initializes the resources required to run the MLX90614 sensor
+ * @brief The addresses of the read registers (the written part of each background read)
  */
-void MLX90614_Init(void) {
-	// RCC setup
-	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOB, ENABLE);
-	RCC_APB1PeriphClockCmd(RCC_APB1Periph_I2C1, ENABLE);
-	RCC_APB2PeriphClockCmd(RCC_APB2Periph_AFIO, ENABLE);
+static const uint8_t readRegs[MLX90614_REGS] = {TA, TOBJ1, TOBJ2};
 
-	// I2C1 SCL(PB6), SDA(PB7) pins setup
-	GPIO_InitTypeDef gpio_init;
-	gpio_init.GPIO_Mode = GPIO_Mode_AF_OD;
-	gpio_init.GPIO_Pin = GPIO_Pin_6 | GPIO_Pin_7;
-	gpio_init.GPIO_Speed = GPIO_Speed_10MHz;
-	GPIO_Init(GPIOB, &gpio_init);
+/**
+ * @brief The data of each background read: LSB, MSB, PEC
+ */
+static uint8_t readData[MLX90614_REGS][3];
+
+/**
+ * @brief The transfers of the background reads, queued together
+ */
+static HYPER_I2C_Transfer_t readTransfers[MLX90614_REGS];
+
+static bool MLX90614_CheckPEC(const HYPER_I2C_Transfer_t *transfer);
+
+/**
+ * @brief The time the latest reads were queued at
+ */
+static uint32_t readTimestamp = 0;
 
+/**
+ * @brief This function initializes the resources required to run the MLX90614 sensor
+ */
+void MLX90614_Init(void) {
 #if defined(UNIT_5)
 	// Enable sensor's power on Unit5 (set PB12 LOW)
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOB, ENABLE);
+	GPIO_InitTypeDef gpio_init;
 	gpio_init.GPIO_Mode = GPIO_Mode_Out_PP;
 	gpio_init.GPIO_Pin = GPIO_Pin_12;
 	gpio_init.GPIO_Speed = GPIO_Speed_50MHz;
 	GPIO_Init(GPIOB, &gpio_init);
 #endif
 
-	// I2C1 setup
-	I2C_DeInit(I2C1);
-	I2C_InitTypeDef I2C_InitStruct;
-	I2C_InitStruct.I2C_Mode = I2C_Mode_I2C;
-	I2C_InitStruct.I2C_ClockSpeed = 100000;
-	I2C_InitStruct.I2C_DutyCycle = I2C_DutyCycle_2;
-	I2C_InitStruct.I2C_Ack = I2C_Ack_Enable;
-	I2C_InitStruct.I2C_AcknowledgedAddress = I2C_AcknowledgedAddress_7bit;
-	I2C_Init(I2C1, &I2C_InitStruct);
-
-	// Enable I2C1
-	I2C_Cmd(I2C1, ENABLE);
-
-	// Wait for I2C1 to become ready
-	while(I2C_GetFlagStatus(I2C1, I2C_FLAG_BUSY));
+	// The sensor is an SMBus device, 100kHz max
+	HYPER_I2C_AddDevice(I2C_BUS1, MLX90614_ADDR, 100000);
+
+	// SMBus read word: the register address, then the value and its PEC
+	for(uint8_t i = 0; i < MLX90614_REGS; i++) {
+		readTransfers[i] = (HYPER_I2C_Transfer_t){0};
+		readTransfers[i].bus = I2C_BUS1;
+		readTransfers[i].address = MLX90614_ADDR;
+		readTransfers[i].txData = &readRegs[i];
+		readTransfers[i].txLength = 1;
+		readTransfers[i].rxData = readData[i];
+		readTransfers[i].rxLength = 3;
+		readTransfers[i].verify = MLX90614_CheckPEC;
+	}
+	readTimestamp = HYPER_Delay_GetTime() - MLX90614_REFRESH_PERIOD;
 }
 
 /**
- * @brief This function reads a single 16-bit value from the device's register
- * @param reg Register's address
- * @return Register's value
+ * @brief This function updates the SMBus packet error code (CRC-8, x^8 + x^2 + x + 1) with a byte
+ * @param crc The current PEC
+ * @param data The next byte of the packet
+ * @return The updated PEC
  */
-static uint16_t MLX90614_ReadReg(uint8_t reg) {
-	// Make sure the bus is ready
-	while(I2C_GetFlagStatus(I2C1, I2C_FLAG_BUSY));
-
-	// Generate START condition
-	I2C_GenerateSTART(I2C1, ENABLE);
-	while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_MODE_SELECT));
-
-	// Send MLX90614's I2C address
-	I2C_Send7bitAddress(I2C1, MLX90614_ADDR, I2C_Direction_Transmitter);
-	while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED));
-
-	// Send the register's address
-	I2C_SendData(I2C1, reg);
-	while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
-
-	// Generate START condition
-	I2C_GenerateSTART(I2C1, ENABLE);
-	while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_MODE_SELECT));
-
-	// Send MLX90614's I2C address
-	I2C_Send7bitAddress(I2C1, MLX90614_ADDR, I2C_Direction_Receiver);
-	while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_RECEIVER_MODE_SELECTED));
-
-	// Disable ACK
-	I2C_AcknowledgeConfig(I2C1, DISABLE);
-
-	// Receive the data byte 1 (LSB)
-	uint16_t data;
-	while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_RECEIVED));
-	data = I2C_ReceiveData(I2C1);
-	// Receive the data byte 2 (MSB)
-	while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_RECEIVED));
-	data |= I2C_ReceiveData(I2C1) << 8;
-
-	// Generate STOP condition
-	I2C_GenerateSTOP(I2C1, ENABLE);
-
-	// Enable ACK
-	I2C_AcknowledgeConfig(I2C1, ENABLE);
-
-	return data;
+static uint8_t MLX90614_PEC(uint8_t crc, uint8_t data) {
+	crc ^= data;
+	for(uint8_t i = 0; i < 8; i++)
+		crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+	return crc;
 }
 
 /**
- * @brief This function reads the temperature from the sensor.
- * @return Temperature expressed in °C (eg. 123 = 123°C) (Possible range: 0..255)
+ * @brief This function checks the PEC of a read word, it covers the whole packet (both addresses, the register and the value).
+ * It is run by the I2C driver when the read completes, a mismatch is counted as a failure of the sensor.
+ * @param transfer The completed read (the register's address, then LSB, MSB, PEC)
+ * @return true if the PEC matches, false otherwise
  */
-uint8_t MLX90614_readTemp(void) {
-	float temp = MLX90614_ReadReg(TOBJ1);
-	temp *= 0.02f;
-	temp -= 273.15f;
+static bool MLX90614_CheckPEC(const HYPER_I2C_Transfer_t *transfer) {
+	const uint8_t *data = transfer->rxData;
+	uint8_t crc = MLX90614_PEC(0, MLX90614_ADDR);
+	crc = MLX90614_PEC(crc, transfer->txData[0]);
+	crc = MLX90614_PEC(crc, MLX90614_ADDR | 0x01);
+	crc = MLX90614_PEC(crc, data[0]);
+	crc = MLX90614_PEC(crc, data[1]);
+	return crc == data[2];
+}
 
-	if(temp >= 255.0f)
-		return 255;
-	else if(temp <= 0.0f)
-		return 0;
+/**
+ * @brief This function reads the temperatures from the sensor, without waiting for the bus. The ambient and both
+ * object temperatures are read together once per MLX90614_REFRESH_PERIOD, the result is returned by one of the next calls.
+ * Each temperature is valid on its own, a failed read, a PEC mismatch or a measurement error drops only its register.
+ * @param reading Pointer to the output structure (raw temperatures expressed in 0.02K, eg. 14658 = 293.16K = 20.01°C),
+ * only the temperatures flagged in its valid field are set
+ * @return true if a new reading with at least one valid temperature was returned, false otherwise
+ */
+bool MLX90614_Read(MLX90614_Reading_t *reading) {
+	for(uint8_t i = 0; i < MLX90614_REGS; i++) {
+		if(readTransfers[i].status == I2C_STATUS_PENDING)
+			return false;
+	}
+
+	// Pick up the completed reads (once), in the order of readRegs[] and the valid flags
+	bool done = false;
+	if(readTransfers[MLX90614_REGS - 1].status != I2C_STATUS_IDLE) {
+		uint16_t *values[MLX90614_REGS] = {&reading->ambient, &reading->object1, &reading->object2};
+		reading->valid = 0;
+		for(uint8_t i = 0; i < MLX90614_REGS; i++) {
+			// The PEC was checked by the I2C driver, a mismatch failed the read
+			bool read = (readTransfers[i].status == I2C_STATUS_DONE);
+			readTransfers[i].status = I2C_STATUS_IDLE;
+			if(!read)
+				continue;
+			uint16_t value = readData[i][0] | (readData[i][1] << 8); // LSB first
+			if(value & MLX90614_ERROR_FLAG)
+				continue;
+			*values[i] = value;
+			reading->valid |= 1 << i;
+		}
+		reading->time = readTransfers[MLX90614_REGS - 1].time;
+		done = (reading->valid != 0);
+	}
+
+	// The sensor's outputs change only once per refresh period
+	if(HYPER_Delay_Check(readTimestamp, MLX90614_REFRESH_PERIOD)) {
+		readTimestamp = HYPER_Delay_GetTime();
+		for(uint8_t i = 0; i < MLX90614_REGS; i++)
+			HYPER_I2C_Submit(&readTransfers[i]);
+	}
+
+	return done;
+}
 
-	return (uint8_t)temp;
+/**
+ * @brief This function checks if the sensor stopped responding (HYPER_I2C_FAIL_THRESHOLD consecutive failed transfers)
+ * @return true if the sensor's readings should be treated as invalid, false otherwise
+ */
+bool MLX90614_IsFailed(void) {
+	return HYPER_I2C_IsFailed(I2C_BUS1, MLX90614_ADDR);
 }
 
 #endif
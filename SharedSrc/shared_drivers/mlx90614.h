@@ -8,8 +8,27 @@
 #ifndef SHARED_DRIVERS_MLX90614_H_
 #define SHARED_DRIVERS_MLX90614_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MLX90614_VALID_AMBIENT	0x01	/**< The ambient temperature of a reading is valid */
+#define MLX90614_VALID_OBJECT1	0x02	/**< The object temperature of zone 1 of a reading is valid */
+#define MLX90614_VALID_OBJECT2	0x04	/**< The object temperature of zone 2 of a reading is valid */
+
+/**
+ * @brief Structure type that holds a reading of the sensor (raw temperatures expressed in 0.02K)
+ */
+typedef struct {
+	uint16_t ambient;		/**< The ambient (sensor die) temperature, TA */
+	uint16_t object1;		/**< The object temperature of zone 1, TOBJ1 */
+	uint16_t object2;		/**< The object temperature of zone 2, TOBJ2 (dual zone sensors only) */
+	uint8_t valid;			/**< The temperatures that were read correctly (MLX90614_VALID_AMBIENT, MLX90614_VALID_OBJECT1, MLX90614_VALID_OBJECT2) */
+	uint32_t time;			/**< The local time the registers were read at (in us) */
+} MLX90614_Reading_t;
+
 void MLX90614_Init(void);
-uint8_t MLX90614_readTemp(void);
+bool MLX90614_Read(MLX90614_Reading_t *reading);
+bool MLX90614_IsFailed(void);
 
 
 #endif /* SHARED_DRIVERS_MLX90614_H_ */
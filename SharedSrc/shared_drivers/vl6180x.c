@@ -11,10 +11,13 @@
 #include "vl6180x.h"
 #include "hyper.h"
 #include "hyper_unit_defs.h"
+#include "hyper_settings.h"
 
-#define VL6180X_I2C		I2C2			/**< I2C peripheral used to communicate with VL6180X sensors */
+#define VL6180X_I2C		I2C_BUS2		/**< I2C bus used to communicate with VL6180X sensors */
 #define VL6180X_ADDR	(0x29 << 1)		/**< VL6180X's default I2C address */
+#define VL6180X_SPEED	400000			/**< VL6180X's maximum SCL frequency (in Hz) */
 
+#define SYSTEM__MODE_GPIO1						0x011	/**< SYSTEM__MODE_GPIO1 register address */
 #define SYSTEM__INTERRUPT_CONFIG_GPIO			0x014	/**< SYSTEM__INTERRUPT_CONFIG_GPIO register address */
 #define SYSTEM__INTERRUPT_CLEAR					0x015	/**< SYSTEM__INTERRUPT_CLEAR register address */
 #define SYSRANGE__START							0x018	/**< SYSRANGE__START register address */
@@ -27,59 +30,317 @@
 #define READOUT__AVERAGING_SAMPLE_PERIOD		0x10A	/**< READOUT__AVERAGING_SAMPLE_PERIOD register address */
 #define I2C_SLAVE__DEVICE_ADDRESS				0x212	/**< I2C_SLAVE__DEVICE_ADDRESS register address */
 
+#define VL6180X_SENSORS			4		/**< The amount of VL6180X sensors */
+#define VL6180X_POWEROFF_TIME	100		/**< The time the sensors are kept powered down to reset them (in ms) */
+#define VL6180X_POWERUP_TIME	100		/**< The time the sensors need to power up again (in ms) */
+#define VL6180X_BOOT_TIME		80		/**< The time a sensor needs to become available after its CE goes HIGH (in ms) */
+#define VL6180X_POLL_PERIOD		5		/**< The status polling period of the sensors without an interrupt line (in ms), they range every 10ms at most */
+#define VL6180X_INT_TIMEOUT		50		/**< The time without a sample after which an interrupt-driven sensor is polled anyway (in ms), recovers missed edges */
+
+#define VL6180X_INDEX(sensor_id)	(((sensor_id) >> 1) - 1)	/**< The sensor's index in the driver's tables */
+#define VL6180X_PERIOD			10000	/**< The step of the continuous ranging's measurement period (in us), SYSRANGE__INTERMEASUREMENT_PERIOD n -> (n + 1) * 10ms */
+#define VL6180X_PRECAL_TIME		3200	/**< The pre-calibration time of a range measurement (in us), before the convergence and the readout averaging */
+#define VL6180X_SHOT_TIMEOUT	20		/**< The time a round-robin sensor gets on top of its convergence time before the next one is started anyway (in ms) */
+#define VL6180X_RESTAGGER_PERIOD	1000	/**< The period of the continuous ranging restart (in ms), the sensors' own oscillators drift their measurement windows back together (costs a sample per sensor at most) */
+#define VL6180X_RATE_WINDOW		1000	/**< The window of the sample rate measurement (in ms) */
+#define VL6180X_BURST_MAX		8		/**< The maximum amount of bytes in a blocking multi-byte register write */
+#define VL6180X_INIT_VERIFY		0		/**< Read the initialization settings back and count the mismatches (1 - enabled, 0 - disabled) */
+
+/**
+ * @brief This enum represents the states of a sample fetch (the I2C transfers run in the background)
+ */
+typedef enum {
+	VL6180X_FETCH_IDLE = 0,		/**< No transfer in progress */
+	VL6180X_FETCH_STATUS,		/**< Reading the interrupt status (polled sensors), the range is fetched only if it shows a sample */
+	VL6180X_FETCH_CLEAR,		/**< Clearing the sensor's interrupt (queued right after the range read) */
+	VL6180X_FETCH_DONE			/**< The range is ready to be picked up */
+} VL6180X_FetchState_t;
+
+/**
+ * @brief Structure type that holds the sample fetch of a sensor
+ */
+typedef struct {
+	volatile VL6180X_FetchState_t state;	/**< The fetch state, changed by the transfer callback until VL6180X_FETCH_DONE */
+	uint8_t readReg[2];						/**< The address of the first read register */
+	uint8_t status;							/**< The read interrupt status (RESULT__INTERRUPT_STATUS_GPIO) */
+	uint8_t result;							/**< The read range (RESULT__RANGE_VAL) */
+	uint8_t range;							/**< The fetched range (in mm) */
+	HYPER_I2C_Transfer_t read;				/**< The result read descriptor */
+	HYPER_I2C_Transfer_t clear;				/**< The interrupt clear descriptor */
+	HYPER_I2C_Transfer_t start;				/**< The single-shot start descriptor (round-robin ranging) */
+	uint8_t index;							/**< The sensor's index */
+	VL6180X_Stats_t stats;					/**< The fetch statistics */
+} VL6180X_Fetch_t;
+
+/**
+ * @brief This enum represents the states of the ranging scheduler
+ */
+typedef enum {
+	VL6180X_RANGING_STOPPED = 0,	/**< No sensor is ranging (the initialization or a reconfiguration is in progress) */
+	VL6180X_RANGING_STAGGER,		/**< Continuous mode, the sensors are being started one by one, VL6180X_PERIOD / sensors apart */
+	VL6180X_RANGING_RUN,			/**< The sensors are ranging */
+	VL6180X_RANGING_DRAIN			/**< Round-robin mode, a reconfiguration waits for the single-shot measurement in progress */
+} VL6180X_RangingState_t;
+
+/**
+ * @brief The interrupt clear write (SYSTEM__INTERRUPT_CLEAR: range, ALS and error interrupts)
+ */
+static const uint8_t clearData[3] = {SYSTEM__INTERRUPT_CLEAR >> 8, SYSTEM__INTERRUPT_CLEAR & 0xFF, 0x07};
+
+/**
+ * @brief The sensors' initialization settings: bursts of consecutive registers (the length, the first register's address MSB first, the values).
+ * With the runtime settings, 37 single register writes take 23 transactions (the SR03 private registers are merged by address).
+ */
+static const uint8_t sensorInitTable[] = {
+	// SR03 settings (AN4545)
+	2, 0x02, 0x07,	0x01, 0x01,
+	2, 0x00, 0x30,	0x00, 0xFF,		// 0x0031 - SYSRANGE__VHV_REPEAT_RATE: auto calibration after every 255 measurements
+	2, 0x00, 0x96,	0x00, 0xFD,
+	1, 0x00, 0x9F,	0x00,
+	1, 0x00, 0xA3,	0x3C,
+	1, 0x00, 0xB2,	0x09,
+	1, 0x00, 0xB7,	0x00,
+	1, 0x00, 0xBB,	0x3C,
+	1, 0x00, 0xCA,	0x09,
+	1, 0x00, 0xD9,	0x05,
+	3, 0x00, 0xDB,	0xCE, 0x03, 0xF8,
+	5, 0x00, 0xE3,	0x00, 0x04, 0x02, 0x01, 0x03,
+	1, 0x00, 0xF5,	0x02,
+	2, 0x00, 0xFF,	0x05, 0x05,
+	2, 0x01, 0x98,	0x01, 0x05,
+	2, 0x01, 0xA6,	0x1B, 0x1F,
+	2, 0x01, 0xAC,	0x3E, 0x00,
+	1, 0x01, 0xB0,	0x17,
+	// Recommended settings
+	1, 0x00, 0x14,	0x04,			// SYSTEM__INTERRUPT_CONFIG_GPIO: new range sample ready
+	1, 0x00, 0x11,	0x10,			// SYSTEM__MODE_GPIO1: GPIO1 as the interrupt output, active LOW
+};
+
+/**
+ * @brief The single-shot start write (SYSRANGE__START)
+ */
+static const uint8_t startData[3] = {SYSRANGE__START >> 8, SYSRANGE__START & 0xFF, 0x01};
+
+/**
+ * @brief This enum represents the states of the sensors' initialization
+ */
+typedef enum {
+	VL6180X_INIT_POWEROFF = 0,	/**< The sensors are powered down */
+	VL6180X_INIT_POWERUP,		/**< The sensors are powering up */
+	VL6180X_INIT_SENSORBOOT,	/**< A sensor is booting (it has the default address) */
+	VL6180X_INIT_DONE			/**< All the sensors are ready */
+} VL6180X_InitState_t;
+
+/**
+ * @brief The GPIO peripherals connected to the sensors' CE pins
+ */
+static GPIO_TypeDef * const sensorCEGPIO[VL6180X_SENSORS] = {UNIT_VL6180X_1_CE_GPIO, UNIT_VL6180X_2_CE_GPIO, UNIT_VL6180X_3_CE_GPIO, UNIT_VL6180X_4_CE_GPIO};
+
+/**
+ * @brief The GPIO pins connected to the sensors' CE pins
+ */
+static const uint16_t sensorCEPin[VL6180X_SENSORS] = {UNIT_VL6180X_1_CE_PIN, UNIT_VL6180X_2_CE_PIN, UNIT_VL6180X_3_CE_PIN, UNIT_VL6180X_4_CE_PIN};
+
+/**
+ * @brief The GPIO peripherals connected to the sensors' INT (GPIO1) pins
+ */
+static GPIO_TypeDef * const sensorINTGPIO[VL6180X_SENSORS] = {UNIT_VL6180X_1_INT_GPIO, UNIT_VL6180X_2_INT_GPIO, UNIT_VL6180X_3_INT_GPIO, UNIT_VL6180X_4_INT_GPIO};
+
+/**
+ * @brief The GPIO pins connected to the sensors' INT (GPIO1) pins, also their EXTI lines
+ */
+static const uint16_t sensorINTPin[VL6180X_SENSORS] = {UNIT_VL6180X_1_INT_PIN, UNIT_VL6180X_2_INT_PIN, UNIT_VL6180X_3_INT_PIN, UNIT_VL6180X_4_INT_PIN};
+
+/**
+ * @brief The current state of the sensors' initialization
+ */
+static VL6180X_InitState_t initState = VL6180X_INIT_POWEROFF;
+
+/**
+ * @brief The time the current initialization state was entered at
+ */
+static uint32_t initTimestamp = 0;
+
+/**
+ * @brief The index of the sensor that is booting
+ */
+static uint8_t initSensor = 0;
+
+/**
+ * @brief Bit mask of the sensors that are set up and ranging
+ */
+static uint8_t sensorReady = 0;
+
+/**
+ * @brief Bit mask of the sensors that signal their samples through an EXTI line. The rest shares the line with another sensor and is polled.
+ */
+static uint8_t sensorEXTI = 0;
+
+/**
+ * @brief The EXTI lines taken by the sensors
+ */
+static uint16_t extiLines = 0;
+
+/**
+ * @brief Sample ready flags, set by the EXTI interrupt and cleared when the sample is read
+ */
+static volatile bool sampleNotified[VL6180X_SENSORS] = {false};
+
+/**
+ * @brief The time each sensor was last read or polled at
+ */
+static uint32_t sensorPollTime[VL6180X_SENSORS] = {0};
+
+/**
+ * @brief The sample fetch of each sensor
+ */
+static VL6180X_Fetch_t sensorFetch[VL6180X_SENSORS];
+
+/**
+ * @brief The ranging configuration in use
+ */
+static VL6180X_Ranging_t rangingConfig = {VL6180X_MODE_CONTINUOUS, 4, 0};
+
+/**
+ * @brief The requested ranging configuration, applied by VL6180X_Tick()
+ */
+static VL6180X_Ranging_t rangingRequest = {VL6180X_MODE_CONTINUOUS, 4, 0};
+
+/**
+ * @brief A ranging configuration is waiting to be applied (the initial one is applied once the sensors are booted)
+ */
+static volatile bool rangingPending = true;
+
+/**
+ * @brief The current state of the ranging scheduler
+ */
+static volatile VL6180X_RangingState_t rangingState = VL6180X_RANGING_STOPPED;
+
+/**
+ * @brief The index of the sensor that ranges (round-robin) or was started last (stagger)
+ */
+static volatile uint8_t rangingSensor = 0;
+
+/**
+ * @brief The time the ranging sensor was started at (in ms for the round-robin, in cycles for the stagger)
+ */
+static volatile uint32_t rangingTimestamp = 0;
+
+/**
+ * @brief The time the continuous ranging was last staggered at (in ms)
+ */
+static uint32_t staggerTimestamp = 0;
+
+/**
+ * @brief The bus time of the sensors' initializations, the settings and the address changes (in us)
+ */
+static uint32_t initBusTime = 0;
+
+/**
+ * @brief The amount of the initialization settings that didn't read back as written (VL6180X_INIT_VERIFY)
+ */
+static uint16_t initMismatches = 0;
+
+/**
+ * @brief The time the sample rate window started at
+ */
+static uint32_t rateTimestamp = 0;
+
+/**
+ * @brief The amount of samples of each sensor at the start of the rate window
+ */
+static uint32_t rateSamples[VL6180X_SENSORS] = {0};
+
+static void VL6180X_ReadRegs(uint8_t i2c_address, uint16_t reg, uint8_t *data, uint8_t length);
+static void VL6180X_WriteRegs(uint8_t i2c_address, uint16_t reg, const uint8_t *data, uint8_t length);
 static uint8_t VL6180X_ReadReg(uint8_t i2c_address, uint16_t reg);
 static void VL6180X_WriteReg(uint8_t i2c_address, uint16_t reg, uint8_t val);
+static void VL6180X_WriteRegsChecked(uint8_t i2c_address, uint16_t reg, const uint8_t *data, uint8_t length);
 static void VL6180X_SensorSetup(uint8_t sensor_id);
 static void VL6180X_SensorSetAddress(uint8_t old_address, uint8_t new_address);
 static void VL6180X_GPIO_CE_Init(GPIO_TypeDef *gpio, uint16_t pin);
 static void VL6180X_GPIO_INT_Init(GPIO_TypeDef *gpio, uint16_t pin);
+static void VL6180X_EXTI_Init(uint8_t index);
+static void VL6180X_FetchInit(uint8_t index, uint8_t sensor_id);
+static void VL6180X_FetchDone(HYPER_I2C_Transfer_t *transfer);
+static void VL6180X_StartDone(HYPER_I2C_Transfer_t *transfer);
+static void VL6180X_RangingApply(void);
+static void VL6180X_RangingNext(void);
+static uint32_t VL6180X_RangingPeriod(const VL6180X_Ranging_t *ranging);
 
 /**
- * @brief This function reads data from the sensor's register
+ * @brief This function reads consecutive registers of the sensor in one transaction (the register address auto-increments)
  * @param i2c_address I2C address of the sensor
- * @param reg Register's address
- * @return Register value
+ * @param reg The first register's address
+ * @param data Pointer to the output buffer
+ * @param length The amount of registers to read
  */
-static uint8_t VL6180X_ReadReg(uint8_t i2c_address, uint16_t reg) {
-	// Make sure the bus is ready
-	while(I2C_GetFlagStatus(VL6180X_I2C, I2C_FLAG_BUSY));
+static void VL6180X_ReadRegs(uint8_t i2c_address, uint16_t reg, uint8_t *data, uint8_t length) {
+	uint8_t tx_data[2] = {reg >> 8, reg & 0xFF};
 
-	// Generate START condition
-	I2C_GenerateSTART(VL6180X_I2C, ENABLE);
-	while(!I2C_CheckEvent(VL6180X_I2C, I2C_EVENT_MASTER_MODE_SELECT));
-
-	// Send VL6180X's I2C address
-	I2C_Send7bitAddress(VL6180X_I2C, i2c_address, I2C_Direction_Transmitter);
-	while(!I2C_CheckEvent(VL6180X_I2C, I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED));
-
-	// Send MSB of the register's address
-	I2C_SendData(VL6180X_I2C, (uint8_t)(reg >> 8));
-	while(!I2C_CheckEvent(VL6180X_I2C, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
-	// Send LSB of the register's address
-	I2C_SendData(VL6180X_I2C, (uint8_t)(reg & 0xFF));
-	while(!I2C_CheckEvent(VL6180X_I2C, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
-
-	// Generate START condition
-	I2C_GenerateSTART(VL6180X_I2C, ENABLE);
-	while(!I2C_CheckEvent(VL6180X_I2C, I2C_EVENT_MASTER_MODE_SELECT));
-
-	// Send VL6180X's I2C address
-	I2C_Send7bitAddress(VL6180X_I2C, i2c_address, I2C_Direction_Receiver);
-	while(!I2C_CheckEvent(VL6180X_I2C, I2C_EVENT_MASTER_RECEIVER_MODE_SELECTED));
+	HYPER_I2C_Transfer_t transfer = {0};
+	transfer.bus = VL6180X_I2C;
+	transfer.address = i2c_address;
+	transfer.txData = tx_data;
+	transfer.txLength = sizeof(tx_data);
+	transfer.rxData = data;
+	transfer.rxLength = length;
+	HYPER_I2C_Run(&transfer);
+}
 
-	// Disable ACK
-	I2C_AcknowledgeConfig(VL6180X_I2C, DISABLE);
+/**
+ * @brief This function writes consecutive registers of the sensor in one transaction (the register address auto-increments)
+ * @param i2c_address I2C address of the sensor
+ * @param reg The first register's address
+ * @param data Pointer to the written values
+ * @param length The amount of registers to write (VL6180X_BURST_MAX max, the rest is ignored)
+ */
+static void VL6180X_WriteRegs(uint8_t i2c_address, uint16_t reg, const uint8_t *data, uint8_t length) {
+	uint8_t tx_data[2 + VL6180X_BURST_MAX] = {reg >> 8, reg & 0xFF};
+	if(length > VL6180X_BURST_MAX)
+		length = VL6180X_BURST_MAX;
+	for(uint8_t i = 0; i < length; i++)
+		tx_data[2 + i] = data[i];
 
-	// Receive the data
-	while(!I2C_CheckEvent(VL6180X_I2C, I2C_EVENT_MASTER_BYTE_RECEIVED));
-	uint8_t data = I2C_ReceiveData(VL6180X_I2C);
+	HYPER_I2C_Transfer_t transfer = {0};
+	transfer.bus = VL6180X_I2C;
+	transfer.address = i2c_address;
+	transfer.txData = tx_data;
+	transfer.txLength = 2 + length;
+	HYPER_I2C_Run(&transfer);
+}
 
-	// Generate STOP condition
-	I2C_GenerateSTOP(VL6180X_I2C, ENABLE);
+/**
+ * @brief This function writes consecutive registers of the sensor, then reads them back and counts the mismatches (if VL6180X_INIT_VERIFY is enabled)
+ * @param i2c_address I2C address of the sensor
+ * @param reg The first register's address
+ * @param data Pointer to the written values
+ * @param length The amount of registers to write (VL6180X_BURST_MAX max)
+ */
+static void VL6180X_WriteRegsChecked(uint8_t i2c_address, uint16_t reg, const uint8_t *data, uint8_t length) {
+	VL6180X_WriteRegs(i2c_address, reg, data, length);
 
-	// Enable ACK
-	I2C_AcknowledgeConfig(VL6180X_I2C, ENABLE);
+#if VL6180X_INIT_VERIFY
+	uint8_t readback[VL6180X_BURST_MAX];
+	VL6180X_ReadRegs(i2c_address, reg, readback, length);
+	for(uint8_t i = 0; i < length; i++) {
+		if(readback[i] != data[i]) {
+			initMismatches++;
+			HYPER_Health_Report(HEALTH_I2CFAILURE);
+		}
+	}
+#endif
+}
 
+/**
+ * @brief This function reads data from the sensor's register
+ * @param i2c_address I2C address of the sensor
+ * @param reg Register's address
+ * @return Register value
+ */
+static uint8_t VL6180X_ReadReg(uint8_t i2c_address, uint16_t reg) {
+	uint8_t data = 0;
+	VL6180X_ReadRegs(i2c_address, reg, &data, 1);
 	return data;
 }
 
@@ -90,39 +351,17 @@ static uint8_t VL6180X_ReadReg(uint8_t i2c_address, uint16_t reg) {
  * @param val Value to be written
  */
 static void VL6180X_WriteReg(uint8_t i2c_address, uint16_t reg, uint8_t val) {
-	// Make sure the bus is ready
-	while(I2C_GetFlagStatus(VL6180X_I2C, I2C_FLAG_BUSY));
-
-	// Generate START condition
-	I2C_GenerateSTART(VL6180X_I2C, ENABLE);
-	while(!I2C_CheckEvent(VL6180X_I2C, I2C_EVENT_MASTER_MODE_SELECT));
-
-	// Send VL6180X's I2C address
-	I2C_Send7bitAddress(VL6180X_I2C, i2c_address, I2C_Direction_Transmitter);
-	while(!I2C_CheckEvent(VL6180X_I2C, I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED));
-
-	// Send MSB of the register's address
-	I2C_SendData(VL6180X_I2C, (uint8_t)(reg >> 8));
-	while(!I2C_CheckEvent(VL6180X_I2C, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
-	// Send LSB of the register's address
-	I2C_SendData(VL6180X_I2C, (uint8_t)(reg & 0xFF));
-	while(!I2C_CheckEvent(VL6180X_I2C, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
-	// Send the data
-	I2C_SendData(VL6180X_I2C, val);
-	while(!I2C_CheckEvent(VL6180X_I2C, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
-
-	// Generate STOP condition
-	I2C_GenerateSTOP(VL6180X_I2C, ENABLE);
+	VL6180X_WriteRegs(i2c_address, reg, &val, 1);
 }
 
 /**
- * @brief This function initializes resources used by all VL6180X sensors. It must be called before any VL6180X_InitSensor() call.
+ * @brief This function initializes resources used by all VL6180X sensors and starts their initialization
+ * (power cycling, then booting the sensors one by one), which is advanced by VL6180X_InitTick().
  */
 void VL6180X_Init(void) {
 	// RCC setup
 	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA, ENABLE);
 	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOB, ENABLE);
-	RCC_APB1PeriphClockCmd(RCC_APB1Periph_I2C2, ENABLE);
 	RCC_APB2PeriphClockCmd(RCC_APB2Periph_AFIO, ENABLE);
 
 	// CE and INT pins setup
@@ -142,68 +381,65 @@ void VL6180X_Init(void) {
 	gpio_init.GPIO_Speed = GPIO_Speed_2MHz;
 	GPIO_Init(UNIT_VL6180X_POWER_GPIO, &gpio_init);
 
-	// Reset all the VL6180X sensors by disabling powering them down for 100ms
+	// Reset all the VL6180X sensors by powering them down (for VL6180X_POWEROFF_TIME)
 	UNIT_VL6180X_POWER_GPIO->BSRR = UNIT_VL6180X_POWER_PIN; // Power OFF
-	HYPER_Delay(100);
-	UNIT_VL6180X_POWER_GPIO->BRR = UNIT_VL6180X_POWER_PIN; // Power ON
-
-	// Wait for the sensors to power up again
-	HYPER_Delay(100);
-
-	// I2C2 SCL(PB10), SDA(PB11) pins setup
-	GPIO_InitTypeDef GPIO_InitStruct;
-	GPIO_InitStruct.GPIO_Pin = GPIO_Pin_10 | GPIO_Pin_11;
-	GPIO_InitStruct.GPIO_Mode = GPIO_Mode_AF_OD;
-	GPIO_InitStruct.GPIO_Speed = GPIO_Speed_10MHz;
-	GPIO_Init(GPIOB, &GPIO_InitStruct);
-
-	// I2C setup
-	I2C_DeInit(VL6180X_I2C);
-	I2C_InitTypeDef I2C_InitStruct;
-	I2C_InitStruct.I2C_Mode = I2C_Mode_I2C;
-	I2C_InitStruct.I2C_ClockSpeed = 400000;
-	I2C_InitStruct.I2C_DutyCycle = I2C_DutyCycle_2;
-	I2C_InitStruct.I2C_Ack = I2C_Ack_Enable;
-	I2C_InitStruct.I2C_AcknowledgedAddress = I2C_AcknowledgedAddress_7bit;
-	I2C_Init(VL6180X_I2C, &I2C_InitStruct);
-
-	// Enable I2C
-	I2C_Cmd(VL6180X_I2C, ENABLE);
-
-	// Wait for I2C to become ready
-	while(I2C_GetFlagStatus(VL6180X_I2C, I2C_FLAG_BUSY));
+	initState = VL6180X_INIT_POWEROFF;
+	initTimestamp = HYPER_Delay_GetTime();
+	rangingState = VL6180X_RANGING_STOPPED;
+	rangingPending = true;
+	initBusTime = 0;
+	initMismatches = 0;
+	sensorReady = 0;
+	sensorEXTI = 0;
+	extiLines = 0;
 }
 
 /**
- * @brief This function initializes selected VL6180X sensor. VL6180X_Init() must be called once before calling this function.
- * @param sensor_id Sensor's ID (VL6180X_ID1, VL6180X_ID2, VL6180X_ID3, VL6180X_ID4)
+ * @brief This function advances the sensors' initialization without blocking. It should be run until it returns true (@see hyper_boot.h).
+ * The sensors are booted one at a time, since each of them starts with the default I2C address.
+ * @return true once all the sensors are set up and ranging, false otherwise
  */
-void VL6180X_InitSensor(uint8_t sensor_id) {
-	if(sensor_id == VL6180X_ID1) {
-		// Enable sensor by letting CE go HIGH
-		UNIT_VL6180X_1_CE_GPIO->BSRR = UNIT_VL6180X_1_CE_PIN;
-	}
-	else if(sensor_id == VL6180X_ID2) {
-		// Enable sensor by letting CE go HIGH
-		UNIT_VL6180X_2_CE_GPIO->BSRR = UNIT_VL6180X_2_CE_PIN;
-	}
-	else if(sensor_id == VL6180X_ID3) {
-		// Enable sensor by letting CE go HIGH
-		UNIT_VL6180X_3_CE_GPIO->BSRR = UNIT_VL6180X_3_CE_PIN;
-	}
-	else if(sensor_id == VL6180X_ID4) {
-		// Enable sensor by letting CE go HIGH
-		UNIT_VL6180X_4_CE_GPIO->BSRR = UNIT_VL6180X_4_CE_PIN;
+bool VL6180X_InitTick(void) {
+	if(initState == VL6180X_INIT_POWEROFF && HYPER_Delay_Check(initTimestamp, VL6180X_POWEROFF_TIME)) {
+		UNIT_VL6180X_POWER_GPIO->BRR = UNIT_VL6180X_POWER_PIN; // Power ON
+		initState = VL6180X_INIT_POWERUP;
+		initTimestamp = HYPER_Delay_GetTime();
 	}
+	else if(initState == VL6180X_INIT_POWERUP && HYPER_Delay_Check(initTimestamp, VL6180X_POWERUP_TIME)) {
+		// The sensors boot with the default address, then each gets its own
+		HYPER_I2C_AddDevice(VL6180X_I2C, VL6180X_ADDR, VL6180X_SPEED);
+		for(uint8_t i = 0; i < VL6180X_SENSORS; i++)
+			HYPER_I2C_AddDevice(VL6180X_I2C, (i + 1) << 1, VL6180X_SPEED);
 
-	// Wait for the sensor to become available
-	HYPER_Delay(80);
+		// Enable the 1st sensor by letting CE go HIGH
+		initSensor = 0;
+		sensorCEGPIO[initSensor]->BSRR = sensorCEPin[initSensor];
+		initState = VL6180X_INIT_SENSORBOOT;
+		initTimestamp = HYPER_Delay_GetTime();
+	}
+	else if(initState == VL6180X_INIT_SENSORBOOT && HYPER_Delay_Check(initTimestamp, VL6180X_BOOT_TIME)) {
+		// Setup the sensor (it has the default address right now), then set its I2C address to the target value
+		uint8_t sensor_id = (initSensor + 1) << 1;
+		uint32_t start = HYPER_Cycles_Get();
+		VL6180X_SensorSetup(VL6180X_ADDR);
+		VL6180X_SensorSetAddress(VL6180X_ADDR, sensor_id >> 1);
+		initBusTime += HYPER_Cycles_ToMicros(HYPER_Cycles_Get() - start);
+		VL6180X_EXTI_Init(initSensor);
+		VL6180X_FetchInit(initSensor, sensor_id);
+		sensorPollTime[initSensor] = HYPER_Delay_GetTime();
+		sensorReady |= 1 << initSensor;
 
-	// Setup the sensor (it has the default address right now)
-	VL6180X_SensorSetup(VL6180X_ADDR);
+		// Enable the next sensor
+		if(++initSensor < VL6180X_SENSORS) {
+			sensorCEGPIO[initSensor]->BSRR = sensorCEPin[initSensor];
+			initTimestamp = HYPER_Delay_GetTime();
+		}
+		else {
+			initState = VL6180X_INIT_DONE;
+		}
+	}
 
-	// Set sensor's I2C address to the target value
-	VL6180X_SensorSetAddress(VL6180X_ADDR, sensor_id >> 1);
+	return initState == VL6180X_INIT_DONE;
 }
 
 /**
@@ -211,48 +447,21 @@ void VL6180X_InitSensor(uint8_t sensor_id) {
  * @param sensor_id ID of the selected sensor
  */
 static void VL6180X_SensorSetup(uint8_t sensor_id) {
-	// Required - SR03 settings from application note AN4545
-	VL6180X_WriteReg(sensor_id, 0x0207, 0x01);
-	VL6180X_WriteReg(sensor_id, 0x0208, 0x01);
-	VL6180X_WriteReg(sensor_id, 0x0096, 0x00);
-	VL6180X_WriteReg(sensor_id, 0x0097, 0xfd);
-	VL6180X_WriteReg(sensor_id, 0x00e3, 0x00);
-	VL6180X_WriteReg(sensor_id, 0x00e4, 0x04);
-	VL6180X_WriteReg(sensor_id, 0x00e5, 0x02);
-	VL6180X_WriteReg(sensor_id, 0x00e6, 0x01);
-	VL6180X_WriteReg(sensor_id, 0x00e7, 0x03);
-	VL6180X_WriteReg(sensor_id, 0x00f5, 0x02);
-	VL6180X_WriteReg(sensor_id, 0x00d9, 0x05);
-	VL6180X_WriteReg(sensor_id, 0x00db, 0xce);
-	VL6180X_WriteReg(sensor_id, 0x00dc, 0x03);
-	VL6180X_WriteReg(sensor_id, 0x00dd, 0xf8);
-	VL6180X_WriteReg(sensor_id, 0x009f, 0x00);
-	VL6180X_WriteReg(sensor_id, 0x00a3, 0x3c);
-	VL6180X_WriteReg(sensor_id, 0x00b7, 0x00);
-	VL6180X_WriteReg(sensor_id, 0x00bb, 0x3c);
-	VL6180X_WriteReg(sensor_id, 0x00b2, 0x09);
-	VL6180X_WriteReg(sensor_id, 0x00ca, 0x09);
-	VL6180X_WriteReg(sensor_id, 0x0198, 0x01);
-	VL6180X_WriteReg(sensor_id, 0x01b0, 0x17);
-	VL6180X_WriteReg(sensor_id, 0x01ad, 0x00);
-	VL6180X_WriteReg(sensor_id, 0x00ff, 0x05);
-	VL6180X_WriteReg(sensor_id, 0x0100, 0x05);
-	VL6180X_WriteReg(sensor_id, 0x0199, 0x05);
-	VL6180X_WriteReg(sensor_id, 0x01a6, 0x1b);
-	VL6180X_WriteReg(sensor_id, 0x01ac, 0x3e);
-	VL6180X_WriteReg(sensor_id, 0x01a7, 0x1f);
-	VL6180X_WriteReg(sensor_id, 0x0030, 0x00);
-
-	// Recommended / optional settings:
-	VL6180X_WriteReg(sensor_id, READOUT__AVERAGING_SAMPLE_PERIOD, 0x0); // No averaging
-	VL6180X_WriteReg(sensor_id, SYSRANGE__VHV_REPEAT_RATE, 0xFF); // Number of range measurements after which auto calibration of system is performed
-	VL6180X_WriteReg(sensor_id, SYSRANGE__VHV_RECALIBRATE, 0x01); // perform a single temperature calibration of the ranging sensor
-	VL6180X_WriteReg(sensor_id, SYSRANGE__INTERMEASUREMENT_PERIOD, 0x0); // Time delay between measurements in Ranging continuous mode (0 -> 10ms)
-	VL6180X_WriteReg(sensor_id, SYSRANGE__MAX_CONVERGENCE_TIME, 0x4); // 4ms
-	VL6180X_WriteReg(sensor_id, SYSTEM__INTERRUPT_CONFIG_GPIO, 0x04); // Interrupt source: new range sample ready
-
-	// Start continuous mode
-	VL6180X_WriteReg(sensor_id, SYSRANGE__START, 0x03);
+	// Required SR03 settings (application note AN4545), then the recommended ones, in auto-increment bursts
+	for(uint16_t i = 0; i < sizeof(sensorInitTable); i += 3 + sensorInitTable[i]) {
+		uint16_t reg = (sensorInitTable[i + 1] << 8) | sensorInitTable[i + 2];
+		VL6180X_WriteRegsChecked(sensor_id, reg, &sensorInitTable[i + 3], sensorInitTable[i]);
+	}
+
+	// Runtime settings @see VL6180X_SetRanging()
+	const uint8_t timing[2] = {VL6180X_RangingPeriod(&rangingConfig) / VL6180X_PERIOD - 1, rangingConfig.convergence}; // Continuous mode period, max convergence time
+	VL6180X_WriteRegsChecked(sensor_id, READOUT__AVERAGING_SAMPLE_PERIOD, &rangingConfig.averaging, 1);
+	VL6180X_WriteRegsChecked(sensor_id, SYSRANGE__INTERMEASUREMENT_PERIOD, timing, sizeof(timing));
+
+	// Perform a single temperature calibration of the ranging sensor (once it's configured)
+	VL6180X_WriteReg(sensor_id, SYSRANGE__VHV_RECALIBRATE, 0x01);
+
+	// The ranging is started by the scheduler, once all the sensors are booted (@see VL6180X_Tick())
 }
 
 /**
@@ -265,24 +474,457 @@ static void VL6180X_SensorSetAddress(uint8_t old_address, uint8_t new_address) {
 }
 
 /**
- * @brief This function checks if there's a new sample ready to be read from the sensor
+ * @brief This function sets up a sensor's sample fetch
+ * @param index The sensor's index
+ * @param sensor_id Sensor's ID (also its I2C address)
+ */
+static void VL6180X_FetchInit(uint8_t index, uint8_t sensor_id) {
+	VL6180X_Fetch_t *fetch = &sensorFetch[index];
+	fetch->state = VL6180X_FETCH_IDLE;
+	fetch->index = index;
+	fetch->stats = (VL6180X_Stats_t){0};
+	fetch->read = (HYPER_I2C_Transfer_t){0};
+	fetch->read.bus = VL6180X_I2C;
+	fetch->read.address = sensor_id;
+	fetch->read.txData = fetch->readReg;
+	fetch->read.txLength = sizeof(fetch->readReg);
+	fetch->read.context = fetch;
+	fetch->clear = (HYPER_I2C_Transfer_t){0};
+	fetch->clear.bus = VL6180X_I2C;
+	fetch->clear.address = sensor_id;
+	fetch->clear.txData = clearData;
+	fetch->clear.txLength = sizeof(clearData);
+	fetch->clear.callback = VL6180X_FetchDone;
+	fetch->clear.context = fetch;
+	fetch->start = (HYPER_I2C_Transfer_t){0};
+	fetch->start.bus = VL6180X_I2C;
+	fetch->start.address = sensor_id;
+	fetch->start.txData = startData;
+	fetch->start.txLength = sizeof(startData);
+	fetch->start.callback = VL6180X_StartDone;
+	fetch->start.context = fetch;
+}
+
+/**
+ * @brief This function queues a transfer of a sample fetch
+ * @param fetch Pointer to the sensor's fetch
+ * @param transfer Pointer to the fetch's transfer
+ * @return true if the transfer was queued, false otherwise
+ */
+static bool VL6180X_FetchSubmit(VL6180X_Fetch_t *fetch, HYPER_I2C_Transfer_t *transfer) {
+	fetch->stats.transfers++;
+	return HYPER_I2C_Submit(transfer);
+}
+
+/**
+ * @brief This function starts the read of a polled sensor's interrupt status (a single byte), the range is fetched
+ * only when it shows a new sample
+ * @param fetch Pointer to the sensor's fetch
+ */
+static void VL6180X_FetchStatus(VL6180X_Fetch_t *fetch) {
+	fetch->readReg[0] = RESULT__INTERRUPT_STATUS_GPIO >> 8;
+	fetch->readReg[1] = RESULT__INTERRUPT_STATUS_GPIO & 0xFF;
+	fetch->read.rxData = &fetch->status;
+	fetch->read.rxLength = 1;
+	fetch->read.callback = VL6180X_FetchDone;
+
+	// The state has to be set before the transfer can complete
+	fetch->state = VL6180X_FETCH_STATUS;
+	if(!VL6180X_FetchSubmit(fetch, &fetch->read))
+		fetch->state = VL6180X_FETCH_IDLE;
+}
+
+/**
+ * @brief This function starts the fetch of a new sample: the range read and the interrupt clear are queued together,
+ * the bus runs them back to back and only the clear completion is handled. It is run from the main loop for a signaled
+ * sample, or from the I2C interrupt for a polled one.
+ * @param fetch Pointer to the sensor's fetch
+ */
+static void VL6180X_FetchRange(VL6180X_Fetch_t *fetch) {
+	fetch->readReg[0] = RESULT__RANGE_VAL >> 8;
+	fetch->readReg[1] = RESULT__RANGE_VAL & 0xFF;
+	fetch->read.rxData = &fetch->result;
+	fetch->read.rxLength = 1;
+	fetch->read.callback = 0;
+
+	fetch->state = VL6180X_FETCH_CLEAR;
+	if(!VL6180X_FetchSubmit(fetch, &fetch->read) || !VL6180X_FetchSubmit(fetch, &fetch->clear))
+		fetch->state = VL6180X_FETCH_IDLE;
+}
+
+/**
+ * @brief This function advances a sample fetch when its transfer completes (run from the I2C interrupt)
+ * @param transfer Pointer to the completed transfer
+ */
+static void VL6180X_FetchDone(HYPER_I2C_Transfer_t *transfer) {
+	VL6180X_Fetch_t *fetch = transfer->context;
+
+	if(transfer == &fetch->read) {
+		// Polled sensor, fetch the range if there is a new sample
+		if(transfer->status == I2C_STATUS_DONE && (fetch->status & 0x07) == 0x04) {
+			VL6180X_FetchRange(fetch);
+		}
+		else {
+			fetch->state = VL6180X_FETCH_IDLE;
+		}
+	}
+	else {
+		if(transfer->status == I2C_STATUS_DONE && fetch->read.status == I2C_STATUS_DONE) {
+			fetch->range = fetch->result;
+			fetch->state = VL6180X_FETCH_DONE;
+		}
+		else {
+			fetch->state = VL6180X_FETCH_IDLE;
+		}
+
+		// The sensor's measurement is over, the next one may start its own
+		if(fetch->index == rangingSensor)
+			VL6180X_RangingNext();
+	}
+}
+
+/**
+ * @brief This function handles the completion of a single-shot start (run from the I2C interrupt)
+ * @param transfer Pointer to the completed transfer
+ */
+static void VL6180X_StartDone(HYPER_I2C_Transfer_t *transfer) {
+	// The sensor didn't take the start, skip it
+	if(transfer->status != I2C_STATUS_DONE)
+		VL6180X_RangingNext();
+}
+
+/**
+ * @brief This function starts the single-shot measurement of the next ready sensor, when the round-robin ranging runs.
+ * It is run from the I2C interrupt, or with the interrupts masked.
+ */
+static void VL6180X_RangingNext(void) {
+	// The measurement a reconfiguration waited for is over
+	if(rangingState == VL6180X_RANGING_DRAIN) {
+		rangingState = VL6180X_RANGING_STOPPED;
+		return;
+	}
+	if(rangingState != VL6180X_RANGING_RUN || rangingConfig.mode != VL6180X_MODE_ROUNDROBIN)
+		return;
+
+	uint8_t next = rangingSensor;
+	for(uint8_t i = 0; i < VL6180X_SENSORS; i++) {
+		next = (next + 1) % VL6180X_SENSORS;
+		if(sensorReady & (1 << next))
+			break;
+	}
+
+	// Only one sensor emits at a time, there is no cross-talk
+	rangingSensor = next;
+	rangingTimestamp = HYPER_Delay_GetTime();
+	VL6180X_FetchSubmit(&sensorFetch[next], &sensorFetch[next].start);
+}
+
+/**
+ * @brief This function computes the continuous ranging period of the configuration: the shortest SYSRANGE__INTERMEASUREMENT_PERIOD
+ * step that fits a whole measurement (the pre-calibration, the maximum convergence time and the readout averaging)
+ * @param ranging The ranging configuration
+ * @return The measurement period (in us, a multiple of VL6180X_PERIOD)
+ */
+static uint32_t VL6180X_RangingPeriod(const VL6180X_Ranging_t *ranging) {
+	uint32_t measurement = VL6180X_PRECAL_TIME + ranging->convergence * 1000 + 1300 + ranging->averaging * 645 / 10;
+	return (measurement + VL6180X_PERIOD - 1) / VL6180X_PERIOD * VL6180X_PERIOD;
+}
+
+/**
+ * @brief This function stops the ranging. The continuous ranging of the started sensors is toggled off by a start write
+ * (it waits for the bus), the round-robin chain stops by itself.
+ */
+static void VL6180X_RangingStop(void) {
+	VL6180X_RangingState_t state = rangingState;
+	rangingState = VL6180X_RANGING_STOPPED;
+	if(rangingConfig.mode != VL6180X_MODE_CONTINUOUS)
+		return;
+
+	for(uint8_t i = 0; i < VL6180X_SENSORS; i++) {
+		bool started = (state == VL6180X_RANGING_RUN) || (state == VL6180X_RANGING_STAGGER && i <= rangingSensor);
+		if((sensorReady & (1 << i)) && started)
+			VL6180X_WriteReg((i + 1) << 1, SYSRANGE__START, 0x01);
+	}
+}
+
+/**
+ * @brief This function starts the ranging in the configured mode
+ */
+static void VL6180X_RangingStart(void) {
+	if(!sensorReady)
+		return;
+
+	// Start from the first ready sensor, the rest follows through VL6180X_Tick() (stagger) or the interrupts (round-robin)
+	uint8_t first = 0;
+	while(!(sensorReady & (1 << first)))
+		first++;
+	if(rangingConfig.mode == VL6180X_MODE_CONTINUOUS) {
+		VL6180X_WriteReg((first + 1) << 1, SYSRANGE__START, 0x03);
+		rangingSensor = first;
+		rangingTimestamp = HYPER_Cycles_Get();
+		rangingState = VL6180X_RANGING_STAGGER;
+	}
+	else {
+		rangingSensor = (first + VL6180X_SENSORS - 1) % VL6180X_SENSORS;
+		__disable_irq();
+		rangingState = VL6180X_RANGING_RUN;
+		VL6180X_RangingNext();
+		__enable_irq();
+	}
+}
+
+/**
+ * @brief This function applies the requested ranging configuration: the ranging is stopped, the sensors are reconfigured
+ * and the ranging is started again in the requested mode. It waits for the bus (a few transactions per sensor).
+ * A round-robin measurement must not be in progress (@see VL6180X_RANGING_DRAIN).
+ */
+static void VL6180X_RangingApply(void) {
+	VL6180X_RangingStop();
+
+	__disable_irq();
+	rangingConfig = rangingRequest;
+	rangingPending = false;
+	__enable_irq();
+
+	for(uint8_t i = 0; i < VL6180X_SENSORS; i++) {
+		if(!(sensorReady & (1 << i)))
+			continue;
+		uint8_t sensor_id = (i + 1) << 1;
+		VL6180X_WriteReg(sensor_id, SYSRANGE__INTERMEASUREMENT_PERIOD, VL6180X_RangingPeriod(&rangingConfig) / VL6180X_PERIOD - 1);
+		VL6180X_WriteReg(sensor_id, SYSRANGE__MAX_CONVERGENCE_TIME, rangingConfig.convergence);
+		VL6180X_WriteReg(sensor_id, READOUT__AVERAGING_SAMPLE_PERIOD, rangingConfig.averaging);
+	}
+
+	VL6180X_RangingStart();
+}
+
+/**
+ * @brief This function runs the ranging scheduler: it applies the requested configuration, starts the continuous ranging
+ * with the sensors' measurement windows staggered (and staggers them again every VL6180X_RESTAGGER_PERIOD), restarts
+ * a stalled round-robin and measures the sample rates.
+ * It should be run as a background task (and starts its work once the sensors are booted).
+ */
+void VL6180X_Tick(void) {
+	if(initState != VL6180X_INIT_DONE)
+		return;
+
+	if(rangingPending) {
+		// The settings of a single-shot measurement in progress can't change, the chain is stopped and the shot finishes first
+		if(rangingState == VL6180X_RANGING_RUN && rangingConfig.mode == VL6180X_MODE_ROUNDROBIN)
+			rangingState = VL6180X_RANGING_DRAIN;
+		if(rangingState == VL6180X_RANGING_DRAIN && HYPER_Delay_Check(rangingTimestamp, rangingConfig.convergence + VL6180X_SHOT_TIMEOUT))
+			rangingState = VL6180X_RANGING_STOPPED;
+		if(rangingState != VL6180X_RANGING_DRAIN)
+			VL6180X_RangingApply();
+	}
+
+	if(rangingState == VL6180X_RANGING_STAGGER) {
+		// Spread the ready sensors evenly over the measurement period
+		uint8_t count = __builtin_popcount(sensorReady);
+		if(HYPER_Cycles_Check(rangingTimestamp, HYPER_Cycles_FromMicros(VL6180X_RangingPeriod(&rangingConfig) / count))) {
+			uint8_t next = rangingSensor + 1;
+			while(next < VL6180X_SENSORS && !(sensorReady & (1 << next)))
+				next++;
+			if(next < VL6180X_SENSORS) {
+				VL6180X_WriteReg((next + 1) << 1, SYSRANGE__START, 0x03);
+				rangingSensor = next;
+				rangingTimestamp = HYPER_Cycles_Get();
+			}
+			else {
+				rangingState = VL6180X_RANGING_RUN;
+				staggerTimestamp = HYPER_Delay_GetTime();
+			}
+		}
+	}
+	else if(rangingState == VL6180X_RANGING_RUN && rangingConfig.mode == VL6180X_MODE_CONTINUOUS) {
+		// The windows drift together at the rate of the sensors' oscillator mismatch, stagger them again
+		if(HYPER_Delay_Check(staggerTimestamp, VL6180X_RESTAGGER_PERIOD)) {
+			VL6180X_RangingStop();
+			VL6180X_RangingStart();
+		}
+	}
+	else if(rangingState == VL6180X_RANGING_RUN && rangingConfig.mode == VL6180X_MODE_ROUNDROBIN) {
+		// A missed sample (or a failed sensor) must not stop the round-robin
+		__disable_irq();
+		if(HYPER_Delay_Check(rangingTimestamp, rangingConfig.convergence + VL6180X_SHOT_TIMEOUT))
+			VL6180X_RangingNext();
+		__enable_irq();
+	}
+
+	// Measure the sample rates
+	if(HYPER_Delay_Check(rateTimestamp, VL6180X_RATE_WINDOW)) {
+		rateTimestamp = HYPER_Delay_GetTime();
+		for(uint8_t i = 0; i < VL6180X_SENSORS; i++) {
+			uint32_t samples = sensorFetch[i].stats.samples;
+			uint32_t rate = samples - rateSamples[i];
+			sensorFetch[i].stats.rate = rate > 0xFFFF ? 0xFFFF : rate;
+			rateSamples[i] = samples;
+		}
+	}
+}
+
+/**
+ * @brief This function requests a ranging configuration, applied by VL6180X_Tick(). The round-robin mode ranges
+ * with one sensor at a time (no cross-talk, the rate is shared), the continuous mode (the default, the highest rate)
+ * ranges with all the sensors every 10ms (their measurement windows staggered). A longer convergence time or averaging trades the rate for accuracy,
+ * the continuous ranging period is lengthened (in 10ms steps) to fit a measurement that doesn't fit in 10ms @see VL6180X_RangingPeriod().
+ * @param mode The ranging mode @see VL6180X_Mode_t
+ * @param convergence_ms The maximum convergence time (1..63 ms)
+ * @param averaging The readout averaging sample period (0..255, 1.3ms + 64.5us each)
+ * @return true if the configuration was accepted, false otherwise
+ */
+bool VL6180X_SetRanging(VL6180X_Mode_t mode, uint8_t convergence_ms, uint8_t averaging) {
+	if(mode >= VL6180X_MODES || convergence_ms < 1 || convergence_ms > 63)
+		return false;
+
+	__disable_irq();
+	rangingRequest = (VL6180X_Ranging_t){mode, convergence_ms, averaging};
+	rangingPending = true;
+	__enable_irq();
+	return true;
+}
+
+/**
+ * @brief This function returns the bus time of the sensors' initializations
+ * @return The total time of the settings and the address changes (in us)
+ */
+uint32_t VL6180X_GetInitTime(void) {
+	return initBusTime;
+}
+
+/**
+ * @brief This function returns the amount of the initialization settings that didn't read back as written
+ * @return The amount of mismatches (always 0 if VL6180X_INIT_VERIFY is disabled)
+ */
+uint16_t VL6180X_GetInitMismatches(void) {
+	return initMismatches;
+}
+
+/**
+ * @brief This function returns the ranging configuration in use
+ * @param ranging Pointer to the output structure
+ */
+void VL6180X_GetRanging(VL6180X_Ranging_t *ranging) {
+	*ranging = rangingConfig;
+}
+
+/**
+ * @brief This function returns a new distance sample of the sensor. The I2C transfers run in the background: a sample
+ * signaled by the sensor (or found by polling) is fetched after the call and returned by one of the next calls.
+ * The interrupt-driven sensors are polled only after VL6180X_INT_TIMEOUT without a sample, the rest every VL6180X_POLL_PERIOD.
  * @param sensor_id Sensor's ID (VL6180X_ID1, VL6180X_ID2, VL6180X_ID3, VL6180X_ID4)
- * @return True / false
+ * @param range Pointer to the output value, range in mm
+ * @return true if a new sample was returned, false otherwise (always false until the sensor is initialized)
  */
-bool VL6180X_IsSampleReady(uint8_t sensor_id) {
-	return (VL6180X_ReadReg(sensor_id, RESULT__INTERRUPT_STATUS_GPIO) == 0x04);
+bool VL6180X_ReadRange(uint8_t sensor_id, uint8_t *range) {
+	uint8_t index = VL6180X_INDEX(sensor_id);
+	if(!(sensorReady & (1 << index)))
+		return false;
+	VL6180X_Fetch_t *fetch = &sensorFetch[index];
+
+	if(fetch->state == VL6180X_FETCH_DONE) {
+		*range = fetch->range;
+		fetch->stats.samples++;
+		fetch->state = VL6180X_FETCH_IDLE;
+		sensorPollTime[index] = HYPER_Delay_GetTime();
+		return true;
+	}
+	if(fetch->state != VL6180X_FETCH_IDLE)
+		return false;
+
+	if(sampleNotified[index]) {
+		// Clear the flag first, an edge that comes after this point is a new sample
+		sampleNotified[index] = false;
+		VL6180X_FetchRange(fetch);
+	}
+	else {
+		// No notification, poll the status register when it's due
+		uint32_t poll_period = (sensorEXTI & (1 << index)) ? VL6180X_INT_TIMEOUT : VL6180X_POLL_PERIOD;
+		if(HYPER_Delay_Check(sensorPollTime[index], poll_period)) {
+			sensorPollTime[index] = HYPER_Delay_GetTime();
+			VL6180X_FetchStatus(fetch);
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief This function checks if the sensor stopped responding (HYPER_I2C_FAIL_THRESHOLD consecutive failed transfers)
+ * @param sensor_id Sensor's ID (VL6180X_ID1, VL6180X_ID2, VL6180X_ID3, VL6180X_ID4)
+ * @return true if the sensor's readings should be treated as invalid, false otherwise
+ */
+bool VL6180X_IsFailed(uint8_t sensor_id) {
+	return HYPER_I2C_IsFailed(VL6180X_I2C, sensor_id);
 }
 
 /**
- * @brief This functions acquires a single distance sample from the sensor.
+ * @brief This function copies the fetch statistics of a sensor, their ratio is the I2C cost of a sample
  * @param sensor_id Sensor's ID (VL6180X_ID1, VL6180X_ID2, VL6180X_ID3, VL6180X_ID4)
- * @return Range in mm
+ * @param stats Pointer to the output structure
+ * @return true if the sensor is initialized, false otherwise
  */
-uint8_t VL6180X_GetRange(uint8_t sensor_id) {
-	uint8_t range = VL6180X_ReadReg(sensor_id, RESULT__RANGE_VAL);
-	VL6180X_WriteReg(sensor_id, SYSTEM__INTERRUPT_CLEAR, 0x07);
+bool VL6180X_GetStats(uint8_t sensor_id, VL6180X_Stats_t *stats) {
+	uint8_t index = VL6180X_INDEX(sensor_id);
+	if(index >= VL6180X_SENSORS || !(sensorReady & (1 << index)))
+		return false;
 
-	return range;
+	__disable_irq();
+	*stats = sensorFetch[index].stats;
+	__enable_irq();
+	return true;
+}
+
+/**
+ * @brief This function sends the VL6180X diagnostic reports (DIAG_RANGE, DIAG_RANGERATE)
+ * @param diag_type The requested report @see DiagType_t
+ * @param diag_arg The report argument (the sensor ID of DIAG_RANGE, 0xFF - the initialization)
+ */
+void VL6180X_SendDiag(DiagType_t diag_type, uint8_t diag_arg) {
+	uint8_t data[8];
+	data[0] = diag_type;
+	VL6180X_Stats_t stats;
+
+	if(diag_type == DIAG_RANGERATE) {
+		const uint8_t sensors[4] = {VL6180X_ID1, VL6180X_ID2, VL6180X_ID3, VL6180X_ID4};
+		for(uint8_t i = 0; i < 4; i++) {
+			if(!VL6180X_GetStats(sensors[i], &stats))
+				stats.rate = 0;
+			data[1 + i] = stats.rate > 0xFF ? 0xFF : stats.rate;
+		}
+		VL6180X_Ranging_t ranging;
+		VL6180X_GetRanging(&ranging);
+		data[5] = ranging.mode;
+		data[6] = ranging.convergence;
+		data[7] = ranging.averaging;
+		HYPER_CAN_SendData(UNIT_CAN_ID_DIAG, 8, data);
+		return;
+	}
+
+	if(diag_arg == 0xFF) {
+		uint32_t init_time = VL6180X_GetInitTime();
+		uint16_t mismatches = VL6180X_GetInitMismatches();
+		data[1] = 0xFF;
+		data[2] = init_time >> 24;
+		data[3] = (init_time >> 16) & 0xFF;
+		data[4] = (init_time >> 8) & 0xFF;
+		data[5] = init_time & 0xFF;
+		data[6] = mismatches >> 8;
+		data[7] = mismatches & 0xFF;
+		HYPER_CAN_SendData(UNIT_CAN_ID_DIAG, 8, data);
+		return;
+	}
+
+	if(!VL6180X_GetStats(diag_arg, &stats))
+		return;
+	data[1] = diag_arg;
+	data[2] = (stats.samples >> 16) & 0xFF;
+	data[3] = (stats.samples >> 8) & 0xFF;
+	data[4] = stats.samples & 0xFF;
+	data[5] = (stats.transfers >> 16) & 0xFF;
+	data[6] = (stats.transfers >> 8) & 0xFF;
+	data[7] = stats.transfers & 0xFF;
+	HYPER_CAN_SendData(UNIT_CAN_ID_DIAG, 8, data);
 }
 
 /**
@@ -302,17 +944,103 @@ static void VL6180X_GPIO_CE_Init(GPIO_TypeDef *gpio, uint16_t pin) {
 }
 
 /**
- * @brief This function setups the given pin as a floating input
+ * @brief This function setups the given pin as an input with a pull-up (GPIO1 is an open-drain output)
  * @param gpio GPIOx peripheral
  * @param pin GPIO pin
  */
 static void VL6180X_GPIO_INT_Init(GPIO_TypeDef *gpio, uint16_t pin) {
-	// Setup INT as floating input (unused)
+	// Setup INT as pulled-up input
 	GPIO_InitTypeDef gpio_init;
-	gpio_init.GPIO_Mode = GPIO_Mode_IN_FLOATING;
+	gpio_init.GPIO_Mode = GPIO_Mode_IPU;
 	gpio_init.GPIO_Pin = pin;
 	gpio_init.GPIO_Speed = GPIO_Speed_10MHz;
 	GPIO_Init(gpio, &gpio_init);
 }
 
+/**
+ * @brief This function enables the falling edge interrupt of a sensor's INT pin. A sensor whose EXTI line is already taken
+ * (the same pin number on another port) is left polled.
+ * @param index The sensor's index
+ */
+static void VL6180X_EXTI_Init(uint8_t index) {
+	uint16_t pin = sensorINTPin[index];
+	if(extiLines & pin)
+		return;
+	extiLines |= pin;
+	sensorEXTI |= 1 << index;
+
+	uint8_t pin_source = 31 - __CLZ(pin);
+	uint8_t port_source = ((uint32_t)sensorINTGPIO[index] - GPIOA_BASE) / (GPIOB_BASE - GPIOA_BASE);
+	GPIO_EXTILineConfig(port_source, pin_source);
+
+	EXTI_InitTypeDef exti_init;
+	exti_init.EXTI_Line = pin;
+	exti_init.EXTI_Mode = EXTI_Mode_Interrupt;
+	exti_init.EXTI_Trigger = EXTI_Trigger_Falling;
+	exti_init.EXTI_LineCmd = ENABLE;
+	EXTI_Init(&exti_init);
+
+	NVIC_InitTypeDef nvic_init;
+	if(pin_source <= 4)
+		nvic_init.NVIC_IRQChannel = EXTI0_IRQn + pin_source;
+	else if(pin_source <= 9)
+		nvic_init.NVIC_IRQChannel = EXTI9_5_IRQn;
+	else
+		nvic_init.NVIC_IRQChannel = EXTI15_10_IRQn;
+	nvic_init.NVIC_IRQChannelPreemptionPriority = HYPER_IRQ_PRIORITY_RANGE;
+	nvic_init.NVIC_IRQChannelSubPriority = 0;
+	nvic_init.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&nvic_init);
+}
+
+/**
+ * @brief This function handles the EXTI interrupts of the sensors, it flags the sensors that have a new sample
+ */
+static void VL6180X_EXTI_Handler(void) {
+	uint32_t entry = HYPER_Trace_Enter();
+	uint32_t pending = EXTI->PR & extiLines;
+	EXTI->PR = pending;
+
+	for(uint8_t i = 0; i < VL6180X_SENSORS; i++) {
+		if((sensorEXTI & (1 << i)) && (pending & sensorINTPin[i]))
+			sampleNotified[i] = true;
+	}
+	HYPER_Trace_Exit(TRACE_RANGE, entry);
+}
+
+/**
+ * @brief This function handles the EXTI0_IRQ
+ */
+void EXTI0_IRQHandler(void) {
+	VL6180X_EXTI_Handler();
+}
+
+/**
+ * @brief This function handles the EXTI1_IRQ
+ */
+void EXTI1_IRQHandler(void) {
+	VL6180X_EXTI_Handler();
+}
+
+/**
+ * @brief This function handles the EXTI4_IRQ
+ */
+void EXTI4_IRQHandler(void) {
+	VL6180X_EXTI_Handler();
+}
+
+/**
+ * @brief This function handles the EXTI9_5_IRQ
+ */
+void EXTI9_5_IRQHandler(void) {
+	VL6180X_EXTI_Handler();
+}
+
+/**
+ * @brief This function handles the EXTI15_10_IRQ
+ */
+void EXTI15_10_IRQHandler(void) {
+	VL6180X_EXTI_Handler();
+}
+
 #endif
@@ -8,16 +8,52 @@
 #ifndef SHARED_DRIVERS_VL6180X_H_
 #define SHARED_DRIVERS_VL6180X_H_
 
+#include <stdint.h>
 #include <stdbool.h>
+#include "hyper_can_frames.h"
 
 #define VL6180X_ID1		(0x1 << 1)	/**< The ID of the 1st sensor (also its I2C address) */
 #define VL6180X_ID2		(0x2 << 1)	/**< The ID of the 2nd sensor (also its I2C address) */
 #define VL6180X_ID3		(0x3 << 1)	/**< The ID of the 3rd sensor (also its I2C address) */
 #define VL6180X_ID4		(0x4 << 1)	/**< The ID of the 4th sensor (also its I2C address) */
 
+/**
+ * @brief This enum represents the ranging modes
+ */
+typedef enum {
+	VL6180X_MODE_CONTINUOUS = 0,	/**< All the sensors range every 10ms (a longer measurement in 10ms steps), their measurement windows staggered (the default, ~100 samples/s per sensor) */
+	VL6180X_MODE_ROUNDROBIN,		/**< The sensors take single-shot measurements one after another (no cross-talk) */
+	VL6180X_MODES					/**< The amount of the ranging modes */
+} VL6180X_Mode_t;
+
+/**
+ * @brief Structure type that holds a ranging configuration
+ */
+typedef struct {
+	VL6180X_Mode_t mode;		/**< The ranging mode */
+	uint8_t convergence;		/**< The maximum convergence time (in ms) */
+	uint8_t averaging;			/**< The readout averaging sample period (READOUT__AVERAGING_SAMPLE_PERIOD) */
+} VL6180X_Ranging_t;
+
+/**
+ * @brief Structure type that holds the sample fetch statistics of a sensor
+ */
+typedef struct {
+	uint32_t samples;		/**< The amount of the fetched samples */
+	uint32_t transfers;		/**< The amount of the I2C transactions of the fetches (including the polls without a sample) */
+	uint16_t rate;			/**< The samples per second, measured over the latest second */
+} VL6180X_Stats_t;
+
 void VL6180X_Init(void);
-void VL6180X_InitSensor(uint8_t sensor_id);
-bool VL6180X_IsSampleReady(uint8_t sensor_id);
-uint8_t VL6180X_GetRange(uint8_t sensor_id);
+bool VL6180X_InitTick(void);
+bool VL6180X_ReadRange(uint8_t sensor_id, uint8_t *range);
+bool VL6180X_IsFailed(uint8_t sensor_id);
+bool VL6180X_GetStats(uint8_t sensor_id, VL6180X_Stats_t *stats);
+void VL6180X_Tick(void);
+bool VL6180X_SetRanging(VL6180X_Mode_t mode, uint8_t convergence_ms, uint8_t averaging);
+void VL6180X_GetRanging(VL6180X_Ranging_t *ranging);
+uint32_t VL6180X_GetInitTime(void);
+uint16_t VL6180X_GetInitMismatches(void);
+void VL6180X_SendDiag(DiagType_t diag_type, uint8_t diag_arg);
 
 #endif /* SHARED_DRIVERS_VL6180X_H_ */
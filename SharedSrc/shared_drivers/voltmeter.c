@@ -30,14 +30,31 @@ void Voltmeter_Init(void) {
 
 /**
  * @brief This function performs a single conversion of the ADC channel connected to 12V rail voltage divider
- * @return Voltage reading in 0..255 range (eg. 89 = 8.9V)
+ * @return Raw ADC reading
  */
-uint8_t Voltmeter_Read(void) {
+static uint16_t Voltmeter_ReadADC(void) {
 	ADC_RegularChannelConfig(ADC1, UNIT_12VRAIL_ADC_CH, 1, ADC_SampleTime_55Cycles5);
 	ADC_SoftwareStartConvCmd(ADC1, ENABLE);
 	while(ADC_GetFlagStatus(ADC1, ADC_FLAG_EOC) != SET);
-	uint16_t adc_result = ADC_GetConversionValue(ADC1);
+	return ADC_GetConversionValue(ADC1);
+}
+
+/**
+ * @brief This function reads the 12V rail voltage
+ * @return Voltage reading in 0..255 range (eg. 89 = 8.9V)
+ */
+uint8_t Voltmeter_Read(void) {
+	uint16_t adc_result = Voltmeter_ReadADC();
 	return adc_result * 33 * (R1+R2) / R2 / 4095;
 }
 
+/**
+ * @brief This function reads the 12V rail voltage with full resolution
+ * @return Voltage reading in mV (eg. 12034 = 12.034V)
+ */
+uint16_t Voltmeter_ReadMillivolts(void) {
+	uint16_t adc_result = Voltmeter_ReadADC();
+	return (uint32_t)adc_result * 3300 / 4095 * (R1+R2) / R2;
+}
+
 #endif
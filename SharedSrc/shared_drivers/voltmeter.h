@@ -10,5 +10,6 @@
 
 void Voltmeter_Init(void);
 uint8_t Voltmeter_Read(void);
+uint16_t Voltmeter_ReadMillivolts(void);
 
 #endif /* SHARED_DRIVERS_VOLTMETER_H_ */
@@ -29,6 +29,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f1xx_it.h"
+#include "hyper_trace.h"
 
 /** @addtogroup IO_Toggle
   * @{
@@ -140,7 +141,11 @@ void PendSV_Handler(void)
   */
 void SysTick_Handler(void)
 {
+	uint32_t entry = HYPER_Trace_Enter();
+	// SysTick counts the core clock cycles down from the reload
+	HYPER_Trace_Latency(TRACE_SYSTICK, SysTick->LOAD - SysTick->VAL);
 	HYPER_Tick();
+	HYPER_Trace_Exit(TRACE_SYSTICK, entry);
 }
 
 /******************************************************************************/
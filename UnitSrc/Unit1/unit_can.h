@@ -2,68 +2,93 @@
  * @file Unit1/unit_can.h
  * @author Łukasz Kilaszewski (luktor99)
  * @date 5-July-2017
- * @brief This file contains implementation of functions that update the unit's CAN output buffer.
+ * @brief This file contains implementation of functions that update the unit's CAN data record and pack it into the data frame.
  */
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateVL6180X_1(unit_DataBuffer_t *buffer, void *value) {
-	buffer->vl6180xDistance1 = *(uint8_t *)value;
+void updateVL6180X_1(unit_Record_t *record, void *value) {
+	record->vl6180xDistance1 = *(uint8_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateVL6180X_2(unit_DataBuffer_t *buffer, void *value) {
-	buffer->vl6180xDistance2 = *(uint8_t *)value;
+void updateVL6180X_2(unit_Record_t *record, void *value) {
+	record->vl6180xDistance2 = *(uint8_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateVL6180X_3(unit_DataBuffer_t *buffer, void *value) {
-	buffer->vl6180xDistance3 = *(uint8_t *)value;
+void updateVL6180X_3(unit_Record_t *record, void *value) {
+	record->vl6180xDistance3 = *(uint8_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateVL6180X_4(unit_DataBuffer_t *buffer, void *value) {
-	buffer->vl6180xDistance4 = *(uint8_t *)value;
+void updateVL6180X_4(unit_Record_t *record, void *value) {
+	record->vl6180xDistance4 = *(uint8_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updatePitot(unit_DataBuffer_t *buffer, void *value) {
-	buffer->pitotPressure = *(uint16_t *)value;
+void updatePitot(unit_Record_t *record, void *value) {
+	record->pitotPressure = *(int16_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateLM35(unit_DataBuffer_t *buffer, void *value) {
-	buffer->lm35Temperature = *(uint8_t *)value;
+void updateAirspeed(unit_Record_t *record, void *value) {
+	record->airspeed = *(uint16_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateTMP102(unit_DataBuffer_t *buffer, void *value) {
-	buffer->tmp102Tmperature = *(uint8_t *)value;
+void updateLM35(unit_Record_t *record, void *value) {
+	record->lm35Temperature = *(uint16_t *)value;
+}
+
+/**
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
+ * @param value Pointer to the new data
+ */
+void updateTMP102(unit_Record_t *record, void *value) {
+	record->tmp102Temperature = *(int16_t *)value;
+}
+
+/**
+ * @brief This function packs the data record into the (single frame) data buffer
+ * @param record Pointer to the data record structure
+ * @param buffer Pointer to the CAN buffer structure
+ */
+void UNIT_CAN_Pack(const unit_Record_t *record, unit_DataBuffer_t *buffer) {
+	buffer->vl6180xDistance1 = record->vl6180xDistance1;
+	buffer->vl6180xDistance2 = record->vl6180xDistance2;
+	buffer->vl6180xDistance3 = record->vl6180xDistance3;
+	buffer->vl6180xDistance4 = record->vl6180xDistance4;
+	buffer->pitotPressure = record->pitotPressure;
+	// °C, rounded down for LM35 and to the nearest degree for TMP-102
+	buffer->lm35Temperature = (record->lm35Temperature / 10 > 255) ? 255 : record->lm35Temperature / 10;
+	buffer->tmp102Tmperature = (uint8_t)((record->tmp102Temperature + 8) >> 4);
 }
@@ -1,5 +1,5 @@
 /**
- * @file tmp102.c
+ * @file D6F_PH5050AD3.c
  * @author Wojciech Bytof
  * @date 18-July-2017
  * @brief This file contains the implementation of D6F_PH5050AD3 sensor
@@ -8,205 +8,278 @@
  
 #include "stm32f10x.h"
 #include "D6F_PH5050AD3.h"
+#include "hyper_i2c.h"
+#include "hyper_utils.h"
 
-#define AVG_LENGTH		20		/**< Length of the moving average filter */
-#define VALUE_SCALE		650		/**< The scaling factor */
+#define AVG_LENGTH		20		/**< Length of the moving average filter (samples) */
 
-static uint16_t avg[AVG_LENGTH] = {0};
-static uint8_t avg_i = 0;
+#define D6F_PH5050AD3_ADDR (0x6C << 1) /**< D6F_PH5050AD3's I2C address */
+
+#define CONVERSION_TIME	33000	/**< The time the sensor needs to complete a measurement after it was started (in us) */
+#define RATE_WINDOW		1000	/**< The window of the sample rate measurement (in ms) */
 
-#define D6F_PH5050AD3_ADDR (0x6C << 1) /**< tmp102's I2C address */
+#define PRESSURE_ZERO		1024	/**< The raw value of the lowest pressure */
+#define PRESSURE_MIN		-5000	/**< The lowest pressure (in 0.1Pa) */
+#define COUNTS_PER_PASCAL	60		/**< The raw value change of 1Pa */
 
 /**
- * @brief Initialization of peripherals
+ * @brief This enum represents the steps of the acquisition state machine
  */
-void D6F_PH5050AD3_Init(void) 
-{
-	// RCC setup
-	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOB, ENABLE);
-	RCC_APB1PeriphClockCmd(RCC_APB1Periph_I2C1, ENABLE);
-
-	// I2C1 SCL(PB6), SDA(PB7) pins setup
-	GPIO_InitTypeDef gpio_init;
-	gpio_init.GPIO_Mode = GPIO_Mode_AF_OD;
-	gpio_init.GPIO_Pin = GPIO_Pin_6 | GPIO_Pin_7;
-	gpio_init.GPIO_Speed = GPIO_Speed_10MHz;
-	GPIO_Init(GPIOB, &gpio_init);
-
-	// I2C1 setup
-	I2C_DeInit(I2C1);
-	I2C_InitTypeDef I2C_InitStruct;
-	I2C_InitStruct.I2C_Mode = I2C_Mode_I2C;
-	I2C_InitStruct.I2C_ClockSpeed = 400000;
-	I2C_InitStruct.I2C_DutyCycle = I2C_DutyCycle_2;
-	I2C_InitStruct.I2C_Ack = I2C_Ack_Enable;
-	I2C_InitStruct.I2C_AcknowledgedAddress = I2C_AcknowledgedAddress_7bit;
-	I2C_Init(I2C1, &I2C_InitStruct);
-
-	// Enable I2C1
-	I2C_Cmd(I2C1, ENABLE);
-
-	// Wait for I2C1 to become ready
-	while(I2C_GetFlagStatus(I2C1, I2C_FLAG_BUSY));
-}
+typedef enum {
+	D6F_STATE_START = 0,	/**< A measurement has to be started */
+	D6F_STATE_CONVERT,		/**< The measurement was started, waiting for its completion */
+	D6F_STATE_READ			/**< The result is being read */
+} D6F_PH5050AD3_State_t;
 
 /**
- * @brief The device must be unlocked then write 0x00 to the EEPROM Control Register(0xB) to load NVM trim values, but keep the MCU in non-reset state.
+ * @brief The step of the acquisition state machine
  */
-void D6F_PH5050AD3_Init_Message(void)
-{
-	// Make sure the bus is ready
-	while(I2C_GetFlagStatus(I2C1, I2C_FLAG_BUSY));
-
-	// Generate START condition
-	I2C_GenerateSTART(I2C1, ENABLE);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_MODE_SELECT));
-
-	// Send D6F_PH5050AD3's I2C address
-	I2C_Send7bitAddress(I2C1, (D6F_PH5050AD3_ADDR), I2C_Direction_Transmitter);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED));
-
-	//EEPROM Control Register(0xB)
-	I2C_SendData(I2C1, 0x0B);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
-
-	//value send to Control Register
-	I2C_SendData(I2C1, 0x00);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
-
-	// Generate STOP condition
-	I2C_GenerateSTOP(I2C1, ENABLE);
-  }
+static D6F_PH5050AD3_State_t acqState = D6F_STATE_START;
 
 /**
-* @brief Function that starts another read-out
-*/
-void D6F_PH5050AD3_StartAnotherRead(void)
-{
-	// Make sure the bus is ready
-	while(I2C_GetFlagStatus(I2C1, I2C_FLAG_BUSY));
-
-	// Generate START condition
-	I2C_GenerateSTART(I2C1, ENABLE);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_MODE_SELECT));
-
-	// Send D6F_PH5050AD3's I2C address
-	I2C_Send7bitAddress(I2C1, (D6F_PH5050AD3_ADDR), I2C_Direction_Transmitter);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED));
-
-	// Access Address 1
- 	I2C_SendData(I2C1, 0x00);
- 	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
+ * @brief The time the latest measurement was started at (in cycles), set when the start transfer completes
+ */
+static volatile uint32_t acqStart = 0;
 
-	//MSB of Sensor Control Register
- 	I2C_SendData(I2C1, 0xD0);
- 	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
+/**
+ * @brief The samples of the moving average filter (raw values)
+ */
+static uint16_t avg[AVG_LENGTH] = {0};
 
-	//LSB of Sensor Control Register
- 	I2C_SendData(I2C1, 0x40);
- 	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
+/**
+ * @brief The index of the oldest sample in avg[]
+ */
+static uint8_t avg_i = 0;
 
-	//Serial Ctrl (16-bit adress, write, new request, 1 byte data transfer)
- 	I2C_SendData(I2C1, 0x18);
- 	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
+/**
+ * @brief The amount of samples in avg[] (less than AVG_LENGTH only until the filter fills up)
+ */
+static uint8_t avg_count = 0;
 
-	//Data to write to Sensor Control Register
- 	I2C_SendData(I2C1, 0x06);
- 	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
+/**
+ * @brief The running sum of the samples in avg[]
+ */
+static uint32_t avg_sum = 0;
 
- 	// Generate STOP condition
-	I2C_GenerateSTOP(I2C1, ENABLE);
-   }
+/**
+ * @brief Set when a new sample was filtered, cleared by D6F_PH5050AD3_ReadPress()
+ */
+static bool newSample = false;
 
 /**
- * @brief Function performs a single read-out of pressure
- * @return bare data without processing
+ * @brief The local time the newest sample's measurement completed at (in us)
  */
-uint16_t D6F_PH5050AD3_ReadPress(void)
-{
-	uint16_t data = 0x0000;
-	// Make sure the bus is ready
-	while(I2C_GetFlagStatus(I2C1, I2C_FLAG_BUSY));
+static uint32_t sampleTime = 0;
 
-	// Generate START condition
-	I2C_GenerateSTART(I2C1, ENABLE);
-	while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_MODE_SELECT));
+/**
+ * @brief The acquisition statistics
+ */
+static D6F_PH5050AD3_Stats_t acqStats = {0};
 
-	// Send D6F_PH5050AD3's I2C address
-	I2C_Send7bitAddress(I2C1, (D6F_PH5050AD3_ADDR), I2C_Direction_Transmitter);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED));
+/**
+ * @brief The time the sample rate window started at
+ */
+static uint32_t rateTimestamp = 0;
 
-	// Access Address 1
-	I2C_SendData(I2C1, 0x00);
-    while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
+/**
+ * @brief The amount of samples at the start of the rate window
+ */
+static uint32_t rateSamples = 0;
 
-	//MSB of Compensated Flow rate Register
-	I2C_SendData(I2C1, 0xD0);
-    while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
+/**
+ * @brief Access Address 1, Compensated Flow rate Register (0xD051), Serial Ctrl (2 byte read)
+ */
+static const uint8_t readRequest[4] = {0x00, 0xD0, 0x51, 0x2C};
 
-	//LSB of Compensated Flow rate Register
-	I2C_SendData(I2C1, 0x51);
-    while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
+/**
+ * @brief Read Buffer 0
+ */
+static const uint8_t readBuffer = 0x07;
 
-	//2byte read
-	I2C_SendData(I2C1, 0x2C);
-    while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
+/**
+ * @brief Access Address 1, Sensor Control Register (0xD040), Serial Ctrl (16-bit adress, write, new request, 1 byte data transfer), start the measurement
+ */
+static const uint8_t startRequest[5] = {0x00, 0xD0, 0x40, 0x18, 0x06};
 
-	// Generate STOP condition
-	I2C_GenerateSTOP(I2C1, ENABLE);
+/**
+ * @brief The data of the background read
+ */
+static uint8_t readData[2];
 
+/**
+ * @brief The transfer that requests the read of the pressure
+ */
+static HYPER_I2C_Transfer_t requestTransfer = {
+	.bus = I2C_BUS1,
+	.address = D6F_PH5050AD3_ADDR,
+	.txData = readRequest,
+	.txLength = sizeof(readRequest)
+};
 
-	// Generate START condition
-	I2C_GenerateSTART(I2C1, ENABLE);
-	while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_MODE_SELECT));
+/**
+ * @brief The transfer that reads the pressure
+ */
+static HYPER_I2C_Transfer_t readTransfer = {
+	.bus = I2C_BUS1,
+	.address = D6F_PH5050AD3_ADDR,
+	.txData = &readBuffer,
+	.txLength = 1,
+	.rxData = readData,
+	.rxLength = 2
+};
 
-	// Send D6F_PH5050AD3's I2C address
-	I2C_Send7bitAddress(I2C1, (D6F_PH5050AD3_ADDR), I2C_Direction_Transmitter);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED));
+static void D6F_PH5050AD3_Started(HYPER_I2C_Transfer_t *transfer);
 
-	//Read Buffer 0
-	I2C_SendData(I2C1, 0x07);
-    while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
+/**
+ * @brief The transfer that starts the next measurement
+ */
+static HYPER_I2C_Transfer_t startTransfer = {
+	.bus = I2C_BUS1,
+	.address = D6F_PH5050AD3_ADDR,
+	.txData = startRequest,
+	.txLength = sizeof(startRequest),
+	.callback = D6F_PH5050AD3_Started
+};
 
-	// Generate START condition
-	I2C_GenerateSTART(I2C1, ENABLE);
-	while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_MODE_SELECT));
+/**
+ * @brief Initialization of peripherals
+ */
+void D6F_PH5050AD3_Init(void) 
+{
+	// Fast mode device, shares I2C1 with tmp102
+	HYPER_I2C_AddDevice(I2C_BUS1, D6F_PH5050AD3_ADDR, 400000);
 
-	// Send D6F_PH5050AD3's I2C address
-	I2C_Send7bitAddress(I2C1, (D6F_PH5050AD3_ADDR), I2C_Direction_Receiver);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_RECEIVER_MODE_SELECTED));
+	acqState = D6F_STATE_START;
+	rateTimestamp = HYPER_Delay_GetTime();
+}
 
-	I2C_AcknowledgeConfig(I2C1, ENABLE);
+/**
+ * @brief The device must be unlocked then write 0x00 to the EEPROM Control Register(0xB) to load NVM trim values, but keep the MCU in non-reset state.
+ */
+void D6F_PH5050AD3_Init_Message(void)
+{
+	// EEPROM Control Register(0xB), value send to Control Register
+	static const uint8_t message[2] = {0x0B, 0x00};
+
+	HYPER_I2C_Transfer_t transfer = {0};
+	transfer.bus = I2C_BUS1;
+	transfer.address = D6F_PH5050AD3_ADDR;
+	transfer.txData = message;
+	transfer.txLength = sizeof(message);
+	HYPER_I2C_Run(&transfer);
+}
 
-	// Receive the data byte 1 (MSB)
-	while(!I2C_CheckEvent(I2C1,I2C_EVENT_MASTER_BYTE_RECEIVED));
-	data = I2C_ReceiveData(I2C1) << 8;
+/**
+ * @brief Function timestamps the start of a measurement (run from the I2C interrupt), the conversion time is counted from here
+ * @param transfer The completed start transfer
+ */
+static void D6F_PH5050AD3_Started(HYPER_I2C_Transfer_t *transfer)
+{
+	(void)transfer;
+	acqStart = HYPER_Cycles_Get();
+}
 
-	I2C_AcknowledgeConfig(I2C1, DISABLE);
+/**
+ * @brief Function adds a sample to the moving average filter, the oldest one is subtracted from the running sum
+ * @param sample The raw value
+ */
+static void D6F_PH5050AD3_Filter(uint16_t sample)
+{
+	if(avg_count < AVG_LENGTH)
+		avg_count++;
+	else
+		avg_sum -= avg[avg_i];
 
-	// Receive the data byte 2 (LSB)
-	while(!I2C_CheckEvent(I2C1,I2C_EVENT_MASTER_BYTE_RECEIVED));
-	data |= I2C_ReceiveData(I2C1);
+	avg[avg_i] = sample;
+	avg_sum += sample;
+	avg_i = (avg_i + 1) % AVG_LENGTH;
+}
 
-	// Generate STOP condition
-	I2C_GenerateSTOP(I2C1, ENABLE);
+/**
+ * @brief Function advances the acquisition: starts a measurement, waits for its completion without blocking, reads the result
+ * and starts the next one right away. It should be run in the main loop (as a background task).
+ */
+void D6F_PH5050AD3_Tick(void)
+{
+	switch(acqState) {
+	case D6F_STATE_START:
+		if(HYPER_I2C_Submit(&startTransfer))
+			acqState = D6F_STATE_CONVERT;
+		break;
+
+	case D6F_STATE_CONVERT:
+		if(startTransfer.status == I2C_STATUS_PENDING)
+			break;
+		if(startTransfer.status != I2C_STATUS_DONE) {
+			acqState = D6F_STATE_START;
+			break;
+		}
+		if(!HYPER_Cycles_Check(acqStart, HYPER_Cycles_FromMicros(CONVERSION_TIME)))
+			break;
+
+		// The transfers run in the order they were queued
+		HYPER_I2C_Submit(&requestTransfer);
+		HYPER_I2C_Submit(&readTransfer);
+		acqState = D6F_STATE_READ;
+		break;
+
+	case D6F_STATE_READ:
+		if(requestTransfer.status == I2C_STATUS_PENDING || readTransfer.status == I2C_STATUS_PENDING)
+			break;
+		if(requestTransfer.status == I2C_STATUS_DONE && readTransfer.status == I2C_STATUS_DONE) {
+			D6F_PH5050AD3_Filter((readData[0] << 8) | readData[1]);
+			sampleTime = startTransfer.time + CONVERSION_TIME;
+			acqStats.samples++;
+			newSample = true;
+		}
+		acqState = D6F_STATE_START;
+		break;
+	}
 
-	avg[avg_i] = data;
-	avg_i = (avg_i + 1) % AVG_LENGTH;
-	uint32_t sum = 0;
-	for(uint8_t i = 0; i < AVG_LENGTH; i++) {
-		sum += avg[i];
+	// Measure the sample rate
+	if(HYPER_Delay_Check(rateTimestamp, RATE_WINDOW)) {
+		rateTimestamp = HYPER_Delay_GetTime();
+		uint32_t rate = acqStats.samples - rateSamples;
+		acqStats.rate = rate > 0xFFFF ? 0xFFFF : rate;
+		rateSamples = acqStats.samples;
 	}
+}
 
-	return sum*VALUE_SCALE/AVG_LENGTH;
+/**
+ * @brief Function returns the filtered pressure if a new sample was acquired since its previous call
+ * @param press Pointer to the output value, the moving average of the pressure in 0.1Pa (-5000..5000)
+ * @param time Pointer to the output value, the local time the newest sample's measurement completed at (in us)
+ * @return true if a new value was returned, false otherwise (no new sample yet)
+ */
+bool D6F_PH5050AD3_ReadPress(int16_t *press, uint32_t *time)
+{
+	if(!newSample)
+		return false;
+	newSample = false;
+	*time = sampleTime;
+
+	// Pa = (raw - 1024) / 60 - 500, averaged and rounded to the nearest 0.1Pa
+	int32_t counts = (int32_t)avg_sum - PRESSURE_ZERO * avg_count;
+	int32_t scale = COUNTS_PER_PASCAL * avg_count;
+	int32_t tenths = counts >= 0 ? (counts * 10 + scale / 2) / scale : (counts * 10 - scale / 2) / scale;
+	*press = tenths + PRESSURE_MIN;
+	return true;
+}
+
+/**
+ * @brief Function checks if the sensor stopped responding (HYPER_I2C_FAIL_THRESHOLD consecutive failed transfers)
+ * @return true if the sensor's readings should be treated as invalid, false otherwise
+ */
+bool D6F_PH5050AD3_IsFailed(void)
+{
+	return HYPER_I2C_IsFailed(I2C_BUS1, D6F_PH5050AD3_ADDR);
 }
 
 /**
- * @brief Function performs conversion pressure to Pascals
- * @return pressure in Pascals
+ * @brief Function copies the acquisition statistics
+ * @param stats Pointer to the output structure
  */
-float D6F_PH5050AD3_Conv_to_Pascal(uint16_t data)
+void D6F_PH5050AD3_GetStats(D6F_PH5050AD3_Stats_t *stats)
 {
-	float pressure_Pascal = (((((float)data) - 1024)/60)-500);
-	return pressure_Pascal;
+	*stats = acqStats;
 }
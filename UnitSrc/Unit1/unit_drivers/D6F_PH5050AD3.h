@@ -1,17 +1,29 @@
 /**
- * @file tmp102.h
+ * @file D6F_PH5050AD3.h
  * @author Wojciech Bytof
  * @date 13-July-2017
- * @brief This file contains the headers of tmp102 driver
+ * @brief This file contains the headers of D6F_PH5050AD3 driver
  */
 
 #ifndef UNIT_DRIVERS_D6F_PH5050AD3_H_
 #define UNIT_DRIVERS_D6F_PH5050AD3_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Structure type that holds the acquisition statistics
+ */
+typedef struct {
+	uint32_t samples;		/**< The amount of acquired samples */
+	uint16_t rate;			/**< The amount of samples acquired during the last second */
+} D6F_PH5050AD3_Stats_t;
+
 void D6F_PH5050AD3_Init(void);
 void D6F_PH5050AD3_Init_Message(void);
-void D6F_PH5050AD3_StartAnotherRead(void);
-uint16_t D6F_PH5050AD3_ReadPress();
-float D6F_PH5050AD3_Conv_to_Pascal(uint16_t data);
+void D6F_PH5050AD3_Tick(void);
+bool D6F_PH5050AD3_ReadPress(int16_t *press, uint32_t *time);
+bool D6F_PH5050AD3_IsFailed(void);
+void D6F_PH5050AD3_GetStats(D6F_PH5050AD3_Stats_t *stats);
 
 #endif /* UNIT_DRIVERS_D6F_PH5050AD3_H_ */
@@ -8,40 +8,39 @@
  
 #include "stm32f10x.h"
 #include "tmp102.h"
+#include "hyper_i2c.h"
 
 #define tmp102_ADDR (0x48 << 1) /**< tmp102's I2C address */
 
 /**
- * @brief Initialization of peripherals
+ * @brief The temperature register's address, the written part of the background read
  */
-void tmp102_Init(void) 
-{
-	// RCC setup
-	RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOB, ENABLE);
-	RCC_APB1PeriphClockCmd(RCC_APB1Periph_I2C1, ENABLE);
+static const uint8_t readReg = 0x00;
 
-	// I2C1 SCL(PB6), SDA(PB7) pins setup
-	GPIO_InitTypeDef gpio_init;
-	gpio_init.GPIO_Mode = GPIO_Mode_AF_OD;
-	gpio_init.GPIO_Pin = GPIO_Pin_6 | GPIO_Pin_7;
-	gpio_init.GPIO_Speed = GPIO_Speed_10MHz;
-	GPIO_Init(GPIOB, &gpio_init);
-
-	// I2C1 setup
-	I2C_DeInit(I2C1);
-	I2C_InitTypeDef I2C_InitStruct;
-	I2C_InitStruct.I2C_Mode = I2C_Mode_I2C;
-	I2C_InitStruct.I2C_ClockSpeed = 400000;
-	I2C_InitStruct.I2C_DutyCycle = I2C_DutyCycle_2;
-	I2C_InitStruct.I2C_Ack = I2C_Ack_Enable;
-	I2C_InitStruct.I2C_AcknowledgedAddress = I2C_AcknowledgedAddress_7bit;
-	I2C_Init(I2C1, &I2C_InitStruct);
+/**
+ * @brief The data of the background read
+ */
+static uint8_t readData[2];
 
-	// Enable I2C1
-	I2C_Cmd(I2C1, ENABLE);
+/**
+ * @brief The transfer of the background read
+ */
+static HYPER_I2C_Transfer_t readTransfer = {
+	.bus = I2C_BUS1,
+	.address = tmp102_ADDR,
+	.txData = &readReg,
+	.txLength = 1,
+	.rxData = readData,
+	.rxLength = 2
+};
 
-	// Wait for I2C1 to become ready
-	while(I2C_GetFlagStatus(I2C1, I2C_FLAG_BUSY));
+/**
+ * @brief Initialization of peripherals
+ */
+void tmp102_Init(void) 
+{
+	// tmp102 supports the fast mode (400kHz)
+	HYPER_I2C_AddDevice(I2C_BUS1, tmp102_ADDR, 400000);
 }
 
 /**
@@ -49,97 +48,45 @@ void tmp102_Init(void)
  */
 void tmp102_Config(void)
 {
-	// Make sure the bus is ready
-	while(I2C_GetFlagStatus(I2C1, I2C_FLAG_BUSY));
-
-	// Generate START condition
-	I2C_GenerateSTART(I2C1, ENABLE);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_MODE_SELECT));
-
-	// Send tmp102's I2C address
-	I2C_Send7bitAddress(I2C1, (tmp102_ADDR), I2C_Direction_Transmitter);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED));
-
-	// Enter Configuration Register(0b00000001)
-	I2C_SendData(I2C1, 0x01);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
-
-	// Send MSB of Configuration Register (0b01100000)
-	I2C_SendData(I2C1, 0x60);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
-
-	// Send LSB of Configuration Register (0b11100000)
-	I2C_SendData(I2C1, 0xE0);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
-
-	// Generate STOP condition
-	I2C_GenerateSTOP(I2C1, ENABLE);
-  }
+	// Configuration Register(0b00000001), MSB (0b01100000), LSB (0b11100000)
+	static const uint8_t config[3] = {0x01, 0x60, 0xE0};
+
+	HYPER_I2C_Transfer_t transfer = {0};
+	transfer.bus = I2C_BUS1;
+	transfer.address = tmp102_ADDR;
+	transfer.txData = config;
+	transfer.txLength = sizeof(config);
+	HYPER_I2C_Run(&transfer);
+}
 
 /**
- * @brief This function reads a single 12-bit value from the device's register
- * @return Temperature in Celsius
+ * @brief This function reads a single 12-bit value from the device's register, without waiting for the bus.
+ * It returns the result of the read started by its previous call, then starts the next read.
+ * @param temp Pointer to the output value, temperature expressed in 0.0625°C (eg. 400 = 25°C)
+ * @param time Pointer to the output value, the local time the value was read at (in us)
+ * @return true if a new value was returned, false otherwise (the first call, a failed or unfinished read)
  */
-uint8_t tmp102_ReadTemp()
+bool tmp102_ReadTemp16(int16_t *temp, uint32_t *time)
 {
-	//local variables
-	uint8_t temp8bit = 0x00;
-	uint16_t data = 0x0000;
-	float subRemainder = 0;
-	float tempCelsius;
-
-	// Make sure the bus is ready
-	while(I2C_GetFlagStatus(I2C1, I2C_FLAG_BUSY));
-
-	// Generate START condition
-	I2C_GenerateSTART(I2C1, ENABLE);
-	while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_MODE_SELECT));
-
-	// Send tmp102's I2C address
-	I2C_Send7bitAddress(I2C1, (tmp102_ADDR), I2C_Direction_Transmitter);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED));
-
-	// Enter Temperature Register(0b00000000)
-	I2C_SendData(I2C1, 0x00);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_BYTE_TRANSMITTED));
-
-	// Generate STOP condition
-	I2C_GenerateSTOP(I2C1, ENABLE);
-
-
-	// Generate START condition
-	I2C_GenerateSTART(I2C1, ENABLE);
-	while(!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_MODE_SELECT));
-
-	// Send tmp102's I2C address
-	I2C_Send7bitAddress(I2C1, (tmp102_ADDR), I2C_Direction_Receiver);
-	while (!I2C_CheckEvent(I2C1, I2C_EVENT_MASTER_RECEIVER_MODE_SELECTED));
-
-	// Receive the data byte 1 (MSB)
-	while(!I2C_CheckEvent(I2C1,I2C_EVENT_MASTER_BYTE_RECEIVED));
-	data = I2C_ReceiveData(I2C1) << 4;
-
-	// Receive the data byte 2 (LSB)
-	while(!I2C_CheckEvent(I2C1,I2C_EVENT_MASTER_BYTE_RECEIVED));
-	data |= I2C_ReceiveData(I2C1) >> 4;
-
-	// Generate STOP condition
-	I2C_GenerateSTOP(I2C1, ENABLE);
-
-	tempCelsius = data *0.0625;
-	subRemainder = tempCelsius - (int)tempCelsius;
-
-	if(subRemainder >= 0.5)
-	{
-		temp8bit = ((int)tempCelsius + 1);
-		return temp8bit;
-	}
-	else
-	{
-		temp8bit = (int)tempCelsius;
-		return temp8bit;
+	if(readTransfer.status == I2C_STATUS_PENDING)
+		return false;
+
+	bool done = (readTransfer.status == I2C_STATUS_DONE);
+	if(done) {
+		// The 12-bit two's complement value is left aligned (MSB first)
+		*temp = (int16_t)((readData[0] << 8) | readData[1]) >> 4;
+		*time = readTransfer.time;
 	}
 
+	HYPER_I2C_Submit(&readTransfer);
+	return done;
 }
 
-   
+/**
+ * @brief This function checks if the sensor stopped responding (HYPER_I2C_FAIL_THRESHOLD consecutive failed transfers)
+ * @return true if the sensor's readings should be treated as invalid, false otherwise
+ */
+bool tmp102_IsFailed(void)
+{
+	return HYPER_I2C_IsFailed(I2C_BUS1, tmp102_ADDR);
+}
@@ -8,8 +8,12 @@
 #ifndef UNIT_DRIVERS_TMP102_H_
 #define UNIT_DRIVERS_TMP102_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+
 void tmp102_Init(void);
 void tmp102_Config(void);
-uint8_t tmp102_ReadTemp();
+bool tmp102_ReadTemp16(int16_t *temp, uint32_t *time);
+bool tmp102_IsFailed(void);
 
 #endif /* UNIT_DRIVERS_TMP102_H_ */
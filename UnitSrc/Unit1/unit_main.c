@@ -2,29 +2,64 @@
  * @file Unit1/unit_main.c
  * @author Ĺ�ukasz Kilaszewski (luktor99)
  * @date 4-July-2017
- * @brief This file contains implementation of the main functions (UNIT_Init() and UNIT_Loop()), which are specific to each of the units.
+ * @brief This file contains implementation of the unit's initialization (UNIT_Init()) and its scheduled tasks, which are specific to each of the units.
  */
 
 #include "unit.h"
 #include "hyper.h"
+#include "hyper_unit_defs.h"
+#include "hyper_settings.h"
 #include "unit_can.h"
 #include "shared_drivers/lm35.h"
 #include "shared_drivers/vl6180x.h"
 #include "unit_drivers/D6F_PH5050AD3.h"
 #include "unit_drivers/tmp102.h"
 
-#define Tube_pressure 1000; // Ustawiam wstępnie na 1kPa
+/**
+ * @brief The static pressure in the tube (in Pa), set through MSG_TUBEPRESSURE
+ */
+static uint32_t tubePressure = UNIT1_TUBE_PRESSURE;
 
-uint16_t sqrti( uint16_t v ) {
-    uint16_t r = 0;
-    uint16_t _r =0;
-        for(int i =15; i>0;i--){
-        _r = r+(1<<i);
-        if ( _r*_r <= v ) r=_r;
-        }
-    return r;
-}
+/**
+ * @brief The latest TMP102 reading, the air temperature of the airspeed computation (in 0.0625°C)
+ */
+static int16_t airTemperature = 0;
+
+/**
+ * @brief Set once airTemperature holds a valid reading, cleared when TMP102 stops responding
+ */
+static bool airTemperatureValid = false;
 
+static void UNIT_Task_Range1(void);
+static void UNIT_Task_Range2(void);
+static void UNIT_Task_Range3(void);
+static void UNIT_Task_Range4(void);
+static void UNIT_Task_LM35(void);
+static void UNIT_Task_TMP102(void);
+static void UNIT_Task_Pitot(void);
+
+/**
+ * @brief The unit's tasks. The Pitot sensor is sampled as fast as its conversions allow, VL6180X sensors signal their samples through interrupts, so they (and their ranging scheduler) are checked on every pass (the samples are fetched in the background).
+ */
+static const HYPER_Sched_Task_t unitTasks[] = {
+	// run					period	offset	priority	deadline
+	{D6F_PH5050AD3_Tick,	0,		0,		0,			0},
+	{UNIT_Task_Pitot,		0,		0,		0,			0},
+	{UNIT_Task_Range1,		0,		0,		1,			0},
+	{UNIT_Task_Range2,		0,		0,		1,			0},
+	{UNIT_Task_Range3,		0,		0,		1,			0},
+	{UNIT_Task_Range4,		0,		0,		1,			0},
+	{VL6180X_Tick,			0,		0,		1,			0},
+	{UNIT_Task_TMP102,		125,	7,		2,			0},
+	{UNIT_Task_LM35,		100,	13,		3,			0},
+};
+
+/**
+ * @brief The unit's initialization steps, completed in the background (@see hyper_boot.h)
+ */
+static const HYPER_Boot_Step_t unitBootSteps[] = {
+	VL6180X_InitTick,
+};
 
 /**
  * @brief This function performs initialization of the peripherals specific to the unit.
@@ -33,71 +68,193 @@ void UNIT_Init(void) {
 	LM35_Init();
 
 	VL6180X_Init();
-	VL6180X_InitSensor(VL6180X_ID1);
-	VL6180X_InitSensor(VL6180X_ID2);
-	VL6180X_InitSensor(VL6180X_ID3);
-	VL6180X_InitSensor(VL6180X_ID4);
 
 	tmp102_Init();
 	tmp102_Config();
+	D6F_PH5050AD3_Init();
 	D6F_PH5050AD3_Init_Message();
+
+	HYPER_Sched_Init(unitTasks, sizeof(unitTasks) / sizeof(unitTasks[0]));
+	HYPER_Boot_Init(unitBootSteps, sizeof(unitBootSteps) / sizeof(unitBootSteps[0]));
 }
 
 /**
- * @brief This function is run in an infinite loop. This is where outgoing data gets updated.
+ * @brief This function reads and updates a VL6180X sensor if there is a new sample available, invalidates it if the sensor stopped responding
+ * @param sensor_id The sensor ID
+ * @param update The record update function
+ * @param group The sensor's channel group
  */
-inline void UNIT_Loop(void) {
-	// Read and update VL6180X sensors if there are new samples available
-	if(VL6180X_IsSampleReady(VL6180X_ID1)) {
-		uint8_t range1 = VL6180X_GetRange(VL6180X_ID1);
-		HYPER_CAN_Update(updateVL6180X_1, &range1);
+static void UNIT_ReadRange(uint8_t sensor_id, void (*update)(unit_Record_t *, void *), uint8_t group) {
+	uint8_t range;
+	if(VL6180X_ReadRange(sensor_id, &range)) {
+		HYPER_CAN_Update(update, &range);
+		HYPER_CAN_Stamp(group);
 	}
-	if(VL6180X_IsSampleReady(VL6180X_ID2)) {
-		uint8_t range2 = VL6180X_GetRange(VL6180X_ID2);
-		HYPER_CAN_Update(updateVL6180X_2, &range2);
-	}
-	if(VL6180X_IsSampleReady(VL6180X_ID3)) {
-		uint8_t range3 = VL6180X_GetRange(VL6180X_ID3);
-		HYPER_CAN_Update(updateVL6180X_3, &range3);
-	}
-	if(VL6180X_IsSampleReady(VL6180X_ID4)) {
-		uint8_t range4 = VL6180X_GetRange(VL6180X_ID4);
-		HYPER_CAN_Update(updateVL6180X_4, &range4);
+	else if(VL6180X_IsFailed(sensor_id)) {
+		HYPER_CAN_Invalidate(group);
 	}
+}
 
-	// Read and update the LM35 sensor
-	uint8_t lm35_temp = LM35_ReadTemp8();
-	HYPER_CAN_Update(updateLM35, &lm35_temp);
+/**
+ * @brief This function reads the 1st VL6180X sensor's new sample
+ */
+static void UNIT_Task_Range1(void) {
+	UNIT_ReadRange(VL6180X_ID1, updateVL6180X_1, UNIT1_GROUP_VL6180X_1);
+}
+
+/**
+ * @brief This function reads the 2nd VL6180X sensor's new sample
+ */
+static void UNIT_Task_Range2(void) {
+	UNIT_ReadRange(VL6180X_ID2, updateVL6180X_2, UNIT1_GROUP_VL6180X_2);
+}
+
+/**
+ * @brief This function reads the 3rd VL6180X sensor's new sample
+ */
+static void UNIT_Task_Range3(void) {
+	UNIT_ReadRange(VL6180X_ID3, updateVL6180X_3, UNIT1_GROUP_VL6180X_3);
+}
 
-	uint8_t tmp102_Celsius;
+/**
+ * @brief This function reads the 4th VL6180X sensor's new sample
+ */
+static void UNIT_Task_Range4(void) {
+	UNIT_ReadRange(VL6180X_ID4, updateVL6180X_4, UNIT1_GROUP_VL6180X_4);
+}
 
-	//Read and update tmp102 sensor if there are new samples available
-	static uint32_t temperature_timestamp = 0;
-	if (HYPER_Delay_Check(temperature_timestamp, 125)) {
-		tmp102_Celsius = tmp102_ReadTemp();
-		HYPER_CAN_Update(updateTMP102, &tmp102_Celsius);
+/**
+ * @brief This function reads and updates the LM35 sensor
+ */
+static void UNIT_Task_LM35(void) {
+	uint16_t lm35_temp = LM35_ReadTemp16();
+	HYPER_CAN_Update(updateLM35, &lm35_temp);
+	HYPER_CAN_Stamp(UNIT1_GROUP_LM35);
+}
 
-		// Update the time stamp
-		temperature_timestamp = HYPER_Delay_GetTime();
+/**
+ * @brief This function updates the TMP102 sensor with its latest read (started on the previous run)
+ */
+static void UNIT_Task_TMP102(void) {
+	int16_t tmp102_temp;
+	uint32_t tmp102_time;
+	if(!tmp102_ReadTemp16(&tmp102_temp, &tmp102_time)) {
+		if(tmp102_IsFailed()) {
+			HYPER_CAN_Invalidate(UNIT1_GROUP_TMP102);
+			airTemperatureValid = false;
+		}
+		return;
 	}
+	HYPER_CAN_Update(updateTMP102, &tmp102_temp);
+	HYPER_CAN_StampAt(UNIT1_GROUP_TMP102, tmp102_time);
+	airTemperature = tmp102_temp;
+	airTemperatureValid = true;
+}
 
-	uint16_t Ro = tmp102_Celsius * Tube_pressure;
+/**
+ * @brief This function computes the integer square root
+ * @param value The argument
+ * @return The square root, rounded down
+ */
+static uint32_t UNIT_Sqrt(uint64_t value) {
+	uint64_t root = 0;
+	uint64_t bit = 1ULL << 62;
+	while(bit > value)
+		bit >>= 2;
+
+	while(bit) {
+		if(value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return root;
+}
 
-	//Read and update D6F_PH5050AD3 sensor if there are new samples available
-	static uint32_t pitot_timestamp = 0;
-	if (HYPER_Delay_Check(pitot_timestamp, 40)) {
+/**
+ * @brief This function computes the airspeed from the Pitot dynamic pressure, v = sqrt(2q / rho) with the air density
+ * rho = p / (R * T) of the tube pressure and the TMP102 temperature, in integer arithmetic
+ * @param pressure The dynamic pressure (in 0.1Pa)
+ * @return The airspeed (in 0.01m/s, saturated at 0xFFFF)
+ */
+static uint16_t UNIT_Airspeed(int16_t pressure) {
+	if(pressure <= 0)
+		return 0;
 
-		uint16_t pitot_press = D6F_PH5050AD3_ReadPress();
+	// T in 0.0625K, R = 287.05 J/(kg*K) in 0.01 J/(kg*K)
+	int32_t temperature = airTemperature + 4370;
+	if(temperature <= 0)
+		return 0;
 
-		//uint16_t pitot_velocity = sqrti((2*pitot_press)/Ro);
-		pitot_press = D6F_PH5050AD3_Conv_to_Pascal(pitot_press);
+	// (100v)^2 = 10^4 * 2 * (q / 10) * (R / 100) * (T / 16) / p = 5 * q * R * T / (4 * p)
+	uint64_t square = (uint64_t)pressure * 28705 * (uint32_t)temperature * 5 / (4 * (uint64_t)tubePressure);
+	uint32_t speed = UNIT_Sqrt(square);
+	return speed > 0xFFFF ? 0xFFFF : speed;
+}
 
+/**
+ * @brief This function updates the D6F_PH5050AD3 sensor with its new filtered sample (acquired in the background),
+ * and the airspeed computed from it
+ */
+static void UNIT_Task_Pitot(void) {
+	int16_t pitot_press;
+	uint32_t pitot_time;
+	if(D6F_PH5050AD3_ReadPress(&pitot_press, &pitot_time)) {
 		HYPER_CAN_Update(updatePitot, &pitot_press);
+		HYPER_CAN_StampAt(UNIT1_GROUP_PITOT, pitot_time);
 
-		//ask pitot to start another read-out
-		D6F_PH5050AD3_StartAnotherRead();
+		if(airTemperatureValid) {
+			uint16_t airspeed = UNIT_Airspeed(pitot_press);
+			HYPER_CAN_Update(updateAirspeed, &airspeed);
+			HYPER_CAN_StampAt(UNIT1_GROUP_AIRSPEED, pitot_time);
+		}
+		else {
+			HYPER_CAN_Invalidate(UNIT1_GROUP_AIRSPEED);
+		}
+	}
+	else if(D6F_PH5050AD3_IsFailed()) {
+		HYPER_CAN_Invalidate(UNIT1_GROUP_PITOT);
+		HYPER_CAN_Invalidate(UNIT1_GROUP_AIRSPEED);
+	}
+}
 
-		// Update the time stamp
-		pitot_timestamp = HYPER_Delay_GetTime();
+/**
+ * @brief This function sends the Pitot acquisition report (DIAG_PITOT)
+ */
+static void UNIT_SendPitotDiag(void) {
+	D6F_PH5050AD3_Stats_t stats;
+	D6F_PH5050AD3_GetStats(&stats);
+
+	uint8_t data[7];
+	data[0] = DIAG_PITOT;
+	data[1] = stats.samples >> 24;
+	data[2] = (stats.samples >> 16) & 0xFF;
+	data[3] = (stats.samples >> 8) & 0xFF;
+	data[4] = stats.samples & 0xFF;
+	data[5] = stats.rate >> 8;
+	data[6] = stats.rate & 0xFF;
+	HYPER_CAN_SendData(UNIT_CAN_ID_DIAG, 7, data);
+}
+
+/**
+ * @brief This function processes a received CAN message
+ * @param msg_type The message type @see MsgType_t
+ * @param msg_data The message contents
+ */
+void UNIT_CAN_ProcessFrame(MsgType_t msg_type, uint8_t *msg_data) {
+	if(msg_type == MSG_TUBEPRESSURE) {
+		uint32_t pressure = ((uint32_t)msg_data[1] << 16) | (msg_data[2] << 8) | msg_data[3];
+		if(pressure > 0)
+			tubePressure = pressure;
 	}
+	else if(msg_type == MSG_RANGECONFIG)
+		VL6180X_SetRanging(msg_data[1], msg_data[2], msg_data[3]);
+	else if(msg_type == MSG_DIAGREQUEST && (msg_data[1] == DIAG_RANGE || msg_data[1] == DIAG_RANGERATE))
+		VL6180X_SendDiag(msg_data[1], msg_data[2]);
+	else if(msg_type == MSG_DIAGREQUEST && msg_data[1] == DIAG_PITOT)
+		UNIT_SendPitotDiag();
 }
@@ -2,91 +2,144 @@
  * @file Unit2/unit_can.h
  * @author Łukasz Kilaszewski (luktor99)
  * @date 5-July-2017
- * @brief This file contains implementation of functions that update the unit's CAN output buffer.
+ * @brief This file contains implementation of functions that update the unit's CAN data record and pack it into the data frame.
  */
 
 #ifndef UNIT_CAN_H_
 #define UNIT_CAN_H_
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateVL6180X_1(unit_DataBuffer_t *buffer, void *value) {
-	buffer->vl6180xDistance1 = *(uint8_t *)value;
+void updateVL6180X_1(unit_Record_t *record, void *value) {
+	record->vl6180xDistance1 = *(uint8_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateVL6180X_2(unit_DataBuffer_t *buffer, void *value) {
-	buffer->vl6180xDistance2 = *(uint8_t *)value;
+void updateVL6180X_2(unit_Record_t *record, void *value) {
+	record->vl6180xDistance2 = *(uint8_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateVL6180X_3(unit_DataBuffer_t *buffer, void *value) {
-	buffer->vl6180xDistance3 = *(uint8_t *)value;
+void updateVL6180X_3(unit_Record_t *record, void *value) {
+	record->vl6180xDistance3 = *(uint8_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateVL6180X_4(unit_DataBuffer_t *buffer, void *value) {
-	buffer->vl6180xDistance4 = *(uint8_t *)value;
+void updateVL6180X_4(unit_Record_t *record, void *value) {
+	record->vl6180xDistance4 = *(uint8_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateLM35(unit_DataBuffer_t *buffer, void *value) {
-	buffer->lm35Temperature = *(uint8_t *)value;
+void updateLM35(unit_Record_t *record, void *value) {
+	record->lm35Temperature = *(uint16_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updatePyro(unit_DataBuffer_t *buffer, void *value) {
-	buffer->pyroTemperature = *(uint8_t *)value;
+void updatePyro(unit_Record_t *record, void *value) {
+	record->pyroTemperature = *(uint16_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateTCouple(unit_DataBuffer_t *buffer, void *value) {
-	buffer->tCoupleTemperature = *(uint8_t *)value;
+void updatePyro2(unit_Record_t *record, void *value) {
+	record->pyroTemperature2 = *(uint16_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateVoltage12V(unit_DataBuffer_t *buffer, void *value) {
-	buffer->voltage12V = *(uint8_t *)value;
+void updatePyroAmbient(unit_Record_t *record, void *value) {
+	record->pyroAmbient = *(uint16_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateBrakes(unit_DataBuffer_t *buffer, void *value) {
-	buffer->brakesState = *(uint8_t *)value;
+void updateTCouple(unit_Record_t *record, void *value) {
+	record->tCoupleTemperature = *(uint16_t *)value;
+}
+
+/**
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
+ * @param value Pointer to the new data
+ */
+void updateVoltage12V(unit_Record_t *record, void *value) {
+	record->voltage12V = *(uint16_t *)value;
+}
+
+/**
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
+ * @param value Pointer to the new data
+ */
+void updateBrakes(unit_Record_t *record, void *value) {
+	record->brakesState = *(uint8_t *)value;
+}
+
+/**
+ * @brief This function converts a raw MLX90614 reading to the data frame format
+ * @param raw Temperature expressed in 0.02K
+ * @return Temperature expressed in °C (Possible range: 0..255)
+ */
+static uint8_t packPyro(uint16_t raw) {
+	int32_t temp = ((int32_t)raw * 2 - 27315) / 100;
+	if(temp >= 255)
+		return 255;
+	else if(temp <= 0)
+		return 0;
+
+	return (uint8_t)temp;
+}
+
+/**
+ * @brief This function packs the data record into the (single frame) data buffer
+ * @param record Pointer to the data record structure
+ * @param buffer Pointer to the CAN buffer structure
+ */
+void UNIT_CAN_Pack(const unit_Record_t *record, unit_DataBuffer_t *buffer) {
+	buffer->vl6180xDistance1 = record->vl6180xDistance1;
+	buffer->vl6180xDistance2 = record->vl6180xDistance2;
+	buffer->vl6180xDistance3 = record->vl6180xDistance3;
+	buffer->vl6180xDistance4 = record->vl6180xDistance4;
+	buffer->pyroTemperature = packPyro(record->pyroTemperature);
+	// °C, the field is 7 bits wide
+	buffer->lm35Temperature = (record->lm35Temperature / 10 > 127) ? 127 : record->lm35Temperature / 10;
+	buffer->brakesState = record->brakesState;
+	// °C, 0 if the thermocouple is open or the reading is out of range
+	buffer->tCoupleTemperature = (record->tCoupleTemperature / 4 > 255) ? 0 : record->tCoupleTemperature / 4;
+	// 0.1V
+	buffer->voltage12V = (record->voltage12V / 100 > 255) ? 255 : record->voltage12V / 100;
 }
 
 #endif /* UNIT_CAN_H_ */
@@ -51,10 +51,10 @@ void MAX6675_Init(void) {
 }
 
 /**
- * @brief This function performs a single reading of the temperature
- * @return Temperature expressed in °C (eg. 123 = 123°C) (Possible range: 0..255)
+ * @brief This function reads the raw 16-bit word from the MAX6675
+ * @return Raw data word
  */
-uint8_t MAX6675_ReadTemp(void) {
+static uint16_t MAX6675_ReadRaw(void) {
 	// Set NSS LOW
 	GPIOB->BRR = GPIO_Pin_12;
 
@@ -68,6 +68,31 @@ uint8_t MAX6675_ReadTemp(void) {
 	// Set NSS HIGH
 	GPIOB->BSRR = GPIO_Pin_12;
 
+	return data;
+}
+
+/**
+ * @brief This function performs a single reading of the temperature with full resolution
+ * @return Temperature expressed in 0.25°C (eg. 493 = 123.25°C), MAX6675_OPEN if the thermocouple is open
+ */
+uint16_t MAX6675_ReadTemp16(void) {
+	uint16_t data = MAX6675_ReadRaw();
+
+	// Open thermocouple detection
+	if(data & 0x4)
+		return MAX6675_OPEN;
+
+	// Retrieve temperature in 0..1023.75°C range
+	return (data >> 3) & 0xFFF;
+}
+
+/**
+ * @brief This function performs a single reading of the temperature
+ * @return Temperature expressed in °C (eg. 123 = 123°C) (Possible range: 0..255)
+ */
+uint8_t MAX6675_ReadTemp(void) {
+	uint16_t data = MAX6675_ReadRaw();
+
 	// Open thermocouple detection
 	if(data & 0x4)
 		return 0;
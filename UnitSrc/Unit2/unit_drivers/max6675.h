@@ -8,7 +8,10 @@
 #ifndef UNIT_DRIVERS_MAX6675_H_
 #define UNIT_DRIVERS_MAX6675_H_
 
+#define MAX6675_OPEN 0xFFFF /**< Reading returned when the thermocouple is open */
+
 void MAX6675_Init(void);
 uint8_t MAX6675_ReadTemp(void);
+uint16_t MAX6675_ReadTemp16(void);
 
 #endif /* UNIT_DRIVERS_MAX6675_H_ */
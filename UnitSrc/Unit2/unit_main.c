@@ -2,11 +2,12 @@
  * @file Unit2/unit_main.c
  * @author Łukasz Kilaszewski (luktor99)
  * @date 4-July-2017
- * @brief This file contains implementation of the main functions (UNIT_Init() and UNIT_Loop()), which are specific to each of the units.
+ * @brief This file contains implementation of the unit's initialization (UNIT_Init()) and its scheduled tasks, which are specific to each of the units.
  */
 
 #include "unit.h"
 #include "hyper.h"
+#include "hyper_unit_defs.h"
 #include "unit_can.h"
 #include "shared_drivers/lm35.h"
 #include "shared_drivers/vl6180x.h"
@@ -15,6 +16,42 @@
 #include "shared_drivers/voltmeter.h"
 #include "shared_drivers/brakes.h"
 
+static void UNIT_Task_Range1(void);
+static void UNIT_Task_Range2(void);
+static void UNIT_Task_Range3(void);
+static void UNIT_Task_Range4(void);
+static void UNIT_Task_Pyro(void);
+static void UNIT_Task_TCouple(void);
+static void UNIT_Task_Voltage(void);
+static void UNIT_Task_LM35(void);
+static void UNIT_Task_Brakes(void);
+
+/**
+ * @brief The unit's tasks. VL6180X sensors signal their samples through interrupts, so they (and their ranging scheduler) are checked on every pass (the samples are fetched in the background).
+ * MAX6675 needs up to 220ms per conversion.
+ */
+static const HYPER_Sched_Task_t unitTasks[] = {
+	// run					period	offset	priority	deadline
+	{UNIT_Task_Brakes,		0,		0,		0,			0},
+	{UNIT_Task_Range1,		0,		0,		1,			0},
+	{UNIT_Task_Range2,		0,		0,		1,			0},
+	{UNIT_Task_Range3,		0,		0,		1,			0},
+	{UNIT_Task_Range4,		0,		0,		1,			0},
+	{VL6180X_Tick,			0,		0,		1,			0},
+	{UNIT_Task_Voltage,		50,		7,		2,			0},
+	{UNIT_Task_Pyro,		10,		11,		2,			0},
+	{UNIT_Task_LM35,		100,	13,		3,			0},
+	{UNIT_Task_TCouple,		250,	17,		3,			0},
+};
+
+/**
+ * @brief The unit's initialization steps, completed in the background (@see hyper_boot.h)
+ */
+static const HYPER_Boot_Step_t unitBootSteps[] = {
+	Brakes_InitTick,
+	VL6180X_InitTick,
+};
+
 /**
  * @brief This function performs initialization of the peripherals specific to the unit.
  */
@@ -23,59 +60,114 @@ void UNIT_Init(void) {
 	LM35_Init();
 
 	VL6180X_Init();
-	VL6180X_InitSensor(VL6180X_ID1);
-	VL6180X_InitSensor(VL6180X_ID2);
-	VL6180X_InitSensor(VL6180X_ID3);
-	VL6180X_InitSensor(VL6180X_ID4);
 
 	MLX90614_Init();
 	MAX6675_Init();
 	Voltmeter_Init();
+
+	HYPER_Sched_Init(unitTasks, sizeof(unitTasks) / sizeof(unitTasks[0]));
+	HYPER_Boot_Init(unitBootSteps, sizeof(unitBootSteps) / sizeof(unitBootSteps[0]));
 }
 
 /**
- * @brief This function is run in an infinite loop. This is where outgoing data gets updated.
+ * @brief This function reads and updates a VL6180X sensor if there is a new sample available, invalidates it if the sensor stopped responding
+ * @param sensor_id The sensor ID
+ * @param update The record update function
+ * @param group The sensor's channel group
  */
-inline void UNIT_Loop(void) {
-	// Read and update VL6180X sensors if there are new samples available
-	if(VL6180X_IsSampleReady(VL6180X_ID1)) {
-		uint8_t range1 = VL6180X_GetRange(VL6180X_ID1);
-		HYPER_CAN_Update(updateVL6180X_1, &range1);
-	}
-	if(VL6180X_IsSampleReady(VL6180X_ID2)) {
-		uint8_t range2 = VL6180X_GetRange(VL6180X_ID2);
-		HYPER_CAN_Update(updateVL6180X_2, &range2);
+static void UNIT_ReadRange(uint8_t sensor_id, void (*update)(unit_Record_t *, void *), uint8_t group) {
+	uint8_t range;
+	if(VL6180X_ReadRange(sensor_id, &range)) {
+		HYPER_CAN_Update(update, &range);
+		HYPER_CAN_Stamp(group);
 	}
-	if(VL6180X_IsSampleReady(VL6180X_ID3)) {
-		uint8_t range3 = VL6180X_GetRange(VL6180X_ID3);
-		HYPER_CAN_Update(updateVL6180X_3, &range3);
-	}
-	if(VL6180X_IsSampleReady(VL6180X_ID4)) {
-		uint8_t range4 = VL6180X_GetRange(VL6180X_ID4);
-		HYPER_CAN_Update(updateVL6180X_4, &range4);
+	else if(VL6180X_IsFailed(sensor_id)) {
+		HYPER_CAN_Invalidate(group);
 	}
+}
 
-	// Read and update the pyrometer sensor
-	uint8_t pyro_temp = MLX90614_readTemp();
-	HYPER_CAN_Update(updatePyro, &pyro_temp);
+/**
+ * @brief This function reads the 1st VL6180X sensor's new sample
+ */
+static void UNIT_Task_Range1(void) {
+	UNIT_ReadRange(VL6180X_ID1, updateVL6180X_1, UNIT2_GROUP_VL6180X_1);
+}
+
+/**
+ * @brief This function reads the 2nd VL6180X sensor's new sample
+ */
+static void UNIT_Task_Range2(void) {
+	UNIT_ReadRange(VL6180X_ID2, updateVL6180X_2, UNIT2_GROUP_VL6180X_2);
+}
+
+/**
+ * @brief This function reads the 3rd VL6180X sensor's new sample
+ */
+static void UNIT_Task_Range3(void) {
+	UNIT_ReadRange(VL6180X_ID3, updateVL6180X_3, UNIT2_GROUP_VL6180X_3);
+}
 
-	// Read and update the thermocouple sensor (every 250ms)
-	static uint32_t tcouple_timestamp = 0;
-	if(HYPER_Delay_Check(tcouple_timestamp, 250)) {
-		uint8_t tcouple_temp = MAX6675_ReadTemp();
-		HYPER_CAN_Update(updateTCouple, &tcouple_temp);
+/**
+ * @brief This function reads the 4th VL6180X sensor's new sample
+ */
+static void UNIT_Task_Range4(void) {
+	UNIT_ReadRange(VL6180X_ID4, updateVL6180X_4, UNIT2_GROUP_VL6180X_4);
+}
 
-		// Update the time stamp
-		tcouple_timestamp = HYPER_Delay_GetTime();
+/**
+ * @brief This function updates the pyrometer sensor with its latest reading (the driver paces the reads to the sensor's refresh rate)
+ */
+static void UNIT_Task_Pyro(void) {
+	MLX90614_Reading_t pyro;
+	if(!MLX90614_Read(&pyro)) {
+		if(MLX90614_IsFailed())
+			HYPER_CAN_Invalidate(UNIT2_GROUP_PYRO);
+		return;
 	}
+	if(pyro.valid & MLX90614_VALID_AMBIENT)
+		HYPER_CAN_Update(updatePyroAmbient, &pyro.ambient);
+	if(pyro.valid & MLX90614_VALID_OBJECT2)
+		HYPER_CAN_Update(updatePyro2, &pyro.object2);
+	// The group's age follows the main (zone 1) temperature
+	if(pyro.valid & MLX90614_VALID_OBJECT1) {
+		HYPER_CAN_Update(updatePyro, &pyro.object1);
+		HYPER_CAN_StampAt(UNIT2_GROUP_PYRO, pyro.time);
+	}
+}
 
-	// Read and update the 12V rail voltage
-	uint8_t voltage12v = Voltmeter_Read();
+/**
+ * @brief This function reads and updates the thermocouple sensor
+ */
+static void UNIT_Task_TCouple(void) {
+	uint16_t tcouple_temp = MAX6675_ReadTemp16();
+	HYPER_CAN_Update(updateTCouple, &tcouple_temp);
+	HYPER_CAN_Stamp(UNIT2_GROUP_TCOUPLE);
+}
+
+/**
+ * @brief This function reads and updates the 12V rail voltage
+ */
+static void UNIT_Task_Voltage(void) {
+	uint16_t voltage12v = Voltmeter_ReadMillivolts();
 	HYPER_CAN_Update(updateVoltage12V, &voltage12v);
+	HYPER_CAN_Stamp(UNIT2_GROUP_VOLTAGE12V);
+}
 
-	// Read and update the LM35 sensor
-	uint8_t lm35_temp = LM35_ReadTemp8();
+/**
+ * @brief This function reads and updates the LM35 sensor
+ */
+static void UNIT_Task_LM35(void) {
+	uint16_t lm35_temp = LM35_ReadTemp16();
 	HYPER_CAN_Update(updateLM35, &lm35_temp);
+	HYPER_CAN_Stamp(UNIT2_GROUP_LM35);
+}
+
+/**
+ * @brief This function updates the brakes state (it may change in the CAN interrupt)
+ */
+static void UNIT_Task_Brakes(void) {
+	uint8_t brakes_state = Brakes_IsHolding();
+	HYPER_CAN_Update(updateBrakes, &brakes_state);
 }
 
 /**
@@ -90,4 +182,8 @@ void UNIT_CAN_ProcessFrame(MsgType_t msg_type, uint8_t *msg_data) {
 		Brakes_Release();
 	else if(msg_type == MSG_BRAKESPOWEROFF)
 		Brakes_PowerOff();
+	else if(msg_type == MSG_RANGECONFIG)
+		VL6180X_SetRanging(msg_data[1], msg_data[2], msg_data[3]);
+	else if(msg_type == MSG_DIAGREQUEST && (msg_data[1] == DIAG_RANGE || msg_data[1] == DIAG_RANGERATE))
+		VL6180X_SendDiag(msg_data[1], msg_data[2]);
 }
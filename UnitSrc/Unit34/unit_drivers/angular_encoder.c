@@ -7,6 +7,9 @@
 
 #include "stm32f10x.h"
 #include "angular_encoder.h"
+#include "hyper_utils.h"
+#include "hyper_settings.h"
+#include "hyper_trace.h"
 
 #define Enk_ch1		GPIO_Pin_6 		/**< The GPIO pin connected to the angular encoder ch1 input */
 #define Enk_ch2		GPIO_Pin_7 		/**< The GPIO pin connected to the angular encoder ch2 input */
@@ -43,10 +46,9 @@ void AngularEncoder_Init() {
 
 	/* NVIC configuration */
 	NVIC_InitTypeDef NVIC_InitStructure;
-	NVIC_PriorityGroupConfig(NVIC_PriorityGroup_1);
 
 	NVIC_InitStructure.NVIC_IRQChannel = TIM3_IRQn;
-	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1; //najwyzszy priorytet
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = HYPER_IRQ_PRIORITY_ENCODER; // @see hyper_settings.h
 	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
 	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
 	NVIC_Init(&NVIC_InitStructure);
@@ -62,12 +64,19 @@ volatile uint32_t time_new = 0;
 volatile uint32_t time_old = 0;
 
 void TIM3_IRQHandler() {
+	uint32_t entry = HYPER_Trace_Enter();
 
-	time_new = SysTick->VAL;
+	time_new = HYPER_Cycles_Get();
 
-	velocity = (40/(time_new - time_old))*1000;  // distance subtract by time difference
+	// distance subtract by time difference (40 per wheel cycle, per second)
+	uint32_t period_us = HYPER_Cycles_ToMicros(time_new - time_old);
+	if(period_us > 0) {
+		uint32_t speed = 40000000 / period_us;
+		velocity = speed > 0xFFFF ? 0xFFFF : speed;
+	}
 
 	time_old = time_new;
+	HYPER_Trace_Exit(TRACE_ENCODER, entry);
 }
 
 /**
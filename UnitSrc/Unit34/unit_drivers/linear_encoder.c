@@ -23,12 +23,20 @@
 
 #define MIN_THRESHOLD 8
 
+#define CALIB_SETTLE_TIME	200		/**< The time the sensor's output needs to settle before the calibration (in ms) */
+#define CALIB_SAMPLES		500		/**< The amount of samples averaged by the calibration (taken 1 ms apart) */
+
 static volatile uint16_t buforADC[3]={0};
 uint32_t counter = 0;
 
 static uint16_t calib = 0;
 static uint16_t max = 0;
 
+static bool calibrated = false;
+static uint16_t calibSamples = 0;
+static uint32_t calibAcc = 0;
+static uint32_t calibTimestamp = 0;
+
 static volatile float value = 0.0f;
 
 const float alpha = 0.001f;
@@ -37,23 +45,45 @@ static float lowPassFrequency(float input, float previous);
 static void ADC_unit3i4_Init();
 
 /**
- * @brief This function performs initialization of the peripherals required to drive the linear encoder
+ * @brief This function performs initialization of the peripherals required to drive the linear encoder.
+ * The calibration is done afterwards by LinearEncoder_InitTick().
  */
 void LinearEncoder_Init() {
 	ADC_unit3i4_Init();
 
-	// Calibrate the encoder
-	HYPER_Delay(200);
-	uint32_t acc = 0;
-	for(uint16_t i = 0; i < 500; ++i) {
-		ADC_SoftwareStartConvCmd(ADC1, ENABLE);
-		while(ADC_GetFlagStatus(ADC1, ADC_FLAG_EOC) != SET);
-		acc += ADC_GetConversionValue(ADC1);
-		HYPER_Delay(1);
+	calibrated = false;
+	calibSamples = 0;
+	calibAcc = 0;
+	calibTimestamp = HYPER_Delay_GetTime();
+}
+
+/**
+ * @brief This function calibrates the encoder without blocking (one sample per ms, after the output settles).
+ * It should be run until it returns true (@see hyper_boot.h).
+ * @return true once the encoder is calibrated, false otherwise
+ */
+bool LinearEncoder_InitTick() {
+	if(calibrated)
+		return true;
+
+	if(calibSamples == 0) {
+		if(!HYPER_Delay_Check(calibTimestamp, CALIB_SETTLE_TIME))
+			return false;
 	}
+	else if(!HYPER_Delay_Check(calibTimestamp, 1))
+		return false;
+	calibTimestamp = HYPER_Delay_GetTime();
 
-	calib = acc / 500;
+	ADC_SoftwareStartConvCmd(ADC1, ENABLE);
+	while(ADC_GetFlagStatus(ADC1, ADC_FLAG_EOC) != SET);
+	calibAcc += ADC_GetConversionValue(ADC1);
+	if(++calibSamples < CALIB_SAMPLES)
+		return false;
+
+	calib = calibAcc / CALIB_SAMPLES;
 	max = calib + MIN_THRESHOLD;
+	calibrated = true;
+	return true;
 }
 
 /**
@@ -97,6 +127,10 @@ static float lowPassFrequency(float input, float previous){
 uint32_t LinearEncoder_Read() {
 	static bool strip_detected = false;
 
+	// The strips can't be told apart from the background before the calibration
+	if(!calibrated)
+		return counter;
+
 	ADC_SoftwareStartConvCmd(ADC1, ENABLE);
 	while(ADC_GetFlagStatus(ADC1, ADC_FLAG_EOC) != SET);
 	uint16_t adc_result = ADC_GetConversionValue(ADC1);
@@ -8,7 +8,10 @@
 #ifndef UNIT_DRIVERS_LINEAR_ENCODER_H_
 #define UNIT_DRIVERS_LINEAR_ENCODER_H_
 
+#include <stdbool.h>
+
 void LinearEncoder_Init();
+bool LinearEncoder_InitTick();
 uint32_t LinearEncoder_Read();
 
 #endif /* UNIT_DRIVERS_LINEAR_ENCODER_H_ */
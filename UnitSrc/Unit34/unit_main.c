@@ -3,7 +3,7 @@
  * @author Ĺ�ukasz Kilaszewski (luktor99)
  * @author Serafin Bachman
  * @date 4-July-2017
- * @brief This file contains implementation of the main functions (UNIT_Init() and UNIT_Loop()), which are specific to each of the units.
+ * @brief This file contains implementation of the unit's initialization (UNIT_Init()) and its scheduled tasks, which are specific to each of the units.
  */
 
 #include "unit.h"
@@ -12,21 +12,43 @@
 #include "unit_drivers/angular_encoder.h"
 #include "unit_drivers/linear_encoder.h"
 
+static void UNIT_Task_Encoders(void);
+
+/**
+ * @brief The unit's tasks
+ */
+static const HYPER_Sched_Task_t unitTasks[] = {
+	// run					period	offset	priority	deadline
+	{UNIT_Task_Encoders,	1,		0,		0,			0},
+};
+
+/**
+ * @brief The unit's initialization steps, completed in the background (@see hyper_boot.h)
+ */
+static const HYPER_Boot_Step_t unitBootSteps[] = {
+	LinearEncoder_InitTick,
+};
+
 /**
  * @brief This function performs initialization of the peripherals specific to the unit.
  */
 void UNIT_Init(void) {
 	LinearEncoder_Init();
 	AngularEncoder_Init();
+
+	HYPER_Sched_Init(unitTasks, sizeof(unitTasks) / sizeof(unitTasks[0]));
+	HYPER_Boot_Init(unitBootSteps, sizeof(unitBootSteps) / sizeof(unitBootSteps[0]));
 }
 
 /**
- * @brief This function is run in an infinite loop. This is where outgoing data gets updated.
+ * @brief This function reads and updates both encoders
  */
-inline void UNIT_Loop(void) {
+static void UNIT_Task_Encoders(void) {
 	int32_t angular_enc = 514;//AngularEncoder_GetPos();
 	HYPER_CAN_Update(updateEnkoder, &angular_enc);
+	HYPER_CAN_Stamp(UNIT3_GROUP_ENCODER);
 
 	uint32_t linear_enc = LinearEncoder_Read();
 	HYPER_CAN_Update(updatePaski, &linear_enc);
+	HYPER_CAN_Stamp(UNIT3_GROUP_STRIPES);
 }
@@ -2,83 +2,136 @@
  * @file Unit5/unit_can.h
  * @author Ĺ�ukasz Kilaszewski (luktor99)
  * @date 5-July-2017
- * @brief This file contains implementation of functions that update the unit's CAN output buffer.
+ * @brief This file contains implementation of functions that update the unit's CAN data record and pack it into the data frame.
  */
 
 #ifndef UNIT_CAN_H_
 #define UNIT_CAN_H_
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateVL6180X_1(unit_DataBuffer_t *buffer, void *value) {
-	buffer->vl6180xDistance1 = *(uint8_t *)value;
+void updateVL6180X_1(unit_Record_t *record, void *value) {
+	record->vl6180xDistance1 = *(uint8_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateVL6180X_2(unit_DataBuffer_t *buffer, void *value) {
-	buffer->vl6180xDistance2 = *(uint8_t *)value;
+void updateVL6180X_2(unit_Record_t *record, void *value) {
+	record->vl6180xDistance2 = *(uint8_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateVL6180X_3(unit_DataBuffer_t *buffer, void *value) {
-	buffer->vl6180xDistance3 = *(uint8_t *)value;
+void updateVL6180X_3(unit_Record_t *record, void *value) {
+	record->vl6180xDistance3 = *(uint8_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateVL6180X_4(unit_DataBuffer_t *buffer, void *value) {
-	buffer->vl6180xDistance4 = *(uint8_t *)value;
+void updateVL6180X_4(unit_Record_t *record, void *value) {
+	record->vl6180xDistance4 = *(uint8_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updatePyro(unit_DataBuffer_t *buffer, void *value) {
-	buffer->pyroTemperature = *(uint8_t *)value;
+void updatePyro(unit_Record_t *record, void *value) {
+	record->pyroTemperature = *(uint16_t *)value;
 }
 
+/**
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
+ * @param value Pointer to the new data
+ */
+void updatePyro2(unit_Record_t *record, void *value) {
+	record->pyroTemperature2 = *(uint16_t *)value;
+}
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateVoltage12V(unit_DataBuffer_t *buffer, void *value) {
-	buffer->voltage12V = *(uint8_t *)value;
+void updatePyroAmbient(unit_Record_t *record, void *value) {
+	record->pyroAmbient = *(uint16_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateCurrent(unit_DataBuffer_t *buffer, void *value) {
-	buffer->current = *(uint8_t *)value;
+void updateVoltage12V(unit_Record_t *record, void *value) {
+	record->voltage12V = *(uint16_t *)value;
 }
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateBatteryVoltage(unit_DataBuffer_t *buffer, void *value) {
-	buffer->voltageBattery = *(uint8_t *)value;
+void updateCurrent(unit_Record_t *record, void *value) {
+	record->current = *(int16_t *)value;
+}
+
+/**
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
+ * @param value Pointer to the new data
+ */
+void updateBatteryVoltage(unit_Record_t *record, void *value) {
+	record->voltageBattery = *(uint16_t *)value;
+}
+
+/**
+ * @brief This function converts a raw MLX90614 reading to the data frame format
+ * @param raw Temperature expressed in 0.02K
+ * @return Temperature expressed in °C (Possible range: 0..255)
+ */
+static uint8_t packPyro(uint16_t raw) {
+	int32_t temp = ((int32_t)raw * 2 - 27315) / 100;
+	if(temp >= 255)
+		return 255;
+	else if(temp <= 0)
+		return 0;
+
+	return (uint8_t)temp;
+}
+
+/**
+ * @brief This function packs the data record into the (single frame) data buffer
+ * @param record Pointer to the data record structure
+ * @param buffer Pointer to the CAN buffer structure
+ */
+void UNIT_CAN_Pack(const unit_Record_t *record, unit_DataBuffer_t *buffer) {
+	buffer->vl6180xDistance1 = record->vl6180xDistance1;
+	buffer->vl6180xDistance2 = record->vl6180xDistance2;
+	buffer->vl6180xDistance3 = record->vl6180xDistance3;
+	buffer->vl6180xDistance4 = record->vl6180xDistance4;
+	buffer->pyroTemperature = packPyro(record->pyroTemperature);
+	// 0.1V
+	buffer->voltage12V = (record->voltage12V / 100 > 255) ? 255 : record->voltage12V / 100;
+	buffer->voltageBattery = (record->voltageBattery / 100 > 255) ? 255 : record->voltageBattery / 100;
+	// 0.1A, negative currents are not representable
+	if(record->current < 0)
+		buffer->current = 0;
+	else
+		buffer->current = (record->current / 10 > 255) ? 255 : record->current / 10;
 }
 
 #endif /* UNIT_CAN_H_ */
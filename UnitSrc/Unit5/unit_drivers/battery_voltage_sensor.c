@@ -27,12 +27,31 @@ void VoltageSensor_Init(void) {
 
 /**
  * @brief This function performs a single conversion of the ADC channel connected to the pod Battery voltage sensor
+ * @return Raw ADC reading
  */
-uint8_t VoltageSensor_Read(void) {
+static uint16_t VoltageSensor_ReadADC(void) {
 	ADC_RegularChannelConfig(ADC1, ADC_Channel_2, 1, ADC_SampleTime_55Cycles5);
 	ADC_SoftwareStartConvCmd(ADC1, ENABLE);
 	while(ADC_GetFlagStatus(ADC1, ADC_FLAG_EOC) != SET);
-	uint16_t adc_result = ADC_GetConversionValue(ADC1);
+	return ADC_GetConversionValue(ADC1);
+}
+
+/**
+ * @brief This function reads the pod Battery voltage
+ * @return Voltage reading in 0..255 range (eg. 89 = 8.9V)
+ */
+uint8_t VoltageSensor_Read(void) {
+	uint16_t adc_result = VoltageSensor_ReadADC();
 
 	return adc_result * 33 * (R1+R2) / R2 / 4095;
 }
+
+/**
+ * @brief This function reads the pod Battery voltage with full resolution
+ * @return Voltage reading in mV (eg. 12034 = 12.034V)
+ */
+uint16_t VoltageSensor_ReadMillivolts(void) {
+	uint16_t adc_result = VoltageSensor_ReadADC();
+
+	return (uint32_t)adc_result * 3300 / 4095 * (R1+R2) / R2;
+}
@@ -13,5 +13,6 @@
 
 void VoltageSensor_Init(void);
 uint8_t VoltageSensor_Read(void);
+uint16_t VoltageSensor_ReadMillivolts(void);
 
 #endif /* Voltage_SENSOR_H_ */
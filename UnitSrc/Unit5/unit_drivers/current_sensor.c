@@ -35,3 +35,17 @@ uint8_t CurrentSensor_Read(void) {
     	return 255;
 	return (uint8_t)current;
 }
+
+/**
+ * @brief This function reads the current sensor with full resolution
+ * @return Current reading in 0.01A (eg. -1234 = -12.34A)
+ */
+int16_t CurrentSensor_Read16(void) {
+	ADC_RegularChannelConfig(ADC1, ADC_Channel_3, 1, ADC_SampleTime_55Cycles5);
+	ADC_SoftwareStartConvCmd(ADC1, ENABLE);
+	while(ADC_GetFlagStatus(ADC1, ADC_FLAG_EOC) != SET);
+
+	// 28mV/A around the 3032 zero point
+	int32_t adc_offset = (int32_t)ADC_GetConversionValue(ADC1) - 3032;
+	return adc_offset * 330000 / 28 / 4095;
+}
@@ -13,5 +13,6 @@
 
 void CurrentSensor_Init(void);
 uint8_t CurrentSensor_Read(void);
+int16_t CurrentSensor_Read16(void);
 
 #endif /* UNIT_DRIVERS_CURRENT_SENSOR_H_ */
@@ -2,19 +2,37 @@
  * @file Unit6/unit_can.h
  * @author Łukasz Kilaszewski (luktor99)
  * @date 5-July-2017
- * @brief This file contains implementation of functions that update the unit's CAN output buffer.
+ * @brief This file contains implementation of functions that update the unit's CAN data record and pack it into the data frame.
  */
 
 #ifndef UNIT_CAN_H_
 #define UNIT_CAN_H_
 
 /**
- * @brief This function updates the CAN data buffer
- * @param buffer Pointer to the CAN buffer structure
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
+ * @param value Pointer to the new data
+ */
+void updateBrakes(unit_Record_t *record, void *value) {
+	record->brakesState = *(uint8_t *)value;
+}
+
+/**
+ * @brief This function updates the data record
+ * @param record Pointer to the data record structure
  * @param value Pointer to the new data
  */
-void updateBrakes(unit_DataBuffer_t *buffer, void *value) {
-	buffer->brakesState = *(uint8_t *)value;
+void updateBrakesLock(unit_Record_t *record, void *value) {
+	record->brakesLocked = *(uint8_t *)value;
+}
+
+/**
+ * @brief This function packs the data record into the (single frame) data buffer
+ * @param record Pointer to the data record structure
+ * @param buffer Pointer to the CAN buffer structure
+ */
+void UNIT_CAN_Pack(const unit_Record_t *record, unit_DataBuffer_t *buffer) {
+	buffer->brakesState = record->brakesState;
 }
 
 #endif /* UNIT_CAN_H_ */
@@ -2,7 +2,7 @@
  * @file Unit6/unit_main.c
  * @author Łukasz Kilaszewski (luktor99)
  * @date 4-July-2017
- * @brief This file contains implementation of the main functions (UNIT_Init() and UNIT_Loop()), which are specific to each of the units.
+ * @brief This file contains implementation of the unit's initialization (UNIT_Init()) and its scheduled tasks, which are specific to each of the units.
  */
 
 #include "unit.h"
@@ -12,6 +12,24 @@
 #include "unit_drivers/power.h"
 #include "watchdog.h"
 
+static void UNIT_Task_Brakes(void);
+
+/**
+ * @brief The unit's tasks. The brakes watchdog runs on every pass.
+ */
+static const HYPER_Sched_Task_t unitTasks[] = {
+	// run					period	offset	priority	deadline
+	{Watchdog_Tick,			0,		0,		0,			0},
+	{UNIT_Task_Brakes,		0,		0,		1,			0},
+};
+
+/**
+ * @brief The unit's initialization steps, completed in the background (@see hyper_boot.h)
+ */
+static const HYPER_Boot_Step_t unitBootSteps[] = {
+	Brakes_InitTick,
+};
+
 /**
  * @brief This function performs initialization of the peripherals specific to the unit.
  */
@@ -19,13 +37,21 @@ void UNIT_Init(void) {
 	Brakes_Init();
 	Power_Init();
 	Watchdog_Init();
+
+	HYPER_Sched_Init(unitTasks, sizeof(unitTasks) / sizeof(unitTasks[0]));
+	HYPER_Boot_Init(unitBootSteps, sizeof(unitBootSteps) / sizeof(unitBootSteps[0]));
 }
 
 /**
- * @brief This function is run in an infinite loop. This is where outgoing data gets updated.
+ * @brief This function updates the brakes state and their lock state (they may change in the CAN and buttons interrupts)
  */
-inline void UNIT_Loop(void) {
-	Watchdog_Tick();
+static void UNIT_Task_Brakes(void) {
+	uint8_t brakes_state = Brakes_IsHolding();
+	HYPER_CAN_Update(updateBrakes, &brakes_state);
+
+	uint8_t brakes_locked = Watchdog_IsLocked();
+	HYPER_CAN_Update(updateBrakesLock, &brakes_locked);
+	HYPER_CAN_Stamp(UNIT6_GROUP_BRAKES);
 }
 
 /**
@@ -9,6 +9,7 @@
 #define UNITSRC_UNIT6_WATCHDOG_H_
 
 #include <stdbool.h>
+#include "stm32f10x.h"
 #include "hyper.h"
 #include "hyper_settings.h"
 #include "shared_drivers/brakes.h"
@@ -17,7 +18,7 @@
 /**
  * @brief The timestamp of the latest reset
  */
-static uint32_t lastResetTimestamp;
+static volatile uint32_t lastResetTimestamp;
 
 /**
  * @brief The watchdog's state (ON/OFF)
@@ -27,15 +28,15 @@ static bool watchdogON = false;
 /**
  * @brief The timestamp of the latest lock update event
  */
-static uint32_t lastLockTimestamp = 0;
+static volatile uint32_t lastLockTimestamp = 0;
 /**
  * @brief The duration time of the latest brakes lock
  */
-static uint16_t lockTime = 0;
+static volatile uint16_t lockTime = 0;
 /**
- * @brief Lock active flag
+ * @brief Lock active flag (set from the CAN RX interrupt)
  */
-static bool locked = false;
+static volatile bool locked = false;
 
 void Watchdog_Init(void);
 void Watchdog_Tick(void);
@@ -56,6 +57,8 @@ void Watchdog_Init(void) {
  * @brief This function takes appropriate actions if the watchdog has overflowed. It should be run as often as possible.
  */
 void Watchdog_Tick(void) {
+	// The lock updates and the brake commands arrive in the CAN RX interrupt, a new lock must not be lost
+	__disable_irq();
 	if(locked) {
 		if(HYPER_Delay_Check(lastLockTimestamp, lockTime)) {
 			// Start / allow braking
@@ -65,6 +68,7 @@ void Watchdog_Tick(void) {
 			locked = 0;
 		}
 	}
+	__enable_irq();
 
 	if(!watchdogON) {
 		return;
@@ -2,7 +2,7 @@
  * @file unit.h
  * @author Łukasz Kilaszewski (luktor99)
  * @date 4-July-2017
- * @brief This file contains unit's initialization and main loop functions' headers
+ * @brief This file contains unit's initialization function header (the unit's work is done by its scheduled tasks, @see hyper_sched.h)
  */
 
 
@@ -10,6 +10,5 @@
 #define UNIT_H_
 
 void UNIT_Init(void);
-void UNIT_Loop(void);
 
 #endif /* UNIT_H_ */